@@ -0,0 +1,1256 @@
+//
+// Command buffer generation microbenchmarks.
+//
+// Every case emits one kernel operation with fixed, valid parameters over
+// and over and reports commands and descriptors per second, together with
+// acquire_cmdbuf, dmabuf_size/dmabuf_convert and VLC throughput. Results are
+// written as JSON for regression tracking:
+//
+//   cvk_bench [--chip NAME] [--filter SUBSTR] [--min-time SEC] [--json FILE]
+//
+// Kernel diagnostics go to stdout, use --json to keep the results apart.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cvikernel/cvikernel.h"
+#include "cvikernel/cvk_vlc_compress.h"
+#include "bmkernel/bm_kernel.h"
+
+#define BENCH_CMDBUF_SIZE   (32 << 20)
+#define BENCH_BATCH         256     // commands between acquire/reset
+#define BENCH_GMEM_BASE     0x100000
+
+typedef struct {
+  cvk_context_t *ctx;
+  uint8_t *cmdbuf;          // NULL for growable contexts
+
+  // int8 tensors of the same shape
+  cvk_tl_t *a, *b, *c, *d, *e, *f;
+  // bf16 tensors of the same shape
+  cvk_tl_t *fa, *fb, *fc;
+
+  // convolution and pooling
+  cvk_tl_t *ifmap, *ofmap, *weight, *bias, *chl_quan;
+  cvk_tl_t *dw_weight, *dw_chl_quan;
+  cvk_tl_t *ps32_ofmap;
+
+  cvk_tl_t *table;
+  cvk_tl_t *rgb;            // for chw rotation, c == 3
+
+  cvk_ml_t *ml_left, *ml_right, *ml_res, *ml_bias, *ml_bias32, *ml_trans;
+  cvk_ml_t *ml_fleft, *ml_fright, *ml_fres;
+
+  cvk_tg_t tg, tg_dst, tg_nc, tg_cw, tg_rgb, tg_bf16;
+  cvk_tg_t tg_nc_bf16;
+  cvk_mg_t mg, mg_trans, mg_bf16;
+} bench_env_t;
+
+typedef void (*bench_fn_t)(bench_env_t *env);
+
+typedef struct {
+  const char *name;
+  bench_fn_t fn;
+} bench_case_t;
+
+typedef struct {
+  const char *chip;
+  const char *name;
+  uint64_t ops;
+  uint64_t descs;
+  uint64_t bytes;
+  double seconds;
+} bench_result_t;
+
+static double min_time = 0.2;
+static FILE *json;
+static int nr_results;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const bench_result_t *r)
+{
+  double s = r->seconds > 0 ? r->seconds : 1e-9;
+
+  fprintf(json, "%s\n    {\"chip\": \"%s\", \"name\": \"%s\", "
+          "\"ops\": %llu, \"descs\": %llu, \"bytes\": %llu, "
+          "\"seconds\": %.6f, \"ops_per_sec\": %.1f, "
+          "\"descs_per_sec\": %.1f, \"bytes_per_sec\": %.1f}",
+          nr_results ? "," : "", r->chip, r->name,
+          (unsigned long long)r->ops, (unsigned long long)r->descs,
+          (unsigned long long)r->bytes, r->seconds, r->ops / s,
+          r->descs / s, r->bytes / s);
+  nr_results++;
+}
+
+static uint32_t count_descs(uint8_t *cmdbuf, uint32_t size)
+{
+  uint32_t nr = 0;
+
+  for (uint32_t off = 0; off < size;) {
+    cmd_hdr_t *hdr = (cmd_hdr_t *)(cmdbuf + off);
+    off += sizeof(cmd_hdr_t) + cmd_hdr_len(hdr);
+    nr++;
+  }
+
+  return nr;
+}
+
+//
+// Environment
+//
+static cvk_tl_t *alloc_tl(
+    bench_env_t *env,
+    uint32_t n, uint32_t c, uint32_t h, uint32_t w,
+    cvk_fmt_t fmt, int eu_align)
+{
+  cvk_tl_shape_t s = {n, c, h, w};
+  cvk_tl_t *tl = env->ctx->ops->lmem_alloc_tensor(env->ctx, s, fmt, eu_align);
+
+  if (!tl) {
+    fprintf(stderr, "cvk_bench: out of local memory\n");
+    exit(1);
+  }
+  return tl;
+}
+
+// Per-channel quantization parameters, 9 bytes packed per channel but
+// described as one element with compact strides.
+static cvk_tl_t *alloc_chl_quan(bench_env_t *env, uint32_t c)
+{
+  cvk_context_t *ctx = env->ctx;
+  cvk_tl_t *tl = alloc_tl(env, 1, c, 1, 9, CVK_FMT_U8, 1);
+
+  tl->shape.w = 1;
+  tl->stride = ctx->ops->tl_default_stride(ctx, tl->shape, CVK_FMT_U8, 0);
+  return tl;
+}
+
+static cvk_ml_t *alloc_ml(
+    bench_env_t *env,
+    uint32_t row, uint32_t col,
+    cvk_fmt_t fmt)
+{
+  cvk_context_t *ctx = env->ctx;
+  cvk_ml_shape_t s = ctx->ops->ml_default_shape(ctx, row, col, fmt);
+  cvk_ml_t *ml = ctx->ops->lmem_alloc_matrix(ctx, s, fmt, 1);
+
+  if (!ml) {
+    fprintf(stderr, "cvk_bench: out of local memory\n");
+    exit(1);
+  }
+  return ml;
+}
+
+static void init_tg(
+    bench_env_t *env,
+    cvk_tg_t *tg,
+    uint64_t addr,
+    uint32_t n, uint32_t c, uint32_t h, uint32_t w,
+    cvk_fmt_t fmt)
+{
+  memset(tg, 0, sizeof(*tg));
+  tg->start_address = addr;
+  tg->fmt = fmt;
+  tg->shape.n = n;
+  tg->shape.c = c;
+  tg->shape.h = h;
+  tg->shape.w = w;
+  tg->stride = env->ctx->ops->tg_default_stride(env->ctx, tg->shape, fmt);
+}
+
+static void init_mg(
+    cvk_mg_t *mg,
+    uint64_t addr,
+    uint32_t row, uint32_t col,
+    cvk_fmt_t fmt)
+{
+  memset(mg, 0, sizeof(*mg));
+  mg->start_address = addr;
+  mg->fmt = fmt;
+  mg->shape.row = row;
+  mg->shape.col = col;
+  mg->stride.row = col * (fmt == CVK_FMT_BF16 ? 2 : 1);
+}
+
+static int init_env(bench_env_t *env, const char *chip)
+{
+  cvk_reg_info_t info;
+
+  memset(env, 0, sizeof(*env));
+  memset(&info, 0, sizeof(info));
+  strncpy(info.chip_ver_str, chip, sizeof(info.chip_ver_str) - 1);
+
+  // Fixed command buffer for every chip, the growable one is not common.
+  env->cmdbuf = malloc(BENCH_CMDBUF_SIZE);
+  info.cmdbuf = env->cmdbuf;
+  info.cmdbuf_size = BENCH_CMDBUF_SIZE;
+
+  env->ctx = cvikernel_register(&info);
+  if (!env->ctx) {
+    free(env->cmdbuf);
+    return -1;
+  }
+
+  uint32_t npu = env->ctx->info.npu_num;
+  cvk_fmt_t i8 = CVK_FMT_I8, bf16 = CVK_FMT_BF16;
+
+  env->a = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->b = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->c = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->d = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->e = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->f = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->fa = alloc_tl(env, 1, npu, 8, 8, bf16, 1);
+  env->fb = alloc_tl(env, 1, npu, 8, 8, bf16, 1);
+  env->fc = alloc_tl(env, 1, npu, 8, 8, bf16, 1);
+
+  env->ifmap = alloc_tl(env, 1, npu, 10, 10, i8, 1);
+  env->ofmap = alloc_tl(env, 1, npu, 8, 8, i8, 1);
+  env->weight = alloc_tl(env, npu, npu, 3, 3, i8, 0);
+  env->bias = alloc_tl(env, 2, npu, 1, 1, i8, 0);
+  env->chl_quan = alloc_chl_quan(env, npu);
+  env->dw_weight = alloc_tl(env, 1, npu, 3, 3, i8, 1);
+  env->dw_chl_quan = alloc_chl_quan(env, npu);
+
+  // Partial sums take four planes, n is one like the ofmap.
+  env->ps32_ofmap = alloc_tl(env, 4, npu, 8, 8, i8, 1);
+  env->ps32_ofmap->shape.n = 1;
+  env->table = alloc_tl(env, 1, npu, 16, 16, i8, 1);
+  env->rgb = alloc_tl(env, 1, 3, 8, 8, i8, 1);
+
+  env->ml_left = alloc_ml(env, 16, 32, i8);
+  env->ml_right = alloc_ml(env, 32, 16, i8);
+  env->ml_res = alloc_ml(env, 16, 16, i8);
+  env->ml_bias = alloc_ml(env, 2, 16, i8);
+  env->ml_bias32 = alloc_ml(env, 4, 16, i8);
+  env->ml_fleft = alloc_ml(env, 16, 32, bf16);
+  env->ml_fright = alloc_ml(env, 32, 16, bf16);
+  env->ml_fres = alloc_ml(env, 16, 16, bf16);
+
+  // Transposed load of a 32x16 global matrix.
+  cvk_context_t *ctx = env->ctx;
+  cvk_ml_shape_t ts = {16, ceiling_func(32, 16), 16, 32};
+  env->ml_trans = ctx->ops->lmem_alloc_matrix(ctx, ts, i8, 1);
+
+  init_tg(env, &env->tg, BENCH_GMEM_BASE, 1, npu, 8, 8, i8);
+  init_tg(env, &env->tg_dst, BENCH_GMEM_BASE + 0x100000, 1, npu, 8, 8, i8);
+  init_tg(env, &env->tg_nc, BENCH_GMEM_BASE + 0x200000, npu, 1, 8, 8, i8);
+  init_tg(env, &env->tg_cw, BENCH_GMEM_BASE + 0x300000, 1, 8, 8, npu, i8);
+  init_tg(env, &env->tg_rgb, BENCH_GMEM_BASE + 0x400000, 1, 3, 8, 8, i8);
+  init_tg(env, &env->tg_bf16, BENCH_GMEM_BASE + 0x500000, 1, npu, 8, 8, bf16);
+  init_mg(&env->mg, BENCH_GMEM_BASE + 0x600000, 16, 32, i8);
+  init_mg(&env->mg_trans, BENCH_GMEM_BASE + 0x700000, 32, 16, i8);
+  init_mg(&env->mg_bf16, BENCH_GMEM_BASE + 0x800000, 16, 32, bf16);
+  init_tg(env, &env->tg_nc_bf16, BENCH_GMEM_BASE + 0x900000,
+          npu, 1, 8, 8, bf16);
+
+  return 0;
+}
+
+static void free_env(bench_env_t *env)
+{
+  env->ctx->ops->cleanup(env->ctx);
+  free(env->ctx);
+  free(env->cmdbuf);
+}
+
+//
+// TDMA cases
+//
+static void bench_tdma_l2l_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_l2l_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = env->b;
+  env->ctx->ops->tdma_l2l_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2l_bf16_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_l2l_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->fa;
+  p.dst = env->fb;
+  env->ctx->ops->tdma_l2l_bf16_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2l_tensor_lrn_shift(bench_env_t *env)
+{
+  cvk_tdma_l2l_tensor_lrn_shift_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = env->b;
+  p.right_shift = 1;
+  p.lrn_step = 1;
+  env->ctx->ops->tdma_l2l_tensor_lrn_shift(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = &env->tg;
+  env->ctx->ops->tdma_l2g_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_bf16_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->fa;
+  p.dst = &env->tg_bf16;
+  env->ctx->ops->tdma_l2g_bf16_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_tensor_copy_nc_transposed(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_nc_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = &env->tg_nc;
+  env->ctx->ops->tdma_l2g_tensor_copy_nc_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_bf16_tensor_copy_nc_transposed(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_nc_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->fa;
+  p.dst = &env->tg_nc_bf16;
+  env->ctx->ops->tdma_l2g_bf16_tensor_copy_nc_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_tensor_copy_cw_transposed(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_cw_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = &env->tg_cw;
+  env->ctx->ops->tdma_l2g_tensor_copy_cw_transposed(env->ctx, &p);
+}
+
+// Every chip rejects bf16 tensors here, the bf16 entry point copies int8.
+static void bench_tdma_l2g_bf16_tensor_copy_cw_transposed(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_copy_cw_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = &env->tg_cw;
+  env->ctx->ops->tdma_l2g_bf16_tensor_copy_cw_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_tensor_fill_constant(bench_env_t *env)
+{
+  cvk_tdma_l2g_tensor_fill_constant_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.constant = 7;
+  p.dst = &env->tg;
+  env->ctx->ops->tdma_l2g_tensor_fill_constant(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_matrix_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_matrix_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->ml_left;
+  p.dst = &env->mg;
+  env->ctx->ops->tdma_l2g_matrix_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_bf16_matrix_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_matrix_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->ml_fleft;
+  p.dst = &env->mg_bf16;
+  env->ctx->ops->tdma_l2g_bf16_matrix_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_general_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_general_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src_address = env->a->start_address;
+  p.dst_address = env->tg.start_address;
+  p.bytes = 256;
+  env->ctx->ops->tdma_l2g_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_l2g_bf16_general_copy(bench_env_t *env)
+{
+  cvk_tdma_l2g_bf16_general_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src_address = env->fa->start_address;
+  p.dst_address = env->tg_bf16.start_address;
+  p.src_bytes = 256;
+  p.src_fmt = CVK_FMT_BF16;
+  p.dst_fmt = CVK_FMT_BF16;
+  env->ctx->ops->tdma_l2g_bf16_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg;
+  p.dst = env->a;
+  env->ctx->ops->tdma_g2l_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_bf16_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_bf16;
+  p.dst = env->fa;
+  env->ctx->ops->tdma_g2l_bf16_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_tensor_copy_nc_transposed(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_copy_nc_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_nc;
+  p.dst = env->a;
+  env->ctx->ops->tdma_g2l_tensor_copy_nc_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_bf16_tensor_copy_nc_transposed(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_copy_nc_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_nc_bf16;
+  p.dst = env->fa;
+  env->ctx->ops->tdma_g2l_bf16_tensor_copy_nc_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_tensor_copy_chw_rotated(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_copy_chw_rotated_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_rgb;
+  p.dst = env->rgb;
+  env->ctx->ops->tdma_g2l_tensor_copy_chw_rotated(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_tensor_fill_constant(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_fill_constant_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.constant = 7;
+  p.dst = env->a;
+  env->ctx->ops->tdma_g2l_tensor_fill_constant(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_bf16_tensor_fill_constant(bench_env_t *env)
+{
+  cvk_tdma_g2l_tensor_fill_constant_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.constant = 0x3f80;
+  p.dst = env->fa;
+  env->ctx->ops->tdma_g2l_bf16_tensor_fill_constant(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_matrix_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_matrix_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->mg;
+  p.dst = env->ml_left;
+  env->ctx->ops->tdma_g2l_matrix_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_bf16_matrix_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_matrix_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->mg_bf16;
+  p.dst = env->ml_fleft;
+  env->ctx->ops->tdma_g2l_bf16_matrix_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_matrix_copy_row_col_transposed(bench_env_t *env)
+{
+  cvk_tdma_g2l_matrix_copy_row_col_transposed_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->mg_trans;
+  p.dst = env->ml_trans;
+  env->ctx->ops->tdma_g2l_matrix_copy_row_col_transposed(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_general_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_general_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src_address = env->tg.start_address;
+  p.dst_address = env->a->start_address;
+  p.bytes = 256;
+  env->ctx->ops->tdma_g2l_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2l_bf16_general_copy(bench_env_t *env)
+{
+  cvk_tdma_g2l_bf16_general_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src_address = env->tg_bf16.start_address;
+  p.dst_address = env->fa->start_address;
+  p.src_bytes = 256;
+  p.src_fmt = CVK_FMT_BF16;
+  p.dst_fmt = CVK_FMT_BF16;
+  env->ctx->ops->tdma_g2l_bf16_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2g_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_g2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg;
+  p.dst = &env->tg_dst;
+  env->ctx->ops->tdma_g2g_tensor_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2g_general_copy(bench_env_t *env)
+{
+  cvk_tdma_g2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg;
+  p.dst = &env->tg_dst;
+  env->ctx->ops->tdma_g2g_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2g_bf16_general_copy(bench_env_t *env)
+{
+  cvk_tdma_g2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_bf16;
+  p.dst = &env->tg_bf16;
+  env->ctx->ops->tdma_g2g_bf16_general_copy(env->ctx, &p);
+}
+
+static void bench_tdma_g2g_bf16_tensor_copy(bench_env_t *env)
+{
+  cvk_tdma_g2g_tensor_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = &env->tg_bf16;
+  p.dst = &env->tg_bf16;
+  env->ctx->ops->tdma_g2g_bf16_tensor_copy(env->ctx, &p);
+}
+
+//
+// TIU cases
+//
+static void bench_tiu_mul(bench_env_t *env)
+{
+  cvk_tiu_mul_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res_low = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  p.rshift_bits = 3;
+  env->ctx->ops->tiu_mul(env->ctx, &p);
+}
+
+static void bench_tiu_mul_qm(bench_env_t *env)
+{
+  cvk_tiu_mul_qm_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res_low = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  p.rshift_bits = 3;
+  p.multiplier = 1 << 30;
+  env->ctx->ops->tiu_mul_qm(env->ctx, &p);
+}
+
+static void bench_tiu_mac(bench_env_t *env)
+{
+  cvk_tiu_mac_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res_low = env->c;
+  p.res_high = env->d;
+  p.a = env->a;
+  p.b = env->b;
+  p.res_is_int8 = 1;
+  p.rshift_bits = 3;
+  env->ctx->ops->tiu_mac(env->ctx, &p);
+}
+
+static void bench_tiu_add(bench_env_t *env)
+{
+  cvk_tiu_add_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res_low = env->e;
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.b.low = env->c;
+  p.b.high = env->d;
+  p.rshift_bits = 1;
+  env->ctx->ops->tiu_add(env->ctx, &p);
+}
+
+static void bench_tiu_sub(bench_env_t *env)
+{
+  cvk_tiu_sub_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res_low = env->e;
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.b_low = env->c;
+  p.b_high = env->d;
+  p.rshift_bits = 1;
+  env->ctx->ops->tiu_sub(env->ctx, &p);
+}
+
+static void bench_tiu_max(bench_env_t *env)
+{
+  cvk_tiu_max_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.max = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_max(env->ctx, &p);
+}
+
+static void bench_tiu_min(bench_env_t *env)
+{
+  cvk_tiu_min_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.min = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_min(env->ctx, &p);
+}
+
+static void bench_tiu_ge(bench_env_t *env)
+{
+  cvk_tiu_ge_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ge = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_ge(env->ctx, &p);
+}
+
+static void bench_tiu_arith_shift(bench_env_t *env)
+{
+  cvk_tiu_arith_shift_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.res_low = env->c;
+  p.res_high = env->d;
+  p.bits = env->e;
+  env->ctx->ops->tiu_arith_shift(env->ctx, &p);
+}
+
+static void bench_tiu_and_int8(bench_env_t *env)
+{
+  cvk_tiu_and_int8_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_and_int8(env->ctx, &p);
+}
+
+static void bench_tiu_and_int16(bench_env_t *env)
+{
+  cvk_tiu_and_int16_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.b_low = env->c;
+  p.b_high = env->d;
+  p.res_low = env->e;
+  p.res_high = env->f;
+  env->ctx->ops->tiu_and_int16(env->ctx, &p);
+}
+
+static void bench_tiu_or_int8(bench_env_t *env)
+{
+  cvk_tiu_or_int8_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_or_int8(env->ctx, &p);
+}
+
+static void bench_tiu_or_int16(bench_env_t *env)
+{
+  cvk_tiu_or_int16_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.b_low = env->c;
+  p.b_high = env->d;
+  p.res_low = env->e;
+  p.res_high = env->f;
+  env->ctx->ops->tiu_or_int16(env->ctx, &p);
+}
+
+static void bench_tiu_xor_int8(bench_env_t *env)
+{
+  cvk_tiu_xor_int8_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->c;
+  p.a = env->a;
+  p.b = env->b;
+  env->ctx->ops->tiu_xor_int8(env->ctx, &p);
+}
+
+static void bench_tiu_xor_int16(bench_env_t *env)
+{
+  cvk_tiu_xor_int16_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.a_low = env->a;
+  p.a_high = env->b;
+  p.b_low = env->c;
+  p.b_high = env->d;
+  p.res_low = env->e;
+  p.res_high = env->f;
+  env->ctx->ops->tiu_xor_int16(env->ctx, &p);
+}
+
+static void bench_tiu_copy(bench_env_t *env)
+{
+  cvk_tiu_copy_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.src = env->a;
+  p.dst = env->b;
+  env->ctx->ops->tiu_copy(env->ctx, &p);
+}
+
+static void bench_tiu_lookup_table(bench_env_t *env)
+{
+  cvk_tiu_lookup_table_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->b;
+  p.ifmap = env->a;
+  p.table = env->table;
+  env->ctx->ops->tiu_lookup_table(env->ctx, &p);
+}
+
+static void bench_tiu_pt_convolution(bench_env_t *env)
+{
+  cvk_tiu_pt_convolution_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.weight = env->weight;
+  p.bias = env->bias;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.dilation_h = 1;
+  p.dilation_w = 1;
+  p.relu_enable = 1;
+  p.rshift_bits = 5;
+  env->ctx->ops->tiu_pt_convolution(env->ctx, &p);
+}
+
+static void bench_tiu_pt_convolution_ps32(bench_env_t *env)
+{
+  cvk_tiu_pt_convolution_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ps32_ofmap;
+  p.ifmap = env->ifmap;
+  p.weight = env->weight;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.dilation_h = 1;
+  p.dilation_w = 1;
+  p.ps32_mode = 2;
+  env->ctx->ops->tiu_pt_convolution(env->ctx, &p);
+}
+
+static void bench_tiu_convolution(bench_env_t *env)
+{
+  cvk_tiu_convolution_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.weight = env->weight;
+  p.chl_quan_param = env->chl_quan;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.dilation_h = 1;
+  p.dilation_w = 1;
+  p.has_bias = 1;
+  p.relu_enable = 1;
+  env->ctx->ops->tiu_convolution(env->ctx, &p);
+}
+
+static void bench_tiu_max_pooling(bench_env_t *env)
+{
+  cvk_tiu_max_pooling_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.kh = 3;
+  p.kw = 3;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  env->ctx->ops->tiu_max_pooling(env->ctx, &p);
+}
+
+static void bench_tiu_min_pooling(bench_env_t *env)
+{
+  cvk_tiu_min_pooling_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.kh = 3;
+  p.kw = 3;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  env->ctx->ops->tiu_min_pooling(env->ctx, &p);
+}
+
+static void bench_tiu_average_pooling(bench_env_t *env)
+{
+  cvk_tiu_average_pooling_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.kh = 3;
+  p.kw = 3;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.avg_pooling_const = 1;
+  p.rshift_bits = 3;
+  env->ctx->ops->tiu_average_pooling(env->ctx, &p);
+}
+
+static void bench_tiu_pt_depthwise_convolution(bench_env_t *env)
+{
+  cvk_tiu_depthwise_pt_convolution_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.weight = env->dw_weight;
+  p.bias = env->bias;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.dilation_h = 1;
+  p.dilation_w = 1;
+  p.rshift_bits = 3;
+  env->ctx->ops->tiu_pt_depthwise_convolution(env->ctx, &p);
+}
+
+static void bench_tiu_depthwise_convolution(bench_env_t *env)
+{
+  cvk_tiu_depthwise_convolution_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.ofmap = env->ofmap;
+  p.ifmap = env->ifmap;
+  p.weight = env->dw_weight;
+  p.chl_quan_param = env->dw_chl_quan;
+  p.stride_h = 1;
+  p.stride_w = 1;
+  p.dilation_h = 1;
+  p.dilation_w = 1;
+  p.has_bias = 1;
+  env->ctx->ops->tiu_depthwise_convolution(env->ctx, &p);
+}
+
+static void bench_tiu_matrix_multiplication(bench_env_t *env)
+{
+  cvk_tiu_matrix_multiplication_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->ml_res;
+  p.left = env->ml_left;
+  p.right = env->ml_right;
+  p.bias = env->ml_bias;
+  p.rshift_bits = 5;
+  p.res_is_int8 = 1;
+  env->ctx->ops->tiu_matrix_multiplication(env->ctx, &p);
+}
+
+static void bench_tiu_matrix_multiplication_bf16(bench_env_t *env)
+{
+  cvk_tiu_matrix_multiplication_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->ml_fres;
+  p.left = env->ml_fleft;
+  p.right = env->ml_fright;
+  p.res_is_int8 = 1;
+  env->ctx->ops->tiu_matrix_multiplication(env->ctx, &p);
+}
+
+static void bench_tiu_matrix_multiplication_qm(bench_env_t *env)
+{
+  cvk_tiu_matrix_multiplication_qm_param_t p;
+  memset(&p, 0, sizeof(p));
+  p.res = env->ml_res;
+  p.left = env->ml_left;
+  p.right = env->ml_right;
+  p.bias = env->ml_bias32;
+  p.rshift_bits = 5;
+  p.res_is_int8 = 1;
+  p.quan_m = 1 << 30;
+  env->ctx->ops->tiu_matrix_multiplication_qm(env->ctx, &p);
+}
+
+//
+// Compressed copies need a VLC encoded source and bf16_lookup_interp_table
+// prepared tables, both are covered by the VLC and the other TDMA/TIU
+// cases instead.
+//
+#define BENCH_CASE(op) {#op, bench_##op}
+
+static const bench_case_t bench_cases[] = {
+  BENCH_CASE(tdma_l2l_tensor_copy),
+  BENCH_CASE(tdma_l2l_bf16_tensor_copy),
+  BENCH_CASE(tdma_l2l_tensor_lrn_shift),
+  BENCH_CASE(tdma_l2g_tensor_copy),
+  BENCH_CASE(tdma_l2g_bf16_tensor_copy),
+  BENCH_CASE(tdma_l2g_tensor_copy_nc_transposed),
+  BENCH_CASE(tdma_l2g_bf16_tensor_copy_nc_transposed),
+  BENCH_CASE(tdma_l2g_tensor_copy_cw_transposed),
+  BENCH_CASE(tdma_l2g_bf16_tensor_copy_cw_transposed),
+  BENCH_CASE(tdma_l2g_tensor_fill_constant),
+  BENCH_CASE(tdma_l2g_matrix_copy),
+  BENCH_CASE(tdma_l2g_bf16_matrix_copy),
+  BENCH_CASE(tdma_l2g_general_copy),
+  BENCH_CASE(tdma_l2g_bf16_general_copy),
+  BENCH_CASE(tdma_g2l_tensor_copy),
+  BENCH_CASE(tdma_g2l_bf16_tensor_copy),
+  BENCH_CASE(tdma_g2l_tensor_copy_nc_transposed),
+  BENCH_CASE(tdma_g2l_bf16_tensor_copy_nc_transposed),
+  BENCH_CASE(tdma_g2l_tensor_copy_chw_rotated),
+  BENCH_CASE(tdma_g2l_tensor_fill_constant),
+  BENCH_CASE(tdma_g2l_bf16_tensor_fill_constant),
+  BENCH_CASE(tdma_g2l_matrix_copy),
+  BENCH_CASE(tdma_g2l_bf16_matrix_copy),
+  BENCH_CASE(tdma_g2l_matrix_copy_row_col_transposed),
+  BENCH_CASE(tdma_g2l_general_copy),
+  BENCH_CASE(tdma_g2l_bf16_general_copy),
+  BENCH_CASE(tdma_g2g_tensor_copy),
+  BENCH_CASE(tdma_g2g_general_copy),
+  BENCH_CASE(tdma_g2g_bf16_general_copy),
+  BENCH_CASE(tdma_g2g_bf16_tensor_copy),
+  BENCH_CASE(tiu_mul),
+  BENCH_CASE(tiu_mul_qm),
+  BENCH_CASE(tiu_mac),
+  BENCH_CASE(tiu_add),
+  BENCH_CASE(tiu_sub),
+  BENCH_CASE(tiu_max),
+  BENCH_CASE(tiu_min),
+  BENCH_CASE(tiu_ge),
+  BENCH_CASE(tiu_arith_shift),
+  BENCH_CASE(tiu_and_int8),
+  BENCH_CASE(tiu_and_int16),
+  BENCH_CASE(tiu_or_int8),
+  BENCH_CASE(tiu_or_int16),
+  BENCH_CASE(tiu_xor_int8),
+  BENCH_CASE(tiu_xor_int16),
+  BENCH_CASE(tiu_copy),
+  BENCH_CASE(tiu_lookup_table),
+  BENCH_CASE(tiu_pt_convolution),
+  BENCH_CASE(tiu_pt_convolution_ps32),
+  BENCH_CASE(tiu_convolution),
+  BENCH_CASE(tiu_max_pooling),
+  BENCH_CASE(tiu_min_pooling),
+  BENCH_CASE(tiu_average_pooling),
+  BENCH_CASE(tiu_pt_depthwise_convolution),
+  BENCH_CASE(tiu_depthwise_convolution),
+  BENCH_CASE(tiu_matrix_multiplication),
+  BENCH_CASE(tiu_matrix_multiplication_bf16),
+  BENCH_CASE(tiu_matrix_multiplication_qm),
+};
+
+#define NR_BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+// Op of a case is missing from the chip's operation table.
+static int case_supported(bench_env_t *env, const bench_case_t *bc)
+{
+  cvk_operations_t *ops = env->ctx->ops;
+
+#define HAS_OP(op) if (!strncmp(bc->name, #op, strlen(#op))) return ops->op != NULL
+  HAS_OP(tiu_ge);
+  HAS_OP(tiu_min_pooling);
+  HAS_OP(tiu_mul_qm);
+  HAS_OP(tiu_matrix_multiplication_qm);
+  HAS_OP(tdma_l2g_tensor_copy_cw_transposed);
+  HAS_OP(tdma_l2g_bf16_tensor_copy_cw_transposed);
+  HAS_OP(tdma_g2l_tensor_copy_chw_rotated);
+  HAS_OP(tdma_g2g_general_copy);
+  HAS_OP(tdma_g2g_bf16_general_copy);
+#undef HAS_OP
+
+  return 1;
+}
+
+//
+// Runners
+//
+static void run_case(bench_env_t *env, const char *chip, const bench_case_t *bc)
+{
+  cvk_context_t *ctx = env->ctx;
+  bench_result_t r = {chip, bc->name, 0, 0, 0, 0};
+
+  ctx->ops->reset(ctx);
+
+  do {
+    double start = now();
+    for (int i = 0; i < BENCH_BATCH; i++)
+      bc->fn(env);
+
+    uint32_t size;
+    uint8_t *cmdbuf = ctx->ops->acquire_cmdbuf(ctx, &size);
+    r.seconds += now() - start;
+
+    r.ops += BENCH_BATCH;
+    r.descs += count_descs(cmdbuf, size);
+    r.bytes += size;
+    ctx->ops->reset(ctx);
+  } while (r.seconds < min_time && r.descs);
+
+  // Operations the hardware lacks are accepted as no-ops.
+  if (!r.descs) {
+    fprintf(stderr, "cvk_bench: %s %s emits no descriptor, skipped\n",
+            chip, bc->name);
+    return;
+  }
+
+  report(&r);
+}
+
+// Command buffer of a mix of all cases, for acquire and dmabuf benchmarks.
+static uint32_t record_mix(bench_env_t *env, uint32_t nr_rounds)
+{
+  for (uint32_t round = 0; round < nr_rounds; round++) {
+    for (uint32_t i = 0; i < NR_BENCH_CASES; i++) {
+      if (case_supported(env, &bench_cases[i]))
+        bench_cases[i].fn(env);
+    }
+  }
+
+  return nr_rounds * NR_BENCH_CASES;
+}
+
+static void run_acquire(bench_env_t *env, const char *chip)
+{
+  cvk_context_t *ctx = env->ctx;
+  bench_result_t r = {chip, "acquire_cmdbuf", 0, 0, 0, 0};
+
+  ctx->ops->reset(ctx);
+
+  do {
+    uint32_t size;
+    uint32_t ops = record_mix(env, 8);
+
+    double start = now();
+    uint8_t *cmdbuf = ctx->ops->acquire_cmdbuf(ctx, &size);
+    r.seconds += now() - start;
+
+    r.ops += ops;
+    r.descs += count_descs(cmdbuf, size);
+    r.bytes += size;
+    ctx->ops->reset(ctx);
+  } while (r.seconds < min_time && r.descs);
+
+  report(&r);
+}
+
+static void run_dmabuf(bench_env_t *env, const char *chip)
+{
+  cvk_context_t *ctx = env->ctx;
+  bench_result_t rs = {chip, "dmabuf_size", 0, 0, 0, 0};
+  bench_result_t rc = {chip, "dmabuf_convert", 0, 0, 0, 0};
+
+  if (!ctx->ops->dmabuf_size || !ctx->ops->dmabuf_convert)
+    return;
+
+  ctx->ops->reset(ctx);
+  record_mix(env, 64);
+
+  uint32_t size, dmabuf_size, pmu_size;
+  uint8_t *cmdbuf = ctx->ops->acquire_cmdbuf(ctx, &size);
+  uint32_t nr_descs = count_descs(cmdbuf, size);
+
+  ctx->ops->dmabuf_size(cmdbuf, size, &dmabuf_size, &pmu_size);
+  uint8_t *dmabuf = malloc(dmabuf_size);
+
+  do {
+    double start = now();
+    ctx->ops->dmabuf_size(cmdbuf, size, &dmabuf_size, &pmu_size);
+    rs.seconds += now() - start;
+    rs.descs += nr_descs;
+    rs.bytes += size;
+  } while (rs.seconds < min_time && nr_descs);
+
+  do {
+    double start = now();
+    ctx->ops->dmabuf_convert(cmdbuf, size, dmabuf);
+    rc.seconds += now() - start;
+    rc.descs += nr_descs;
+    rc.bytes += size;
+  } while (rc.seconds < min_time && nr_descs);
+
+  free(dmabuf);
+  ctx->ops->reset(ctx);
+
+  report(&rs);
+  report(&rc);
+}
+
+static void run_vlc(void)
+{
+  const size_t nr = 1 << 20;
+  uint8_t *i8 = malloc(nr);
+  uint16_t *bf16 = malloc(nr * sizeof(uint16_t));
+  uint8_t *bs = malloc(get_out_bs_buf_size(nr * 2, 1));
+  uint8_t *out = malloc(nr * sizeof(uint16_t));
+
+  // Weight-like data, mostly small values.
+  srand(1);
+  for (size_t i = 0; i < nr; i++) {
+    int v = (rand() % 16) - 8;
+    i8[i] = (uint8_t)(int8_t)(v * v * v / 64);
+    bf16[i] = 0x3c00 + (rand() % 0x400);
+  }
+
+  CommandInfo info;
+  size_t bs_size;
+  bench_result_t r[4] = {
+    {"all", "vlc_enc_int8", 0, 0, 0, 0},
+    {"all", "vlc_dec_int8", 0, 0, 0, 0},
+    {"all", "vlc_enc_bf16", 0, 0, 0, 0},
+    {"all", "vlc_dec_bf16", 0, 0, 0, 0},
+  };
+
+  memset(&info, 0, sizeof(info));
+  info.signedness = 1;
+  cvk_vlc_est_weight_bias(i8, nr, 1, 0, &info);
+  do {
+    double start = now();
+    cvk_vlc_enc_int8(i8, nr, bs, &bs_size, &info);
+    r[0].seconds += now() - start;
+    r[0].ops++;
+    r[0].bytes += nr;
+  } while (r[0].seconds < min_time);
+
+  do {
+    double start = now();
+    cvk_vlc_dec_int8(bs, nr, out);
+    r[1].seconds += now() - start;
+    r[1].ops++;
+    r[1].bytes += nr;
+  } while (r[1].seconds < min_time);
+
+  memset(&info, 0, sizeof(info));
+  info.is_bfloat16 = 1;
+  cvk_vlc_est_weight_bias((uint8_t *)bf16, nr * 2, 0, 1, &info);
+  do {
+    double start = now();
+    cvk_vlc_enc_bf16(bf16, nr * 2, bs, &bs_size, &info);
+    r[2].seconds += now() - start;
+    r[2].ops++;
+    r[2].bytes += nr * 2;
+  } while (r[2].seconds < min_time);
+
+  do {
+    double start = now();
+    cvk_vlc_dec_bf16(bs, nr * 2, (uint16_t *)out);
+    r[3].seconds += now() - start;
+    r[3].ops++;
+    r[3].bytes += nr * 2;
+  } while (r[3].seconds < min_time);
+
+  for (int i = 0; i < 4; i++)
+    report(&r[i]);
+
+  free(i8);
+  free(bf16);
+  free(bs);
+  free(out);
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [--chip NAME] [--filter SUBSTR] [--min-time SEC] "
+          "[--json FILE]\n", prog);
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  static const char *chips[] = {
+    CVI_TPU_VERSION_181X, CVI_TPU_VERSION_180X,
+    CVI_TPU_VERSION_183X, CVI_TPU_VERSION_182X,
+  };
+  const char *chip_arg = NULL, *filter = NULL, *json_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc)
+      usage(argv[0]);
+
+    if (!strcmp(argv[i], "--chip"))
+      chip_arg = argv[++i];
+    else if (!strcmp(argv[i], "--filter"))
+      filter = argv[++i];
+    else if (!strcmp(argv[i], "--min-time"))
+      min_time = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--json"))
+      json_path = argv[++i];
+    else
+      usage(argv[0]);
+  }
+
+  json = json_path ? fopen(json_path, "w") : stdout;
+  if (!json) {
+    fprintf(stderr, "cvk_bench: cannot open %s\n", json_path);
+    return 1;
+  }
+
+  fprintf(json, "{\n  \"benchmarks\": [");
+
+  for (size_t ci = 0; ci < sizeof(chips) / sizeof(chips[0]); ci++) {
+    const char *chip = chips[ci];
+    bench_env_t env;
+
+    if (chip_arg && strcmp(chip_arg, chip))
+      continue;
+
+    // Chips left out of this build.
+    if (init_env(&env, chip))
+      continue;
+
+    for (size_t i = 0; i < NR_BENCH_CASES; i++) {
+      const bench_case_t *bc = &bench_cases[i];
+      if (filter && !strstr(bc->name, filter))
+        continue;
+      if (case_supported(&env, bc))
+        run_case(&env, chip, bc);
+    }
+
+    if (!filter || strstr("acquire_cmdbuf", filter))
+      run_acquire(&env, chip);
+    if (!filter || strstr("dmabuf_size dmabuf_convert", filter))
+      run_dmabuf(&env, chip);
+
+    free_env(&env);
+  }
+
+  if (!chip_arg && (!filter || strstr("vlc_enc_int8 vlc_dec_int8 "
+                                     "vlc_enc_bf16 vlc_dec_bf16", filter)))
+    run_vlc();
+
+  fprintf(json, "\n  ]\n}\n");
+
+  if (json != stdout)
+    fclose(json);
+
+  return 0;
+}
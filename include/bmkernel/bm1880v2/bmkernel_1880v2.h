@@ -28,6 +28,29 @@ void bmk1880v2_dmabuf_relocate(
     uint32_t original_size, uint32_t pmubuf_size);
 void bmk1880v2_dmabuf_convert(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf);
 void bmk1880v2_dmabuf_dump(uint8_t * dmabuf);
+
+// Descriptor index of a command buffer, built by one walk over it.
+// Size and conversion are then done from the index, without walking or
+// parsing the command buffer again. cmdbuf must outlive the index.
+typedef struct bmk1880v2_dmabuf_index bmk1880v2_dmabuf_index_t;
+bmk1880v2_dmabuf_index_t *bmk1880v2_dmabuf_index_create(uint8_t *cmdbuf, uint32_t sz);
+void bmk1880v2_dmabuf_index_size(
+    const bmk1880v2_dmabuf_index_t *idx,
+    uint32_t *psize, uint32_t *pmu_size);
+void bmk1880v2_dmabuf_index_convert(
+    const bmk1880v2_dmabuf_index_t *idx, uint8_t *dmabuf);
+void bmk1880v2_dmabuf_index_destroy(bmk1880v2_dmabuf_index_t *idx);
+
+// Same as bmk1880v2_dmabuf_convert, with descriptors copied concurrently.
+// Segments are split into chunks with precomputed dmabuf offsets and
+// filled by nr_threads threads, or by tasks run through dispatch.
+void bmk1880v2_dmabuf_convert_mt(
+    uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf, uint32_t nr_threads);
+void bmk1880v2_dmabuf_index_convert_mt(
+    const bmk1880v2_dmabuf_index_t *idx, uint8_t *dmabuf, uint32_t nr_threads);
+void bmk1880v2_dmabuf_index_convert_dispatch(
+    const bmk1880v2_dmabuf_index_t *idx, uint8_t *dmabuf,
+    bmk_dispatch_fn_t dispatch, void *dispatch_ctx);
 void bmk1880v2_arraybase_set(
     uint8_t *dmabuf, uint32_t arraybase0L, uint32_t arraybase1L,
     uint32_t arraybase0H, uint32_t arraybase1H);
@@ -1015,6 +1038,36 @@ void bmk1880v2_lmem_free_matrix(
     bmk1880v2_context_t *ctx,
     const bmk1880v2_matrix_lmem_t *t);
 
+/*
+ * Allocate within one of chip_info.lmem_banks banks, NULL if it does not
+ * fit there. Tensors and matrices may be freed in any order.
+ */
+bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_bank_tensor(
+    bmk1880v2_context_t *ctx,
+    uint32_t bank_id,
+    bmk1880v2_tensor_lmem_shape_t s,
+    fmt_t fmt,
+    int eu_align);
+
+bmk1880v2_matrix_lmem_t * bmk1880v2_lmem_alloc_bank_matrix(
+    bmk1880v2_context_t *ctx,
+    uint32_t bank_id,
+    bmk1880v2_matrix_lmem_shape_t s,
+    fmt_t fmt,
+    int eu_align);
+
+/*
+ * Highest local memory end address allocated since register or the last
+ * reset of the mark, which restarts from the allocations still live.
+ */
+uint32_t bmk1880v2_lmem_high_water(bmk1880v2_context_t *ctx);
+void bmk1880v2_lmem_reset_high_water(bmk1880v2_context_t *ctx);
+
+/*
+ * Largest local memory block an allocation outside any bank can get now.
+ */
+uint32_t bmk1880v2_lmem_largest_free(bmk1880v2_context_t *ctx);
+
 uint32_t bmk1880v2_lmem_tensor_to_size(
     bmk1880v2_context_t *ctx,
     bmk1880v2_tensor_lmem_shape_t s,
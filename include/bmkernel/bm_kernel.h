@@ -82,6 +82,16 @@ typedef struct {
   uint8_t *cmdbuf;
 } bmk_info_t;
 
+// Task dispatcher supplied by the user, e.g. a thread pool.
+// Must run task(arg, i) once for every i in [0, nr_tasks) and return when
+// all of them are done. Tasks are independent and may run concurrently.
+typedef void (*bmk_task_fn_t)(void *arg, uint32_t i);
+typedef void (*bmk_dispatch_fn_t)(
+    void *dispatch_ctx,
+    bmk_task_fn_t task,
+    void *arg,
+    uint32_t nr_tasks);
+
 cvk_chip_info_t bmk1880v2_chip_info(void);
 cvk_chip_info_t bmk1822_chip_info(void);
 
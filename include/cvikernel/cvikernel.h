@@ -826,6 +826,8 @@ typedef struct cvikernel_operations {
   void (*cleanup)(struct cvikernel_context *ctx);
   void (*reset)(struct cvikernel_context *ctx);
   uint8_t *(*acquire_cmdbuf)(struct cvikernel_context *ctx, uint32_t *size);
+  // On a malformed cmdbuf, cv181x/cv180x report a size of 0 and leave the
+  // dmabuf header unwritten, the others assert.
   void (*dmabuf_size)(uint8_t *cmdbuf, uint32_t sz, uint32_t *psize, uint32_t *pmu_size);
   void (*dmabuf_convert)(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf);
 
@@ -1129,6 +1131,384 @@ typedef struct cvikernel_operations {
       const cvk_tiu_min_pooling_param_t *param);
 } cvk_operations_t;
 
+/*
+ * One piece of a chunk-chained command buffer
+ */
+typedef struct {
+  uint8_t *buf;
+  uint32_t size;
+} cvk_cmdbuf_chunk_t;
+
+/*
+ * Descriptor template, one emitted tiu/tdma command kept for re-emission
+ */
+#define CVK_DESC_TEMPLATE_WORDS   28
+
+typedef struct {
+  uint32_t engine_id;
+  uint32_t regs[CVK_DESC_TEMPLATE_WORDS];
+} cvk_desc_template_t;
+
+/*
+ * Operand addresses replaced on re-emission, as in the tensor start_address
+ */
+#define CVK_DESC_PATCH_RES0       (1 << 0)
+#define CVK_DESC_PATCH_OPD0       (1 << 1)
+#define CVK_DESC_PATCH_OPD1       (1 << 2)
+#define CVK_DESC_PATCH_OPD2       (1 << 3)
+#define CVK_DESC_PATCH_SRC        (1 << 4)
+#define CVK_DESC_PATCH_DST        (1 << 5)
+
+typedef struct {
+  uint32_t mask;          // CVK_DESC_PATCH_*
+  uint32_t res0_addr;     // tiu
+  uint32_t opd0_addr;
+  uint32_t opd1_addr;
+  uint32_t opd2_addr;
+  uint64_t src_address;   // tdma
+  uint64_t dst_address;
+} cvk_desc_patch_t;
+
+/*
+ * Tensor placed by lmem_plan, live from op first_use to last_use inclusive
+ */
+#define CVK_LMEM_PLAN_NO_FIT      0xffffffff
+
+typedef struct {
+  cvk_tl_shape_t shape;
+  cvk_fmt_t fmt;
+  int eu_align;
+  uint32_t first_use;
+  uint32_t last_use;
+  uint32_t start_address;   // out, CVK_LMEM_PLAN_NO_FIT if not placed
+} cvk_lmem_plan_tensor_t;
+
+/*
+ * Convolutions of one layer by the path taken, see conv_report
+ */
+#define CVK_CONV_SINGLE_IFMAP_ADDR    (1 << 0)  // odd ifmap address
+#define CVK_CONV_SINGLE_WEIGHT_ADDR   (1 << 1)  // odd weight address
+#define CVK_CONV_SINGLE_ODD_C         (1 << 2)  // odd ifmap c
+#define CVK_CONV_SINGLE_SMALL_C       (1 << 3)  // ifmap c < 4
+#define CVK_CONV_SINGLE_BF16          (1 << 4)  // bf16 pt convolution
+
+typedef struct {
+  uint16_t layer_id;
+  uint32_t nr_double;
+  uint32_t nr_single;
+
+  // Single conv reasons, a convolution counts in each one that applies.
+  uint32_t nr_ifmap_addr;
+  uint32_t nr_weight_addr;
+  uint32_t nr_odd_c;
+  uint32_t nr_small_c;
+  uint32_t nr_bf16;
+} cvk_conv_report_t;
+
+/*
+ * Splits chosen by autotune in conv_tiled, gemm_tiled and pool_tiled,
+ * cached by op and layer shape. Zero it before first use, when full the
+ * oldest entry is replaced.
+ */
+#define CVK_TILE_CACHE_SIZE       64
+
+typedef struct {
+  uint64_t key;
+  uint32_t nr[4];           // tiles along each split dimension
+} cvk_tile_cache_entry_t;
+
+typedef struct {
+  uint32_t nr_entries;
+  uint32_t next;            // replaced next when full
+  uint32_t nr_hits;
+  uint32_t nr_misses;
+  cvk_tile_cache_entry_t entries[CVK_TILE_CACHE_SIZE];
+} cvk_tile_cache_t;
+
+/*
+ * Convolution of global memory tensors, see conv_tiled
+ *
+ * Int8 with per-channel quantization as in tiu_convolution:
+ *   ifmap (n, ic, ih, iw), ofmap (n, oc, oh, ow)
+ *   weight (1, oc, kh*kw, ic), see convolution weight shape
+ *   chl_quan_param (1, oc, 1, 9) with bias, (1, oc, 1, 5) without
+ */
+typedef struct {
+  const cvk_tg_t *ifmap;
+  const cvk_tg_t *weight;
+  const cvk_tg_t *chl_quan_param;
+  const cvk_tg_t *ofmap;
+  uint16_t kh, kw;
+  uint8_t pad_top, pad_bottom;
+  uint8_t pad_left, pad_right;
+  uint8_t stride_h, stride_w;
+  uint8_t dilation_h, dilation_w;
+  uint8_t has_bias;
+  uint8_t relu_enable;
+  uint16_t layer_id;
+  int8_t ins_val;   // padding value
+  uint8_t autotune;         // rank splits by estimated cycles
+  cvk_tile_cache_t *cache;  // optional, autotune only
+} cvk_conv_tiled_param_t;
+
+typedef struct {
+  uint32_t n_step;
+  uint32_t oc_step;
+  uint32_t oh_step;
+  uint32_t ow_step;
+  uint32_t nr_tiles;
+  uint32_t lmem_size;       // taken by the tile buffers
+  uint64_t cycles;          // cost model estimate of the split
+} cvk_conv_tiling_t;
+
+/*
+ * Matrix multiplication of global memory matrices, see gemm_tiled
+ *
+ *   res (M, N) = left (M, K) * right (K, N) + bias
+ * Int8 or bf16 as in tiu_matrix_multiplication, bias (2, N) split in two
+ * rows the same way. Int8 results are int8.
+ */
+typedef struct {
+  const cvk_mg_t *left;
+  const cvk_mg_t *right;
+  const cvk_mg_t *bias;     // optional
+  const cvk_mg_t *res;
+  uint8_t rshift_bits;      // int8 only
+  uint8_t relu_enable;
+  uint16_t layer_id;
+  uint8_t autotune;         // rank splits by estimated cycles
+  cvk_tile_cache_t *cache;  // optional, autotune only
+} cvk_gemm_tiled_param_t;
+
+typedef struct {
+  uint32_t m_step;
+  uint32_t k_step;
+  uint32_t n_step;
+  uint32_t nr_tiles;        // tiu_matrix_multiplication commands
+  uint32_t lmem_size;       // taken by the tile buffers
+  uint64_t cycles;          // cost model estimate of the split
+} cvk_gemm_tiling_t;
+
+/*
+ * Elementwise op chain over global memory tensors, see eltwise_tiled
+ *
+ * Each step updates x, which starts as a, with y either b or const_val:
+ *   ADD  x = (x + y) >> rshift_bits
+ *   MUL  x = (x * y) >> rshift_bits
+ *   MAC  x = (x + b * const_val) >> rshift_bits
+ *   MAX  x = max(x, y)
+ *   MIN  x = min(x, y)
+ *   GE   x = x >= y
+ * then relu if relu_enable, ADD/MUL/MAC only. res receives the final x.
+ * Int8 or bf16, bf16 without rshift.
+ */
+#define CVK_ELTWISE_ADD           0
+#define CVK_ELTWISE_MUL           1
+#define CVK_ELTWISE_MAC           2
+#define CVK_ELTWISE_MAX           3
+#define CVK_ELTWISE_MIN           4
+#define CVK_ELTWISE_GE            5
+
+#define CVK_ELTWISE_MAX_STEPS     8
+
+typedef struct {
+  uint8_t op;               // CVK_ELTWISE_*
+  uint8_t b_is_const;       // y is const_val, MAC always reads b
+  int16_t const_val;        // 8-bit for int8 but in ADD, bf16 bits for bf16
+  uint8_t rshift_bits;
+  uint8_t relu_enable;
+} cvk_eltwise_step_t;
+
+typedef struct {
+  const cvk_tg_t *a;
+  const cvk_tg_t *b;        // optional if no step reads it
+  const cvk_tg_t *res;
+  const cvk_eltwise_step_t *steps;
+  uint32_t nr_steps;        // up to CVK_ELTWISE_MAX_STEPS
+  uint16_t layer_id;
+} cvk_eltwise_tiled_param_t;
+
+typedef struct {
+  uint32_t w;               // elements per lane row
+  uint32_t h_step;          // lane rows per tile
+  uint32_t nr_tiles;        // including the tail tiles
+  uint32_t lmem_size;       // taken by the tile buffers
+} cvk_eltwise_tiling_t;
+
+/*
+ * Pooling or depthwise convolution of global memory tensors, see pool_tiled
+ *
+ *   ifmap (n, c, ih, iw), ofmap (n, c, oh, ow)
+ * MAX, AVG and MIN as in tiu_max_pooling, tiu_average_pooling and
+ * tiu_min_pooling. DW as in tiu_depthwise_convolution, int8 with
+ * per-channel quantization:
+ *   weight (1, c, kh, kw), chl_quan_param (1, c, 1, 9 with bias or 5)
+ */
+#define CVK_POOL_MAX              0
+#define CVK_POOL_AVG              1
+#define CVK_POOL_MIN              2
+#define CVK_POOL_DW               3
+
+typedef struct {
+  uint8_t op;                       // CVK_POOL_*
+  const cvk_tg_t *ifmap;
+  const cvk_tg_t *weight;           // DW only
+  const cvk_tg_t *chl_quan_param;   // DW only
+  const cvk_tg_t *ofmap;
+  uint16_t kh, kw;
+  uint8_t pad_top, pad_bottom;
+  uint8_t pad_left, pad_right;
+  uint8_t stride_h, stride_w;
+  uint8_t dilation_h, dilation_w;   // DW only
+  uint16_t avg_pooling_const;       // AVG only
+  uint8_t rshift_bits;              // AVG only
+  uint8_t has_bias;                 // DW only
+  uint8_t relu_enable;              // DW only
+  int8_t ins_val;                   // padding value for int8
+  uint16_t ins_fp;                  // padding value for bf16
+  uint16_t layer_id;
+  uint8_t autotune;                 // rank splits by estimated cycles
+  cvk_tile_cache_t *cache;          // optional, autotune only
+} cvk_pool_tiled_param_t;
+
+typedef struct {
+  uint32_t n_step;
+  uint32_t c_step;
+  uint32_t oh_step;
+  uint32_t ow_step;
+  uint32_t nr_tiles;
+  uint32_t lmem_size;       // taken by the tile buffers
+  uint64_t cycles;          // cost model estimate of the split
+} cvk_pool_tiling_t;
+
+/*
+ * Estimated cost of emitted descriptors, see desc_cost
+ */
+typedef struct {
+  uint64_t cycles;
+  uint64_t macs;            // tiu, multiply-accumulates or element ops
+  uint64_t bytes;           // tdma, uncompressed
+} cvk_desc_cost_t;
+
+typedef struct {
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  uint64_t tiu_cycles;      // engine busy time, as if run back to back
+  uint64_t tdma_cycles;
+  uint64_t macs;
+  uint64_t tdma_bytes;
+} cvk_cmdbuf_cost_t;
+
+/*
+ * One descriptor replayed by cmdbuf_timeline, times in cycles
+ */
+#define CVK_STALL_NONE            0
+#define CVK_STALL_WAIT            1   // on wait_id of wait_engine_id
+#define CVK_STALL_SYNC            2   // on the other engines at a sync point
+
+typedef struct {
+  uint32_t engine_id;       // as in cvk_desc_template_t
+  uint16_t layer_id;
+  uint16_t id;              // own sync id
+  uint64_t start;
+  uint64_t end;
+  uint64_t stall;           // idle time of the engine right before start
+  uint32_t stall_reason;    // CVK_STALL_*
+  uint32_t wait_engine_id;
+  uint16_t wait_id;
+  uint32_t wait_desc;       // index of the descriptor waited for
+} cvk_timeline_event_t;
+
+typedef struct {
+  const uint8_t *cmdbuf;
+  uint32_t size;
+
+  // Cycles of one descriptor, desc_cost if NULL.
+  uint64_t (*cost)(void *arg, const cvk_desc_template_t *desc);
+  void *cost_arg;
+} cvk_timeline_param_t;
+
+typedef struct {
+  uint32_t nr_events;       // descriptors replayed
+  uint64_t cycles;          // end of the last descriptor
+  uint64_t tiu_busy;
+  uint64_t tdma_busy;
+  uint64_t tiu_stall;       // sum of the stalls of each engine
+  uint64_t tdma_stall;
+} cvk_timeline_t;
+
+/*
+ * Counters of the emitted commands, see stats_enable
+ */
+#define CVK_TDMA_G2L              0   // tdma direction
+#define CVK_TDMA_L2G              1
+#define CVK_TDMA_G2G              2
+#define CVK_TDMA_L2L              3
+#define CVK_TDMA_NR_DIRS          4
+
+#define CVK_TIU_CONV              0   // tiu op type
+#define CVK_TIU_DEPTHWISE_POOL    1
+#define CVK_TIU_MATMUL            2
+#define CVK_TIU_TENSOR_ARITH      3
+#define CVK_TIU_NR_TYPES          4
+
+typedef struct {
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  uint64_t tdma_bytes[CVK_TDMA_NR_DIRS];       // uncompressed
+  uint64_t tdma_cmpr_bytes[CVK_TDMA_NR_DIRS];  // of them through the codec
+  uint64_t tiu_macs[CVK_TIU_NR_TYPES];
+  uint32_t nr_check_failed;   // commands dropped on a wrong parameter
+  uint32_t lmem_high_water;   // as lmem_high_water
+  uint32_t nr_removed_waits;  // waits implied by in-order execution and
+                              // dropped, since reset
+} cvk_stats_t;
+
+typedef struct {
+  uint16_t layer_id;
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+} cvk_layer_stats_t;
+
+/*
+ * Record the TPU writes to the pmu buffer for each descriptor run,
+ * pmu_size bytes from dmabuf_size. Records are 16 bytes, little endian:
+ *   bits 0-3 type, 4-19 sync id, 20-41 and 42-63 event counters,
+ *   then the end and start times as 32-bit cycle counts.
+ * A zero type ends the records.
+ */
+#define CVK_PMU_RECORD_BYTES      16
+
+#define CVK_PMU_TDMA_LOAD         1   // record type
+#define CVK_PMU_TDMA_STORE        2
+#define CVK_PMU_TDMA_MOVE         3
+#define CVK_PMU_TIU               4
+
+#define CVK_PMU_NO_DESC           0xffffffff
+
+typedef struct {
+  uint32_t type;            // CVK_PMU_*
+  uint32_t engine_id;       // as in cvk_desc_template_t
+  uint32_t desc_index;      // among the descriptors of its engine in the
+                            // dmabuf, CVK_PMU_NO_DESC if none matches
+  uint16_t layer_id;
+  uint16_t id;              // sync id
+  uint32_t event_cnt[2];
+  uint64_t start;
+  uint64_t end;
+} cvk_pmu_event_t;
+
+typedef struct {
+  uint16_t layer_id;
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  uint64_t tiu_busy;        // cycles with a tiu descriptor of the layer running
+  uint64_t tdma_busy;
+  uint64_t overlap;         // cycles with both running
+  uint64_t span;            // from the first start to the last end
+  float overlap_ratio;      // overlap / min(tiu_busy, tdma_busy)
+} cvk_pmu_layer_t;
+
 /*
  * Miscellaneous helper function
  *   Not directly related to tiu/tdma operation
@@ -1141,6 +1521,287 @@ typedef struct {
   void (*bf16_table_shape)(
       struct cvikernel_context *ctx,
       cvk_tl_shape_t *shape);
+
+  // Same as acquire_cmdbuf, but returns the command buffer in place as a
+  // list of chunks instead of stitching them into one buffer.
+  // Returns the number of chunks, only max_chunks of them are filled.
+  uint32_t (*acquire_cmdbuf_chunks)(
+      struct cvikernel_context *ctx,
+      cvk_cmdbuf_chunk_t *chunks,
+      uint32_t max_chunks);
+
+  // Derive TIU/TDMA dependencies from the local memory each command reads
+  // and writes, instead of making every command wait for the other engine:
+  //     1. hazard_tracking_enable
+  //     2. tdma command (load A)
+  //     3. tdma command (load B)
+  //     4. tiu command (A -> C, waits for 2 only)
+  //     5. tdma command (store C, waits for 4)
+  //     6. tdma command (load A' into other space, no wait)
+  //     7. hazard_tracking_disable
+  // Overrides parallel_enable/parallel_disable until disabled.
+  // Only cv181x/cv180x provide them, NULL otherwise.
+  void (*hazard_tracking_enable)(struct cvikernel_context *ctx);
+  void (*hazard_tracking_disable)(struct cvikernel_context *ctx);
+
+  // Emit descriptors straight into the dmabuf layout loaded by the runtime,
+  // without the intermediate command buffer and dmabuf_convert copy.
+  // acquire_cmdbuf then returns the dmabuf itself, owned by the context and
+  // valid until the next command, reset or cleanup; the cmdbuf given at
+  // register is not used. Pmu buffer size follows from the header counts:
+  //   ALIGN((bd_desc_count + tdma_desc_count) * 16 + 1MB, 4KB)
+  // Must be called before the first command, returns -1 otherwise.
+  // Stays enabled across reset. Only cv181x/cv180x provide it.
+  int (*direct_dmabuf_enable)(struct cvikernel_context *ctx);
+
+  // Record-and-patch fast path for a command repeated with other operands,
+  // e.g. the same convolution on every tile of a layer:
+  //     1. tiu_convolution for the first tile
+  //     2. desc_template_capture(ctx, &t)
+  //     3. desc_template_emit(ctx, &t, &patch) for each following tile
+  // capture copies the last emitted descriptor. emit records a new one with
+  // dependencies as for any other command and only the addresses selected
+  // in patch->mask replaced, shapes, strides and the rest stay as captured
+  // and no parameter is checked again. Commands emitting several
+  // descriptors need one template each.
+  // Return 0 on success, -1 otherwise. Only cv181x/cv180x provide them.
+  int (*desc_template_capture)(
+      struct cvikernel_context *ctx,
+      cvk_desc_template_t *t);
+  int (*desc_template_emit)(
+      struct cvikernel_context *ctx,
+      const cvk_desc_template_t *t,
+      const cvk_desc_patch_t *patch);
+
+  // Local memory is a heap: lmem_free_tensor/lmem_free_matrix accept any
+  // order and allocations take the smallest hole that fits, so long-lived
+  // tensors can stay resident while others come and go around them.
+  // The bank variants place the tensor within bank_id, one of
+  // info.lmem_banks banks of info.lmem_bank_size bytes, NULL if it does
+  // not fit there. Freed as any other tensor.
+  cvk_tl_t *(*lmem_alloc_bank_tensor)(
+      struct cvikernel_context *ctx,
+      uint32_t bank_id,
+      cvk_tl_shape_t shape,
+      cvk_fmt_t fmt,
+      int eu_align);
+  cvk_ml_t *(*lmem_alloc_bank_matrix)(
+      struct cvikernel_context *ctx,
+      uint32_t bank_id,
+      cvk_ml_shape_t shape,
+      cvk_fmt_t fmt,
+      int eu_align);
+
+  // Highest local memory end address allocated since register or the last
+  // lmem_reset_high_water, i.e. the footprint of the allocations so far.
+  // Reset restarts from the tensors still allocated.
+  uint32_t (*lmem_high_water)(struct cvikernel_context *ctx);
+  void (*lmem_reset_high_water)(struct cvikernel_context *ctx);
+
+  // Largest local memory block an allocation outside any bank can get
+  // now, e.g. to size tiles next to tensors already allocated. Buffers of
+  // eu aligned sizes adding up to no more than it all fit.
+  uint32_t (*lmem_largest_free)(struct cvikernel_context *ctx);
+
+  // Commands dropped since register, on a wrong parameter or with no
+  // descriptor left in the cmdbuf, e.g. to check a sequence of commands
+  // that return nothing. Only cv181x/cv180x provide it, the others assert.
+  uint32_t (*nr_dropped_cmds)(struct cvikernel_context *ctx);
+
+  // Offline placement of tensors with known lifetimes, e.g. all tensors of
+  // a layer or tile sequence: tensors whose [first_use, last_use] op
+  // intervals overlap get disjoint local memory, the others may share it.
+  // Sizes and alignment follow lmem_tensor_to_size. Larger tensors are
+  // placed first, each into the smallest hole left by the tensors it
+  // overlaps with, to keep the peak low. Independent of lmem_alloc_tensor,
+  // the caller sets start_address/stride from the plan, e.g. with
+  // lmem_init_tensor.
+  // Returns the number of tensors that do not fit, -1 on invalid input.
+  // peak, if not NULL, receives the highest end address used.
+  int (*lmem_plan)(
+      struct cvikernel_context *ctx,
+      cvk_lmem_plan_tensor_t *tensors,
+      uint32_t nr_tensors,
+      uint32_t *peak);
+
+  // tiu_convolution and tiu_pt_convolution take the faster double conv
+  // path only if the ifmap and weight addresses are even and ifmap c is
+  // even and at least 4. lmem_alloc_*, lmem_alloc_bank_* and lmem_plan
+  // start every tensor EU aligned, so their tensors always meet the
+  // address conditions, only hand placed ones may not.
+  // conv_report counts the convolutions emitted for each layer_id, those
+  // replayed by desc_template_emit included, run either way and why single
+  // conv was taken (as the registers tell it), since register
+  // or the last conv_report_reset, across reset. Returns the number of
+  // layers in order of first convolution, only max_layers are filled.
+  // Only cv181x/cv180x provide them.
+  uint32_t (*conv_report)(
+      struct cvikernel_context *ctx,
+      cvk_conv_report_t *layers,
+      uint32_t max_layers);
+  void (*conv_report_reset)(struct cvikernel_context *ctx);
+
+  // Convolution of tensors in global memory, split into tiles whose local
+  // memory buffers fit next to the tensors the caller keeps allocated.
+  // Tiles are as large as possible, the split shrinks the batch first,
+  // then output channels in multiples of npu_num, output rows and output
+  // columns; ic is not split. Each ifmap tile carries the halo rows and
+  // columns its outputs read, padding only applies at the real edges.
+  // Tiles run as a ping-pong pipeline under parallel_enable: the load of
+  // tile i + 1 and the store of tile i - 1 overlap the convolution of tile
+  // i, and weights are only reloaded when the output channels change.
+  // With autotune every split that fits is ranked by the cycles an
+  // analytic model of the chip gives its pipeline, and the fastest one
+  // that allocates is taken. gemm_tiled and pool_tiled tune the same way.
+  // Splits are sized against lmem_largest_free, not lmem_size.
+  // Leaves parallel mode disabled.
+  // Returns 0, -1 on invalid param, if no split fits or if the backend
+  // dropped a command, see nr_dropped_cmds. tiling, if not NULL, receives
+  // the split taken.
+  int (*conv_tiled)(
+      struct cvikernel_context *ctx,
+      const cvk_conv_tiled_param_t *p,
+      cvk_conv_tiling_t *tiling);
+
+  // Matrix multiplication of matrices in global memory of any size, tiled
+  // like conv_tiled. K is split into partial sum passes accumulating in
+  // lmem_alloc_ps32_matrix space (ps32_mode 2, 3 ... 3, 1), bias, rshift
+  // and relu only apply on the last one. M and N are split so the double
+  // buffered left, right, bias and partial sum tiles fit, each split
+  // taken where it saves the most local memory.
+  // Leaves parallel mode disabled.
+  // Returns 0, -1 on invalid param, if no split fits or if the backend
+  // dropped a command, see nr_dropped_cmds. tiling, if not NULL, receives
+  // the split taken.
+  int (*gemm_tiled)(
+      struct cvikernel_context *ctx,
+      const cvk_gemm_tiled_param_t *p,
+      cvk_gemm_tiling_t *tiling);
+
+  // Elementwise op chain over tensors in global memory of any size. a, b
+  // and res must be compact, hold the same number of elements and share
+  // fmt; their shapes need not match, they are taken as flat arrays viewed
+  // as (1, npu_num, h, w) tiles so every lane works. The chain runs on
+  // each tile without leaving local memory, the tiles stream through a
+  // ring of three buffer sets under parallel_enable: the load of tile
+  // i + 1 and the store of tile i - 1 overlap the chain of tile i. With
+  // little local memory free, tiles drop to one row, then narrower rows.
+  // Leaves parallel mode disabled.
+  // Returns 0, -1 on invalid param, if no tile fits or if the backend
+  // dropped a command, see nr_dropped_cmds. tiling, if not NULL, receives
+  // the split taken.
+  int (*eltwise_tiled)(
+      struct cvikernel_context *ctx,
+      const cvk_eltwise_tiled_param_t *p,
+      cvk_eltwise_tiling_t *tiling);
+
+  // Pooling or depthwise convolution of tensors in global memory, tiled
+  // like conv_tiled with c in place of oc. The padding is applied in
+  // local memory per tile: tiles on the edges of the output get the
+  // rows and columns of padding their window reaches, inner tiles none,
+  // and neighbouring ifmap tiles overlap by the halo of the window, so
+  // the ifmap is read as is and never padded in global memory.
+  // Depthwise weights are only reloaded when the channels change.
+  // Leaves parallel mode disabled.
+  // Returns 0, -1 on invalid param (a MIN window of one element is, as in
+  // tiu_min_pooling), if no split fits or if the backend dropped a
+  // command, see nr_dropped_cmds. tiling, if not NULL, receives the split
+  // taken.
+  int (*pool_tiled)(
+      struct cvikernel_context *ctx,
+      const cvk_pool_tiled_param_t *p,
+      cvk_pool_tiling_t *tiling);
+
+  // Analytic cost of emitted descriptors, from the register fields alone:
+  // tiu time follows the op type, result shape, kernel size and input
+  // channels spread over the chip's lanes and EUs, halved in the channels
+  // by double conv; tdma time follows the bytes moved in bursts of the
+  // contiguous runs of the global memory side, element by element for
+  // transposes and at the codec rate when compressed. Both include a
+  // fixed per descriptor overhead. Nominal figures, good for comparing
+  // alternatives rather than as absolute time.
+  // desc_cost takes one descriptor, e.g. from desc_template_capture.
+  // cmdbuf_cost sums every descriptor of a cmdbuf from acquire_cmdbuf per
+  // engine, the busy time of each engine as if it ran back to back, with
+  // neither overlap between the engines nor stalls on their waits.
+  // Return 0, -1 on an unknown engine or malformed cmdbuf.
+  // Only cv181x/cv180x provide them.
+  int (*desc_cost)(
+      struct cvikernel_context *ctx,
+      const cvk_desc_template_t *desc,
+      cvk_desc_cost_t *cost);
+  int (*cmdbuf_cost)(
+      struct cvikernel_context *ctx,
+      const uint8_t *cmdbuf,
+      uint32_t size,
+      cvk_cmdbuf_cost_t *cost);
+
+  // Replay a cmdbuf from acquire_cmdbuf on in-order engine queues: a
+  // descriptor starts when its engine is done with the previous one and
+  // the descriptor of the other engine its wait id names has ended. At a
+  // sync point, where the ids restart, every engine waits for all others.
+  // Each stall is attributed to the wait that caused it, e.g. a tiu
+  // stalled on a load that parallel mode failed to overlap.
+  // Fills up to max_events events in cmdbuf order, summary, if not NULL,
+  // receives the totals. Returns 0, -1 on a malformed cmdbuf.
+  // timeline_trace writes events as Chrome trace JSON to path, one
+  // thread per engine with slices named by layer_id and the stalls as
+  // slices of their own, ts and dur are cycles. Returns 0, -1 if path
+  // cannot be written.
+  // Only cv181x/cv180x provide them.
+  int (*cmdbuf_timeline)(
+      struct cvikernel_context *ctx,
+      const cvk_timeline_param_t *p,
+      cvk_timeline_event_t *events,
+      uint32_t max_events,
+      cvk_timeline_t *summary);
+  int (*timeline_trace)(
+      struct cvikernel_context *ctx,
+      const cvk_timeline_event_t *events,
+      uint32_t nr_events,
+      const char *path);
+
+  // Counters updated as commands are emitted, off by default. Descriptors
+  // are counted per engine and per layer_id, tdma bytes per direction
+  // and tiu MACs per op type as in desc_cost. They accumulate while
+  // enabled, across reset, until stats_reset. lmem_high_water and
+  // nr_removed_waits are read at the call, whether enabled or not.
+  // stats fills stats, if not NULL, and the first max_layers layers in
+  // order of first descriptor, returns the number of layers.
+  // Only cv181x/cv180x provide them.
+  void (*stats_enable)(struct cvikernel_context *ctx);
+  void (*stats_disable)(struct cvikernel_context *ctx);
+  uint32_t (*stats)(
+      struct cvikernel_context *ctx,
+      cvk_stats_t *stats,
+      cvk_layer_stats_t *layers,
+      uint32_t max_layers);
+  void (*stats_reset)(struct cvikernel_context *ctx);
+
+  // Map the pmu records of a run back to the descriptors of its dmabuf,
+  // e.g. a dump of the pmu buffer: each record is matched by engine and
+  // sync id to the next descriptor of that engine in dmabuf order, which
+  // gives its index and layer_id. Fills up to max_events events in
+  // record order, nr_events receives the number of records.
+  // Returns 0, -1 on a malformed dmabuf.
+  // pmu_layer_report sums the events per layer_id, in order of first
+  // event, and returns the number of layers, up to max_layers are filled.
+  // Only cv181x/cv180x and cv182x provide them.
+  int (*pmu_decode)(
+      struct cvikernel_context *ctx,
+      const uint8_t *dmabuf,
+      uint32_t dmabuf_size,
+      const uint8_t *pmu,
+      uint32_t pmu_size,
+      cvk_pmu_event_t *events,
+      uint32_t max_events,
+      uint32_t *nr_events);
+  uint32_t (*pmu_layer_report)(
+      struct cvikernel_context *ctx,
+      const cvk_pmu_event_t *events,
+      uint32_t nr_events,
+      cvk_pmu_layer_t *layers,
+      uint32_t max_layers);
 } cvk_misc_operations_t;
 
 /*
@@ -1155,7 +1816,15 @@ typedef struct cvikernel_context {
 
 /*
  * Register information
+ *
+ * If cmdbuf is NULL, the kernel context allocates the command buffer itself
+ * and grows it on demand as a chain of cmdbuf_size-byte chunks
+ * (CVK_CMDBUF_CHUNK_SIZE if cmdbuf_size is 0). acquire_cmdbuf then returns a
+ * buffer owned by the context, valid until the next reset or cleanup.
+ * Only supported by cv181x and cv180x.
  */
+#define CVK_CMDBUF_CHUNK_SIZE   (1 << 20)
+
 typedef struct cvikernel_register_info {
   char chip_ver_str[16];
   uint32_t cmdbuf_size;
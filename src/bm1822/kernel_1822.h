@@ -41,6 +41,10 @@ typedef bmk1822_matrix_tgmem_t mg_t;
 typedef bmk1822_compressed_tensor_tgmem_t compressed_tg_t;
 typedef bmk1822_compressed_matrix_tgmem_t compressed_mg_t;
 
+// Tensor and matrix descriptors share one pool per context.
+#define TL_ML_POOL_OBJ_SIZE \
+  (sizeof(tl_t) > sizeof(ml_t) ? sizeof(tl_t) : sizeof(ml_t))
+
 desc_pair_t * bm1822_get_desc_pair(ctx_t *k, uint8_t eng_id);
 
 static inline void assert_same_stride(const tl_t *a, const tl_t *b)
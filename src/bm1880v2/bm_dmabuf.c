@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "kernel_1880v2.h"
+#include "parallel_for.h"
 #include <bmkernel/bm1880v2/bmkernel_1880v2.h>
 #include <bmkernel/bm1880v2/bm1880v2_tiu_reg.h>
 #include <bmkernel/bm1880v2/bm1880v2_tdma_reg.h>
@@ -20,11 +21,6 @@
 #define BD_EOD_PADDING_BYTES (128)
 #define TPU_DMABUF_HEADER_M  0xB5B5
 
-typedef struct {
-  cmd_hdr_t hdr;
-  uint32_t body[0];
-} DESC;
-
 // CPU_OP_SYNC structure
 typedef struct {
   uint32_t op_type;
@@ -37,28 +33,58 @@ typedef struct {
   char str[CPU_ENGINE_STR_LIMIT_BYTE];
 } __attribute__((packed)) cvi_cpu_desc_t;
 
-static DESC *traverse_start(uint8_t *cmdbuf)
-{
-  ASSERT(cmdbuf);
-  DESC *desc = (DESC *)cmdbuf;
-  ASSERT(desc->hdr.magic == CMDBUF_HDR_MAGIC_1880v2);
-  return desc;
-}
+#define PER_DES_SIZE 16
+#define PADDING_SIZE (1024 * 1024)
 
-static DESC *traverse_next(DESC *desc, uint8_t *cmdbuf, uint32_t size)
-{
-  DESC *next_desc = (DESC *)((uint8_t *)desc + cmd_hdr_len(&desc->hdr) + sizeof(cmd_hdr_t));
-  if ((uint8_t *)next_desc >= cmdbuf + size)
-    return NULL;
-  ASSERT(next_desc->hdr.magic == CMDBUF_HDR_MAGIC_1880v2);
-  return next_desc;
-}
+// One command buffer descriptor, found by a single walk over cmdbuf.
+typedef struct {
+  uint32_t offset;    // of cmd_hdr_t in cmdbuf
+  uint16_t sync_id;
+  uint8_t engine_id;
+  uint8_t len;
+} dmabuf_desc_index_t;
 
-static bool is_last_desc(DESC *desc, uint8_t *cmdbuf, uint32_t size)
-{
-  DESC *next_desc = traverse_next(desc, cmdbuf, size);
-  return next_desc ? false : true;
-}
+// Descriptors run between two cpu sync descs, and where they go.
+typedef struct {
+  uint32_t first_desc;
+  uint32_t nr_desc;
+  int32_t cpu_desc;     // cpu desc closing the segment, -1 if inserted
+  uint32_t num_tiu;
+  uint32_t num_tdma;
+  uint32_t tiu_offset;  // in dmabuf
+  uint32_t tdma_offset;
+} dmabuf_segment_t;
+
+// Descriptors of one segment filled by one task.
+#define DMABUF_CHUNK_NR_DESC 4096
+
+typedef struct {
+  uint32_t first_desc;
+  uint32_t nr_desc;
+  uint32_t tiu_offset;  // in dmabuf
+  uint32_t tdma_offset;
+  uint32_t tiu_num;     // left in segment at first_desc
+  uint32_t tdma_num;
+} dmabuf_chunk_t;
+
+struct bmk1880v2_dmabuf_index {
+  uint8_t *cmdbuf;
+
+  uint32_t nr_desc;
+  uint32_t max_nr_desc;
+  dmabuf_desc_index_t *desc;
+
+  uint32_t nr_segments;
+  uint32_t max_nr_segments;
+  dmabuf_segment_t *segments;
+
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  uint32_t tiu_offset;
+  uint32_t tdma_offset;
+  uint32_t dmabuf_size;
+  uint32_t pmu_size;
+};
 
 static void reorder_bd_cmdbuf_reg(uint8_t *cmdbuf)
 {
@@ -96,251 +122,376 @@ static void adjust_desc_bd(uint32_t *body, bool eod)
 }
 
 
-static uint32_t desc_sync_id(DESC *desc)
+// Own sync id, read without parsing the whole register.
+static uint16_t desc_sync_id(cmd_hdr_t *hdr)
 {
-  switch (desc->hdr.engine_id) {
-    case BMK1880v2_TIU: {
-      tiu_reg_t reg;
-      parse_tiu_reg(&reg, desc->body);
-      return reg.cmd_id_tpu;
-    }
-    case BMK1880v2_TDMA: {
-      tdma_reg_t reg;
-      parse_tdma_reg(&reg, desc->body);
-      return reg.cmd_id;
-    }
+  const uint32_t *p = (const uint32_t *)hdr->cmd;
+
+  switch (hdr->engine_id) {
+    case BMK1880v2_TIU:
+      return (p[0] >> 3) & 0xFFFF;
+    case BMK1880v2_TDMA:
+      return p[0] >> 16;
     default:
       ASSERT(0);
       return 1;
   }
 }
 
-static void fill_header_and_arm(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf, uint64_t *tiu_offset, uint64_t *tdma_offset)
+static dmabuf_desc_index_t *index_add_desc(bmk1880v2_dmabuf_index_t *idx)
 {
-  dma_hdr_t header = {0};
-  header.dmabuf_magic_m = TPU_DMABUF_HEADER_M;
-  header.dmabuf_magic_s = 0x1835;
+  if (idx->nr_desc == idx->max_nr_desc) {
+    idx->max_nr_desc = idx->max_nr_desc ? idx->max_nr_desc * 2 : 1024;
+    idx->desc = realloc(idx->desc, idx->max_nr_desc * sizeof(idx->desc[0]));
+    ASSERT(idx->desc);
+  }
+
+  return &idx->desc[idx->nr_desc++];
+}
+
+static void index_close_segment(
+    bmk1880v2_dmabuf_index_t *idx,
+    uint32_t first_desc,
+    int32_t cpu_desc,
+    uint32_t counters[])
+{
+  if (idx->nr_segments == idx->max_nr_segments) {
+    idx->max_nr_segments = idx->max_nr_segments ? idx->max_nr_segments * 2 : 64;
+    idx->segments = realloc(idx->segments,
+                            idx->max_nr_segments * sizeof(idx->segments[0]));
+    ASSERT(idx->segments);
+  }
+
+  dmabuf_segment_t *seg = &idx->segments[idx->nr_segments++];
+  seg->first_desc = first_desc;
+  seg->nr_desc = idx->nr_desc - first_desc;
+  seg->cpu_desc = cpu_desc;
+  seg->num_tiu = counters[BMK1880v2_TIU];
+  seg->num_tdma = counters[BMK1880v2_TDMA];
+
+  idx->nr_tiu += seg->num_tiu;
+  idx->nr_tdma += seg->num_tdma;
+  counters[BMK1880v2_TIU] = 0;
+  counters[BMK1880v2_TDMA] = 0;
+}
+
+// Place the tiu and tdma descriptors of every segment in the dmabuf.
+static void index_layout(bmk1880v2_dmabuf_index_t *idx)
+{
+  uint32_t tiu_size = 0;
+  uint32_t tdma_size = 0;
+
+  // dma hdr + arm descs + bd descs + tdma descs
+  idx->tiu_offset = ALIGN((uint32_t)sizeof(dma_hdr_t) +
+                          idx->nr_segments * CPU_ENGINE_BYTES,
+                          BD_DESC_ALIGN_SIZE);
+
+  for (uint32_t i = 0; i < idx->nr_segments; i++) {
+    dmabuf_segment_t *seg = &idx->segments[i];
+
+    seg->tiu_offset = idx->tiu_offset + tiu_size;
+    if (seg->num_tiu)
+      tiu_size = ALIGN(tiu_size + seg->num_tiu * BD_REG_BYTES + BD_EOD_PADDING_BYTES,
+                       BD_DESC_ALIGN_SIZE);
+
+    seg->tdma_offset = tdma_size;
+    tdma_size += seg->num_tdma * GDMA_DESC_ALIGN_SIZE;
+  }
+
+  idx->tdma_offset = ALIGN(idx->tiu_offset + tiu_size, GDMA_DESC_ALIGN_SIZE);
+  for (uint32_t i = 0; i < idx->nr_segments; i++)
+    idx->segments[i].tdma_offset += idx->tdma_offset;
+
+  idx->dmabuf_size = idx->tdma_offset + tdma_size;
+  idx->pmu_size = ALIGN((idx->nr_tiu + idx->nr_tdma) * PER_DES_SIZE + PADDING_SIZE,
+                        0x1000);
+}
+
+bmk1880v2_dmabuf_index_t *bmk1880v2_dmabuf_index_create(uint8_t *cmdbuf, uint32_t sz)
+{
+  ASSERT(cmdbuf);
+
+  bmk1880v2_dmabuf_index_t *idx = xmalloc(sizeof(*idx));
+  memset(idx, 0, sizeof(*idx));
+  idx->cmdbuf = cmdbuf;
 
-  cvi_cpu_desc_t *segments = (cvi_cpu_desc_t *)(dmabuf + sizeof(dma_hdr_t));
-  DESC *desc = NULL;
-  uint32_t desc_nums[BMK1880v2_ENGINE_NUM] = {0};
   uint32_t counters[BMK1880v2_ENGINE_NUM] = {0};
-  uint32_t desc_size[BMK1880v2_ENGINE_NUM] = {0};
+  uint32_t first_desc = 0;
+  uint32_t offset = 0;
+
+  while (offset < sz) {
+    cmd_hdr_t *hdr = (cmd_hdr_t *)(cmdbuf + offset);
+    ASSERT(hdr->magic == CMDBUF_HDR_MAGIC_1880v2);
 
-  ASSERT(segments);
-  // fill arm descs
-  desc = traverse_start(cmdbuf);
+    uint32_t engine_id = (uint32_t)hdr->engine_id;
+    uint32_t next = offset + sizeof(cmd_hdr_t) + cmd_hdr_len(hdr);
+
+    dmabuf_desc_index_t *d = index_add_desc(idx);
+    d->offset = offset;
+    d->engine_id = engine_id;
+    d->len = hdr->len;
+    d->sync_id = 0;
 
-  while (desc != NULL) {
-    uint32_t engine_id = (uint32_t)desc->hdr.engine_id;
-    counters[engine_id]++;
-    desc_nums[engine_id]++;
     if (engine_id != BMK1880v2_CPU) {
+      counters[engine_id]++;
+      d->sync_id = desc_sync_id(hdr);
+
       // a new arm desc inserted to do sync operation
-      if (desc_sync_id(desc) == 0xFFFF || is_last_desc(desc, cmdbuf, sz)) {
-        desc_nums[BMK1880v2_CPU]++;
-        cvi_cpu_desc_t *arm = segments + desc_nums[BMK1880v2_CPU] - 1;
-        memset(arm, 0, sizeof(cvi_cpu_desc_t));
-        arm->op_type = CPU_OP_SYNC;
-        arm->num_tiu = counters[BMK1880v2_TIU];
-        arm->num_tdma = counters[BMK1880v2_TDMA];
-        strncpy(arm->str, "layer_end", sizeof(arm->str) - 1);
-        if (counters[BMK1880v2_TIU] != 0) {
-          desc_size[BMK1880v2_TIU] =
-              ALIGN(desc_size[BMK1880v2_TIU] + counters[BMK1880v2_TIU] * BD_REG_BYTES + BD_EOD_PADDING_BYTES,
-                    BD_DESC_ALIGN_SIZE);
-        }
-        counters[BMK1880v2_TIU] = 0;
-        counters[BMK1880v2_TDMA] = 0;
+      if (d->sync_id == 0xFFFF || next >= sz) {
+        index_close_segment(idx, first_desc, -1, counters);
+        first_desc = idx->nr_desc;
       }
     } else {
-      cvi_cpu_desc_t *arm = segments + desc_nums[BMK1880v2_CPU] - 1;
-      memcpy(arm, &(desc->body), sizeof(cvi_cpu_desc_t));
-      arm->num_tiu = counters[BMK1880v2_TIU];
-      arm->num_tdma = counters[BMK1880v2_TDMA];
-      if (counters[BMK1880v2_TIU] != 0) {
-        desc_size[BMK1880v2_TIU] =
-            ALIGN(desc_size[BMK1880v2_TIU] + counters[BMK1880v2_TIU] * BD_REG_BYTES + BD_EOD_PADDING_BYTES,
-                  BD_DESC_ALIGN_SIZE);
-      }
-      counters[BMK1880v2_TIU] = 0;
-      counters[BMK1880v2_TDMA] = 0;
+      index_close_segment(idx, first_desc, idx->nr_desc - 1, counters);
+      first_desc = idx->nr_desc;
     }
-    desc = traverse_next(desc, cmdbuf, sz);
+
+    offset = next;
   }
-  desc_size[BMK1880v2_CPU] = desc_nums[BMK1880v2_CPU] * CPU_ENGINE_BYTES;
-  desc_size[BMK1880v2_TDMA] = desc_nums[BMK1880v2_TDMA] * GDMA_DESC_ALIGN_SIZE;
 
-  (*tiu_offset) = ALIGN(sizeof(header) + desc_size[BMK1880v2_CPU], BD_DESC_ALIGN_SIZE);
-  (*tdma_offset) = ALIGN((*tiu_offset) + desc_size[BMK1880v2_TIU], GDMA_DESC_ALIGN_SIZE);
+  index_layout(idx);
+  return idx;
+}
 
-  // dma hdr + arm descs + bd descs + tdma descs
-  header.dmabuf_size = (*tdma_offset) + desc_size[BMK1880v2_TDMA];
-  header.cpu_desc_count = desc_nums[BMK1880v2_CPU];
-  header.bd_desc_count = desc_nums[BMK1880v2_TIU];
-  header.tdma_desc_count = desc_nums[BMK1880v2_TDMA];
+void bmk1880v2_dmabuf_index_destroy(bmk1880v2_dmabuf_index_t *idx)
+{
+  if (!idx)
+    return;
+
+  free(idx->desc);
+  free(idx->segments);
+  free(idx);
+}
+
+void bmk1880v2_dmabuf_index_size(
+    const bmk1880v2_dmabuf_index_t *idx,
+    uint32_t *psize,
+    uint32_t *pmu_size)
+{
+  *psize = idx->dmabuf_size;
+  *pmu_size = idx->pmu_size;
+}
+
+static void fill_header(const bmk1880v2_dmabuf_index_t *idx, uint8_t *dmabuf)
+{
+  dma_hdr_t header = {0};
+  header.dmabuf_magic_m = TPU_DMABUF_HEADER_M;
+  header.dmabuf_magic_s = 0x1835;
+  header.dmabuf_size = idx->dmabuf_size;
+  header.cpu_desc_count = idx->nr_segments;
+  header.bd_desc_count = idx->nr_tiu;
+  header.tdma_desc_count = idx->nr_tdma;
 
   //printf("header.dmabuf_size = %d\n", header.dmabuf_size);
   printf("header.cpu_desc_count = %d\n", header.cpu_desc_count);
   printf("header.bd_desc_count = %d\n", header.bd_desc_count);
   printf("header.tdma_desc_count = %d\n", header.tdma_desc_count);
+
   memcpy(dmabuf, &header, sizeof(header));
 }
 
-static void fill_bd_and_tdma(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf, uint64_t tiu_offset, uint64_t tdma_offset)
+static void fill_arm(
+    const bmk1880v2_dmabuf_index_t *idx,
+    const dmabuf_segment_t *seg,
+    cvi_cpu_desc_t *arm)
 {
-  dma_hdr_t *p_header = (dma_hdr_t *)dmabuf;
-  cvi_cpu_desc_t *segments = (cvi_cpu_desc_t *)(dmabuf + sizeof(dma_hdr_t));
-  DESC *desc = traverse_start(cmdbuf);
-  //uint64_t address_max = 0x100000000;
-
-  for (uint32_t i = 0; i < p_header->cpu_desc_count; i++) {
-
-    cvi_cpu_desc_t *arm = segments + i;
+  if (seg->cpu_desc >= 0) {
+    const dmabuf_desc_index_t *d = &idx->desc[seg->cpu_desc];
+    memcpy(arm, idx->cmdbuf + d->offset + sizeof(cmd_hdr_t), sizeof(cvi_cpu_desc_t));
+  } else {
+    memset(arm, 0, sizeof(cvi_cpu_desc_t));
+    arm->op_type = CPU_OP_SYNC;
+    strncpy(arm->str, "layer_end", sizeof(arm->str) - 1);
+  }
 
-    uint32_t tiu_num = arm->num_tiu & 0xFFFF;
-    uint32_t tdma_num = arm->num_tdma & 0xFFFF;
+  arm->num_tiu = seg->num_tiu;
+  arm->num_tdma = seg->num_tdma;
+  if (seg->num_tiu)
+    arm->offset_tiu = seg->tiu_offset;
+  if (seg->num_tdma)
+    arm->offset_tdma = seg->tdma_offset;
+}
 
-    if (tiu_num) {
-      tiu_offset = ALIGN(tiu_offset, 1 << BDC_ENGINE_CMD_ALIGNED_BIT);
-      arm->offset_tiu = tiu_offset;
-      //printf("arm->offset_tiu = 0x%x \n", arm->offset_tiu);
+// Fill nr_desc descriptors from first_desc on. tiu_num/tdma_num are the
+// descriptors of their segment left at first_desc, the last one is EOD.
+static void fill_descs(
+    const bmk1880v2_dmabuf_index_t *idx,
+    const dmabuf_chunk_t *chunk,
+    uint8_t *dmabuf)
+{
+  uint32_t tiu_offset = chunk->tiu_offset;
+  uint32_t tdma_offset = chunk->tdma_offset;
+  uint32_t tiu_num = chunk->tiu_num;
+  uint32_t tdma_num = chunk->tdma_num;
+
+  for (uint32_t i = 0; i < chunk->nr_desc; i++) {
+    const dmabuf_desc_index_t *d = &idx->desc[chunk->first_desc + i];
+    const uint8_t *body = idx->cmdbuf + d->offset + sizeof(cmd_hdr_t);
+    void *p_body = NULL;
+
+    switch (d->engine_id) {
+      case BMK1880v2_TIU:
+        tiu_num--;
+        p_body = (void *)(dmabuf + tiu_offset);
+        tiu_offset += BD_REG_BYTES;
+        memcpy(p_body, body, d->len);
+        adjust_desc_bd((uint32_t *)p_body, tiu_num == 0);
+        break;
+      case BMK1880v2_TDMA:
+        tdma_num--;
+        p_body = (void *)(dmabuf + tdma_offset);
+        tdma_offset += GDMA_DESC_ALIGN_SIZE;
+        memcpy(p_body, body, d->len);
+        adjust_desc_tdma((uint32_t *)p_body, tdma_num == 0);
+        break;
+      default:
+        break;
     }
+  }
+}
 
-    if (tdma_num) {
-      tdma_offset = ALIGN(tdma_offset, 1 << TDMA_DESCRIPTOR_ALIGNED_BIT);
-      arm->offset_tdma = tdma_offset;
-      //printf("arm->offset_tdma = 0x%x \n", arm->offset_tdma);
+// Split segments into chunks of at most DMABUF_CHUNK_NR_DESC descriptors,
+// each one knows where its descriptors go and can be filled on its own.
+static dmabuf_chunk_t *split_chunks(
+    const bmk1880v2_dmabuf_index_t *idx,
+    uint32_t *nr_chunks)
+{
+  uint32_t max_nr_chunks = idx->nr_segments + idx->nr_desc / DMABUF_CHUNK_NR_DESC;
+  dmabuf_chunk_t *chunks = xmalloc((max_nr_chunks + 1) * sizeof(chunks[0]));
+  uint32_t n = 0;
+
+  for (uint32_t si = 0; si < idx->nr_segments; si++) {
+    const dmabuf_segment_t *seg = &idx->segments[si];
+    uint32_t tiu_offset = seg->tiu_offset;
+    uint32_t tdma_offset = seg->tdma_offset;
+    uint32_t tiu_num = seg->num_tiu;
+    uint32_t tdma_num = seg->num_tdma;
+
+    for (uint32_t i = 0; i < seg->nr_desc; i += DMABUF_CHUNK_NR_DESC) {
+      dmabuf_chunk_t *chunk = &chunks[n++];
+      chunk->first_desc = seg->first_desc + i;
+      chunk->nr_desc = seg->nr_desc - i;
+      if (chunk->nr_desc > DMABUF_CHUNK_NR_DESC)
+        chunk->nr_desc = DMABUF_CHUNK_NR_DESC;
+      chunk->tiu_offset = tiu_offset;
+      chunk->tdma_offset = tdma_offset;
+      chunk->tiu_num = tiu_num;
+      chunk->tdma_num = tdma_num;
+
+      for (uint32_t j = 0; j < chunk->nr_desc; j++) {
+        switch (idx->desc[chunk->first_desc + j].engine_id) {
+          case BMK1880v2_TIU:
+            tiu_offset += BD_REG_BYTES;
+            tiu_num--;
+            break;
+          case BMK1880v2_TDMA:
+            tdma_offset += GDMA_DESC_ALIGN_SIZE;
+            tdma_num--;
+            break;
+          default:
+            break;
+        }
+      }
     }
+  }
+
+  *nr_chunks = n;
+  return chunks;
+}
+
+typedef struct {
+  const bmk1880v2_dmabuf_index_t *idx;
+  const dmabuf_chunk_t *chunks;
+  uint8_t *dmabuf;
+} convert_task_t;
 
-    while (tiu_num || tdma_num) {
-      uint32_t engine_id = (uint32_t)desc->hdr.engine_id;
-      void *p_body = NULL;
-
-      switch (engine_id) {
-        case BMK1880v2_TIU:
-          tiu_num--;
-          p_body = (void *)(dmabuf + tiu_offset);
-          tiu_offset += BD_REG_BYTES;
-          memcpy(p_body, desc->body, desc->hdr.len);
-          adjust_desc_bd((uint32_t *)p_body, tiu_num == 0);
-          break;
-        case BMK1880v2_TDMA:
-          tdma_num--;
-          tdma_offset = ALIGN(tdma_offset, GDMA_DESC_ALIGN_SIZE);
-          p_body = (void *)(dmabuf + tdma_offset);
-          tdma_offset += GDMA_DESC_ALIGN_SIZE;
-          memcpy(p_body, desc->body, desc->hdr.len);
-
-#if 0 //debug feature, for checking if neuron overshoot
+static void convert_chunk(void *arg, uint32_t i)
 {
-          tdma_reg_t reg_tdma = {0};
-          uint64_t tdma_address = 0, tdma_address2 = 0;
-
-          parse_tdma_reg(&reg_tdma, p_body);
-
-          if (reg_tdma.src_base_reg_sel == 0) {
-            //  reg.trans_dir = 2; // 0:tg2l, 1:l2tg, 2:g2g, 3:l2l
-            if (reg_tdma.trans_dir == 0) {
-              printf ("src_base_addr_high=%x, src_base_addr_low=%x\n", reg_tdma.src_base_addr_high, reg_tdma.src_base_addr_low);
-              tdma_address = ((uint64_t)reg_tdma.src_base_addr_high) << 32 | (uint64_t)reg_tdma.src_base_addr_low;
-            } else if (reg_tdma.trans_dir == 1) {
-              printf ("dst_base_addr_high=%x, dst_base_addr_low=%x\n", reg_tdma.dst_base_addr_high, reg_tdma.dst_base_addr_low);
-              tdma_address = ((uint64_t)reg_tdma.dst_base_addr_high) << 32 | (uint64_t)reg_tdma.dst_base_addr_low;
-            } else if (reg_tdma.trans_dir == 2) {
-              printf ("dst_base_addr_high=%x, dst_base_addr_low=%x\n", reg_tdma.dst_base_addr_high, reg_tdma.dst_base_addr_low);
-              tdma_address = ((uint64_t)reg_tdma.src_base_addr_high) << 32 | (uint64_t)reg_tdma.src_base_addr_low;
-              tdma_address2 = ((uint64_t)reg_tdma.dst_base_addr_high) << 32 | (uint64_t)reg_tdma.dst_base_addr_low;
-
-              if (tdma_address2 > tdma_address) {
-                tdma_address = tdma_address2;
-              }
-            }
-
-            if (tdma_address > address_max) {
-              address_max = tdma_address;
-              printf("address_max=%llx\n", address_max);
-            }
-          }
+  convert_task_t *t = (convert_task_t *)arg;
+
+  fill_descs(t->idx, &t->chunks[i], t->dmabuf);
 }
-#endif
-          adjust_desc_tdma((uint32_t *)p_body, tdma_num == 0);
-          break;
-        default:
-          break;
-      }
-      desc = traverse_next(desc, cmdbuf, sz);
-    }
+
+void bmk1880v2_dmabuf_index_convert_dispatch(
+    const bmk1880v2_dmabuf_index_t *idx,
+    uint8_t *dmabuf,
+    bmk_dispatch_fn_t dispatch,
+    void *dispatch_ctx)
+{
+  cvi_cpu_desc_t *segments = (cvi_cpu_desc_t *)(dmabuf + sizeof(dma_hdr_t));
+
+  fill_header(idx, dmabuf);
+
+  for (uint32_t i = 0; i < idx->nr_segments; i++) {
+    const dmabuf_segment_t *seg = &idx->segments[i];
+
+    fill_arm(idx, seg, segments + i);
 
     // padding zero after eod to workaroud hardware bug
-    if (arm->num_tiu & 0xFFFF) {
-      void *buf = (void *)(dmabuf + tiu_offset);
-      memset(buf, 0, BD_EOD_PADDING_BYTES);
-      tiu_offset += BD_EOD_PADDING_BYTES;
-    }
+    if (seg->num_tiu)
+      memset(dmabuf + seg->tiu_offset + seg->num_tiu * BD_REG_BYTES, 0,
+             BD_EOD_PADDING_BYTES);
+  }
+
+  uint32_t nr_chunks = 0;
+  dmabuf_chunk_t *chunks = split_chunks(idx, &nr_chunks);
+  convert_task_t t = {idx, chunks, dmabuf};
+
+  if (dispatch) {
+    dispatch(dispatch_ctx, convert_chunk, &t, nr_chunks);
+  } else {
+    for (uint32_t i = 0; i < nr_chunks; i++)
+      convert_chunk(&t, i);
   }
+
+  free(chunks);
 }
 
-void bmk1880v2_dmabuf_convert(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf)
+void bmk1880v2_dmabuf_index_convert(const bmk1880v2_dmabuf_index_t *idx, uint8_t *dmabuf)
 {
-  uint64_t tiu_offset = 0;
-  uint64_t tdma_offset = 0;
-  fill_header_and_arm(cmdbuf, sz, dmabuf, &tiu_offset, &tdma_offset);
-  fill_bd_and_tdma(cmdbuf, sz, dmabuf, tiu_offset, tdma_offset);
+  bmk1880v2_dmabuf_index_convert_dispatch(idx, dmabuf, NULL, NULL);
 }
 
-#define PER_DES_SIZE 16
-#define PADDING_SIZE (1024 * 1024)
-void bmk1880v2_dmabuf_size(uint8_t *cmdbuf, uint32_t sz, uint32_t *psize, uint32_t *pmu_size)
+static void dispatch_threads(
+    void *dispatch_ctx,
+    bmk_task_fn_t task,
+    void *arg,
+    uint32_t nr_tasks)
 {
-  uint32_t tdma_desc_num = {0};
-  uint32_t counters[BMK1880v2_ENGINE_NUM] = {0};
-  uint32_t bd_size = 0;
-  uint32_t dmabuf_size = 0;
+  parallel_for(*(uint32_t *)dispatch_ctx, task, arg, nr_tasks);
+}
 
-  uint32_t tiu_cnt = 0;
-  uint32_t tdma_cnt = 0;
+void bmk1880v2_dmabuf_index_convert_mt(
+    const bmk1880v2_dmabuf_index_t *idx,
+    uint8_t *dmabuf,
+    uint32_t nr_threads)
+{
+  bmk1880v2_dmabuf_index_convert_dispatch(idx, dmabuf, dispatch_threads, &nr_threads);
+}
 
-  // calculate desc numbers
-  DESC *desc = traverse_start(cmdbuf);
+void bmk1880v2_dmabuf_convert(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf)
+{
+  bmk1880v2_dmabuf_index_t *idx = bmk1880v2_dmabuf_index_create(cmdbuf, sz);
+  bmk1880v2_dmabuf_index_convert(idx, dmabuf);
+  bmk1880v2_dmabuf_index_destroy(idx);
+}
 
-  while (desc != NULL) {
-    uint32_t engine_id = (uint32_t)desc->hdr.engine_id;
-    counters[engine_id]++;
-    if (engine_id != BMK1880v2_CPU) {
-      // a new arm desc inserted to do sync operation
-      if (desc_sync_id(desc) == 0xFFFF || is_last_desc(desc, cmdbuf, sz)) {
-        counters[BMK1880v2_CPU]++;
-        tdma_desc_num += counters[BMK1880v2_TDMA];
-        if (counters[BMK1880v2_TIU] != 0) {
-          bd_size = ALIGN(bd_size + counters[BMK1880v2_TIU] * BD_REG_BYTES + BD_EOD_PADDING_BYTES,
-                          BD_DESC_ALIGN_SIZE);
-        }
-        tiu_cnt += counters[BMK1880v2_TIU] & 0xFFFF;
-        tdma_cnt += counters[BMK1880v2_TDMA] & 0xFFFF;
-        counters[BMK1880v2_TIU] = 0;
-        counters[BMK1880v2_TDMA] = 0;
-      }
-    } else {
-      tdma_desc_num += counters[BMK1880v2_TDMA];
-      if (counters[BMK1880v2_TIU] != 0) {
-        bd_size = ALIGN(bd_size + counters[BMK1880v2_TIU] * BD_REG_BYTES + BD_EOD_PADDING_BYTES,
-                        BD_DESC_ALIGN_SIZE);
-      }
-      tiu_cnt += counters[BMK1880v2_TIU] & 0xFFFF;
-      tdma_cnt += counters[BMK1880v2_TDMA] & 0xFFFF;
-      counters[BMK1880v2_TIU] = 0;
-      counters[BMK1880v2_TDMA] = 0;
-    }
-    desc = traverse_next(desc, cmdbuf, sz);
-  }
-  // dma hdr + arm descs + bd descs + tdma descs
-  dmabuf_size = sizeof(dma_hdr_t) + counters[BMK1880v2_CPU] * CPU_ENGINE_BYTES;
-  dmabuf_size = ALIGN(dmabuf_size, BD_DESC_ALIGN_SIZE) + bd_size;
-  dmabuf_size = ALIGN(dmabuf_size, GDMA_DESC_ALIGN_SIZE) + tdma_desc_num * GDMA_DESC_ALIGN_SIZE;
+void bmk1880v2_dmabuf_convert_mt(
+    uint8_t *cmdbuf,
+    uint32_t sz,
+    uint8_t *dmabuf,
+    uint32_t nr_threads)
+{
+  bmk1880v2_dmabuf_index_t *idx = bmk1880v2_dmabuf_index_create(cmdbuf, sz);
+  bmk1880v2_dmabuf_index_convert_mt(idx, dmabuf, nr_threads);
+  bmk1880v2_dmabuf_index_destroy(idx);
+}
 
-  *pmu_size = ALIGN((tiu_cnt + tdma_cnt) * PER_DES_SIZE + PADDING_SIZE, 0x1000);
-  *psize = dmabuf_size;
+void bmk1880v2_dmabuf_size(uint8_t *cmdbuf, uint32_t sz, uint32_t *psize, uint32_t *pmu_size)
+{
+  bmk1880v2_dmabuf_index_t *idx = bmk1880v2_dmabuf_index_create(cmdbuf, sz);
+  bmk1880v2_dmabuf_index_size(idx, psize, pmu_size);
+  bmk1880v2_dmabuf_index_destroy(idx);
 }
 
 void bmk1880v2_arraybase_set(uint8_t *dmabuf, uint32_t arraybase0L, uint32_t arraybase1L, uint32_t arraybase0H, uint32_t arraybase1H)
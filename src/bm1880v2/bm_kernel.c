@@ -74,7 +74,10 @@ static void kernel_init(ctx_t *k, bmk_info_t *info)
   k->cur_nr_desc = 0;
   k->desc_pairs = xmalloc(max_nr_desc * sizeof(k->desc_pairs[0]));
 
-  k->lmem_ptr = 0;
+  lmem_heap_init(&k->lmem_heap, k->chip_info.lmem_size,
+                 k->chip_info.lmem_banks, k->chip_info.lmem_bank_size,
+                 k->chip_info.eu_num);
+  desc_pool_init(&k->tl_ml_pool, TL_ML_POOL_OBJ_SIZE, 64);
 }
 
 static void kernel_destroy(ctx_t *k)
@@ -82,6 +85,8 @@ static void kernel_destroy(ctx_t *k)
   free(k->desc_pairs);
   ec_destroy(&k->ec);
   mode_manager_destroy(&k->mode_manager);
+  lmem_heap_destroy(&k->lmem_heap);
+  desc_pool_destroy(&k->tl_ml_pool);
 }
 
 static void kernel_reset(ctx_t *k)
@@ -265,18 +270,18 @@ bmk1880v2_chip_info_t bmk1880v2_chip_info(void)
   return bm1880v2_chip_info;
 }
 
-bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_tensor(
+static bmk1880v2_tensor_lmem_t * lmem_alloc_tensor(
     ctx_t *ctx,
+    int bank_id,
     bmk1880v2_tensor_lmem_shape_t s,
     fmt_t fmt, int eu_align)
 {
   ctx_t *k = (typeof(k))ctx;
-  uint32_t lmem_size = k->chip_info.lmem_size;
   uint32_t eu_num = k->chip_info.eu_num;
 
-  bmk1880v2_tensor_lmem_t *t = xmalloc(sizeof(*t));
+  bmk1880v2_tensor_lmem_t *t = desc_pool_alloc(&k->tl_ml_pool);
+  ASSERT(t);
   memset(t, 0, sizeof(*t));
-  t->start_address = k->lmem_ptr;
   t->fmt = fmt;
   t->cmprs_fmt = fmt;
   t->shape = s;
@@ -284,15 +289,36 @@ bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_tensor(
   t->stride = bmk1880v2_tensor_lmem_default_stride(ctx, s, fmt, eu_align);
 
   uint32_t needed = align_up(t->shape.n * t->stride.n, eu_num);
-  if ((lmem_size - k->lmem_ptr < needed) || !needed) {
-    free(t);
+  uint32_t addr = lmem_heap_alloc(&k->lmem_heap, bank_id, needed);
+  if (addr == LMEM_HEAP_INVALID) {
+    desc_pool_free(&k->tl_ml_pool, t);
     return NULL;
   }
 
-  k->lmem_ptr += needed;
+  t->start_address = addr;
   return t;
 }
 
+bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_tensor(
+    ctx_t *ctx,
+    bmk1880v2_tensor_lmem_shape_t s,
+    fmt_t fmt, int eu_align)
+{
+  return lmem_alloc_tensor(ctx, LMEM_HEAP_ANY_BANK, s, fmt, eu_align);
+}
+
+bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_bank_tensor(
+    ctx_t *ctx,
+    uint32_t bank_id,
+    bmk1880v2_tensor_lmem_shape_t s,
+    fmt_t fmt, int eu_align)
+{
+  if (bank_id >= ctx->chip_info.lmem_banks)
+    return NULL;
+
+  return lmem_alloc_tensor(ctx, bank_id, s, fmt, eu_align);
+}
+
 void bmk1880v2_lmem_init_tensor(
     ctx_t *ctx,
     bmk1880v2_tensor_lmem_t *tl,
@@ -350,26 +376,26 @@ bmk1880v2_tensor_lmem_t * bmk1880v2_lmem_alloc_ps32_tensor(
 void bmk1880v2_lmem_free_tensor(
     ctx_t *ctx, const bmk1880v2_tensor_lmem_t *t)
 {
-  ASSERT(t->start_address < ctx->lmem_ptr);
-  ctx->lmem_ptr = t->start_address;
+  int ret = lmem_heap_free(&ctx->lmem_heap, t->start_address);
+  ASSERT(!ret);
 
-  free((void *)t);
+  desc_pool_free(&ctx->tl_ml_pool, (void *)t);
 }
 
-bmk1880v2_matrix_lmem_t * bmk1880v2_lmem_alloc_matrix(
+static bmk1880v2_matrix_lmem_t * lmem_alloc_matrix(
     ctx_t *ctx,
+    int bank_id,
     bmk1880v2_matrix_lmem_shape_t s,
     fmt_t fmt,
     int eu_align)
 {
-  uint32_t lmem_size = ctx->chip_info.lmem_size;
   uint32_t npu_num = ctx->chip_info.npu_num;
   uint32_t eu_num = ctx->chip_info.eu_num;
   uint32_t val = (fmt == FMT_BF16) ? 2 : 1;
 
-  bmk1880v2_matrix_lmem_t *t = xmalloc(sizeof(*t));
+  bmk1880v2_matrix_lmem_t *t = desc_pool_alloc(&ctx->tl_ml_pool);
+  ASSERT(t);
   memset(t, 0, sizeof(*t));
-  t->start_address = ctx->lmem_ptr;
   t->fmt = fmt;
   t->shape = s;
   t->stride.h = s.w * val;
@@ -381,14 +407,38 @@ bmk1880v2_matrix_lmem_t * bmk1880v2_lmem_alloc_matrix(
   t->eu_align = eu_align;
 
   uint32_t needed = align_up(t->shape.n * t->stride.n, eu_num);
-  if (lmem_size - ctx->lmem_ptr < needed) {
-    free(t);
+  uint32_t addr = lmem_heap_alloc(&ctx->lmem_heap, bank_id, needed);
+  if (addr == LMEM_HEAP_INVALID) {
+    desc_pool_free(&ctx->tl_ml_pool, t);
     return NULL;
   }
-  ctx->lmem_ptr += needed;
+
+  t->start_address = addr;
   return t;
 }
 
+bmk1880v2_matrix_lmem_t * bmk1880v2_lmem_alloc_matrix(
+    ctx_t *ctx,
+    bmk1880v2_matrix_lmem_shape_t s,
+    fmt_t fmt,
+    int eu_align)
+{
+  return lmem_alloc_matrix(ctx, LMEM_HEAP_ANY_BANK, s, fmt, eu_align);
+}
+
+bmk1880v2_matrix_lmem_t * bmk1880v2_lmem_alloc_bank_matrix(
+    ctx_t *ctx,
+    uint32_t bank_id,
+    bmk1880v2_matrix_lmem_shape_t s,
+    fmt_t fmt,
+    int eu_align)
+{
+  if (bank_id >= ctx->chip_info.lmem_banks)
+    return NULL;
+
+  return lmem_alloc_matrix(ctx, bank_id, s, fmt, eu_align);
+}
+
 void bmk1880v2_lmem_init_matrix(
     ctx_t *ctx,
     bmk1880v2_matrix_lmem_t *ml,
@@ -472,9 +522,24 @@ uint32_t bmk1880v2_lmem_ps32_matrix_to_size(
 void bmk1880v2_lmem_free_matrix(
     ctx_t *ctx, const bmk1880v2_matrix_lmem_t *t)
 {
-  ASSERT(t->start_address < ctx->lmem_ptr);
-  ctx->lmem_ptr = t->start_address;
-  free((void *)t);
+  int ret = lmem_heap_free(&ctx->lmem_heap, t->start_address);
+  ASSERT(!ret);
+  desc_pool_free(&ctx->tl_ml_pool, (void *)t);
+}
+
+uint32_t bmk1880v2_lmem_high_water(ctx_t *ctx)
+{
+  return lmem_heap_high_water(&ctx->lmem_heap);
+}
+
+void bmk1880v2_lmem_reset_high_water(ctx_t *ctx)
+{
+  lmem_heap_reset_high_water(&ctx->lmem_heap);
+}
+
+uint32_t bmk1880v2_lmem_largest_free(ctx_t *ctx)
+{
+  return lmem_heap_largest_free(&ctx->lmem_heap);
 }
 
 bmk1880v2_tensor_lmem_stride_t bmk1880v2_tensor_lmem_default_stride(
@@ -2,6 +2,8 @@
 #define BMKERNEL_STANDARD_H
 #include <bmkernel/bm_kernel.h>
 #include "kernel_internal.h"
+#include "lmem_heap.h"
+#include "desc_pool.h"
 #include <cvikernel/cvikernel.h>
 
 typedef struct bmk_context {
@@ -16,7 +18,8 @@ typedef struct bmk_context {
   uint32_t cur_nr_desc;
   desc_pair_t *desc_pairs;
 
-  uint32_t lmem_ptr;
+  lmem_heap_t lmem_heap;
+  desc_pool_t tl_ml_pool;    // tl_t and ml_t handed out
   uint16_t layer_id;
   void* op; //<! compress used
 } bmk_context_t, ctx_t;
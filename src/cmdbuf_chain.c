@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cmdbuf_chain.h"
+
+static cmdbuf_chunk_t *alloc_chunk(uint32_t size)
+{
+  cmdbuf_chunk_t *c = malloc(sizeof(*c) + size);
+  if (!c)
+    return NULL;
+
+  c->next = NULL;
+  c->size = size;
+  c->used = 0;
+  return c;
+}
+
+void cmdbuf_chain_init(cmdbuf_chain_t *chain, uint32_t chunk_size)
+{
+  chain->chunk_size = chunk_size;
+  chain->total_used = 0;
+  chain->head = NULL;
+  chain->tail = NULL;
+}
+
+void cmdbuf_chain_reset(cmdbuf_chain_t *chain)
+{
+  for (cmdbuf_chunk_t *c = chain->head; c; c = c->next)
+    c->used = 0;
+
+  chain->total_used = 0;
+  chain->tail = chain->head;
+}
+
+void cmdbuf_chain_destroy(cmdbuf_chain_t *chain)
+{
+  cmdbuf_chunk_t *c = chain->head;
+  while (c) {
+    cmdbuf_chunk_t *next = c->next;
+    free(c);
+    c = next;
+  }
+
+  cmdbuf_chain_init(chain, chain->chunk_size);
+}
+
+uint8_t *cmdbuf_chain_alloc(cmdbuf_chain_t *chain, uint32_t len)
+{
+  cmdbuf_chunk_t *c = chain->tail;
+
+  if (!c || c->size - c->used < len) {
+    // Reuse the chunk kept from a previous sequence if it is large enough.
+    cmdbuf_chunk_t *next = c ? c->next : chain->head;
+    if (!next || next->size < len) {
+      uint32_t size = (len > chain->chunk_size) ? len : chain->chunk_size;
+      cmdbuf_chunk_t *n = alloc_chunk(size);
+      if (!n)
+        return NULL;
+
+      // Insert in front of the unsuitable spare chunk, if any.
+      n->next = next;
+      if (c)
+        c->next = n;
+      else
+        chain->head = n;
+      next = n;
+    }
+
+    chain->tail = next;
+    c = next;
+  }
+
+  uint8_t *p = &c->buf[c->used];
+  c->used += len;
+  chain->total_used += len;
+  return p;
+}
+
+void cmdbuf_chain_copy(cmdbuf_chain_t *chain, uint8_t *dst)
+{
+  for (cmdbuf_chunk_t *c = chain->head; c; c = c->next) {
+    memcpy(dst, c->buf, c->used);
+    dst += c->used;
+  }
+}
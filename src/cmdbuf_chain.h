@@ -0,0 +1,36 @@
+#ifndef CVIKERNEL_CMDBUF_CHAIN_H
+#define CVIKERNEL_CMDBUF_CHAIN_H
+
+#include <stdint.h>
+
+// Growable command buffer made of a singly-linked list of chunks.
+//
+// Descriptors never straddle two chunks, so a cmd_hdr_t pointer handed out
+// by cmdbuf_chain_alloc() stays valid until the chain is destroyed.
+// Chunks are kept on reset and reused for the next command sequence, so
+// the footprint follows the largest sequence actually generated.
+typedef struct cmdbuf_chunk {
+  struct cmdbuf_chunk *next;
+  uint32_t size;              // capacity in bytes
+  uint32_t used;              // bytes written
+  uint8_t buf[0];
+} cmdbuf_chunk_t;
+
+typedef struct {
+  uint32_t chunk_size;
+  uint32_t total_used;        // bytes written over all chunks
+  cmdbuf_chunk_t *head;
+  cmdbuf_chunk_t *tail;       // chunk being filled
+} cmdbuf_chain_t;
+
+void cmdbuf_chain_init(cmdbuf_chain_t *chain, uint32_t chunk_size);
+void cmdbuf_chain_reset(cmdbuf_chain_t *chain);
+void cmdbuf_chain_destroy(cmdbuf_chain_t *chain);
+
+// Return len contiguous bytes, or NULL if a new chunk cannot be allocated.
+uint8_t *cmdbuf_chain_alloc(cmdbuf_chain_t *chain, uint32_t len);
+
+// Copy all written bytes into dst, which holds at least total_used bytes.
+void cmdbuf_chain_copy(cmdbuf_chain_t *chain, uint8_t *dst);
+
+#endif /* CVIKERNEL_CMDBUF_CHAIN_H */
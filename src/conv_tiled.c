@@ -0,0 +1,538 @@
+#include <string.h>
+#include "conv_tiled.h"
+#include "tile_pipeline.h"
+#include "tile_tune.h"
+
+//
+// Tiles are walked with oc outermost, then n, oh and ow, so each weight
+// slice is loaded once and stays resident while the ifmap streams through.
+// With more than one oc tile the weights are double buffered as well and
+// the slice of the next oc tile loads along with its first ifmap tile.
+//
+typedef struct {
+  const cvk_conv_tiled_param_t *p;
+  uint32_t n, ic, ih, iw, oc, oh, ow;
+  uint32_t kh_ext, kw_ext;      // dilated kernel
+  uint32_t quan_size;           // chl_quan_param bytes per channel
+  uint32_t lmem_free;           // for the buffers, see tile_lmem_free
+
+  cvk_conv_tiling_t t;
+  uint32_t nr_n, nr_oc, nr_oh, nr_ow;
+  uint32_t nr_weight_bufs;
+
+  cvk_tl_t *ifmap[2];
+  cvk_tl_t *ofmap[2];
+  cvk_tl_t *weight[2];
+  cvk_tl_t *chl_quan[2];
+} conv_tiled_t;
+
+typedef struct {
+  uint32_t n, oc, oh, ow;       // start
+  uint32_t nn, ocn, ohn, own;   // length
+  uint32_t oc_idx;
+} conv_tile_t;
+
+static uint32_t ceil_div(uint32_t a, uint32_t b)
+{
+  return (a + b - 1) / b;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+  return (a < b) ? a : b;
+}
+
+static cvk_tl_shape_t ifmap_max_shape(const conv_tiled_t *c)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  cvk_tl_shape_t s = {
+      c->t.n_step, c->ic,
+      tile_input_max(c->t.oh_step, p->stride_h, c->kh_ext, c->ih),
+      tile_input_max(c->t.ow_step, p->stride_w, c->kw_ext, c->iw)};
+  return s;
+}
+
+static cvk_tl_shape_t ofmap_max_shape(const conv_tiled_t *c)
+{
+  cvk_tl_shape_t s = {c->t.n_step, c->t.oc_step, c->t.oh_step, c->t.ow_step};
+  return s;
+}
+
+static cvk_tl_shape_t weight_max_shape(const conv_tiled_t *c)
+{
+  cvk_tl_shape_t s = {1, c->t.oc_step, c->p->kh * c->p->kw, c->ic};
+  return s;
+}
+
+static cvk_tl_shape_t chl_quan_max_shape(const conv_tiled_t *c)
+{
+  cvk_tl_shape_t s = {1, c->t.oc_step, 1, c->quan_size};
+  return s;
+}
+
+static uint32_t tiling_lmem_size(cvk_context_t *ctx, const conv_tiled_t *c)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  uint32_t size = 0;
+
+  size += 2 * ctx->ops->lmem_tensor_to_size(ctx, ifmap_max_shape(c),
+                                            p->ifmap->fmt, 1);
+  size += 2 * ctx->ops->lmem_tensor_to_size(ctx, ofmap_max_shape(c),
+                                            p->ofmap->fmt, 1);
+  size += c->nr_weight_bufs *
+          ctx->ops->lmem_tensor_to_size(ctx, weight_max_shape(c),
+                                        p->weight->fmt, 0);
+  size += c->nr_weight_bufs *
+          ctx->ops->lmem_tensor_to_size(ctx, chl_quan_max_shape(c),
+                                        p->chl_quan_param->fmt, 0);
+  return size;
+}
+
+static void free_buffers(cvk_context_t *ctx, conv_tiled_t *c)
+{
+  cvk_tl_t **bufs[] = {c->ofmap, c->ifmap, c->chl_quan, c->weight};
+
+  for (uint32_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+    for (int j = 1; j >= 0; j--) {
+      if (bufs[i][j])
+        ctx->ops->lmem_free_tensor(ctx, bufs[i][j]);
+      bufs[i][j] = NULL;
+    }
+  }
+}
+
+static int alloc_buffers(cvk_context_t *ctx, conv_tiled_t *c)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+
+  // Weights stay longest, allocate them first.
+  for (uint32_t i = 0; i < c->nr_weight_bufs; i++) {
+    c->weight[i] = ctx->ops->lmem_alloc_tensor(ctx, weight_max_shape(c),
+                                               p->weight->fmt, 0);
+    c->chl_quan[i] = ctx->ops->lmem_alloc_tensor(
+        ctx, chl_quan_max_shape(c), p->chl_quan_param->fmt, 0);
+    if (!c->weight[i] || !c->chl_quan[i]) {
+      free_buffers(ctx, c);
+      return -1;
+    }
+  }
+
+  for (uint32_t i = 0; i < 2; i++) {
+    c->ifmap[i] = ctx->ops->lmem_alloc_tensor(ctx, ifmap_max_shape(c),
+                                              p->ifmap->fmt, 1);
+    c->ofmap[i] = ctx->ops->lmem_alloc_tensor(ctx, ofmap_max_shape(c),
+                                              p->ofmap->fmt, 1);
+    if (!c->ifmap[i] || !c->ofmap[i]) {
+      free_buffers(ctx, c);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void set_steps(cvk_context_t *ctx, conv_tiled_t *c)
+{
+  c->t.n_step = tile_step(c->n, 1, c->nr_n);
+  c->t.oc_step = tile_step(c->oc, ctx->info.npu_num, c->nr_oc);
+  c->t.oh_step = tile_step(c->oh, 1, c->nr_oh);
+  c->t.ow_step = tile_step(c->ow, 1, c->nr_ow);
+
+  // Several counts may give the same step, keep the fewest tiles.
+  c->nr_n = ceil_div(c->n, c->t.n_step);
+  c->nr_oc = ceil_div(c->oc, c->t.oc_step);
+  c->nr_oh = ceil_div(c->oh, c->t.oh_step);
+  c->nr_ow = ceil_div(c->ow, c->t.ow_step);
+
+  c->nr_weight_bufs = (c->nr_oc > 1) ? 2 : 1;
+  c->t.nr_tiles = c->nr_n * c->nr_oc * c->nr_oh * c->nr_ow;
+}
+
+static tile_cost_t tiling_cost(cvk_context_t *ctx, const conv_tiled_t *c)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  uint64_t ih_sum = 0, iw_sum = 0;
+  uint32_t start, len;
+  uint8_t pad_lo, pad_hi;
+  tile_cost_t cost;
+
+  // Input rows and columns read over the tiles of one dimension, halos
+  // included.
+  for (uint32_t o = 0; o < c->oh; o += c->t.oh_step) {
+    tile_input_range(o, min_u32(c->t.oh_step, c->oh - o), p->stride_h,
+                     c->kh_ext, p->pad_top, c->ih, &start, &len, &pad_lo,
+                     &pad_hi);
+    ih_sum += len;
+  }
+  for (uint32_t o = 0; o < c->ow; o += c->t.ow_step) {
+    tile_input_range(o, min_u32(c->t.ow_step, c->ow - o), p->stride_w,
+                     c->kw_ext, p->pad_left, c->iw, &start, &len, &pad_lo,
+                     &pad_hi);
+    iw_sum += len;
+  }
+
+  memset(&cost, 0, sizeof(cost));
+  cost.nr_tiles = c->t.nr_tiles;
+  cost.load_bytes = (uint64_t)c->nr_oc * c->n * c->ic * ih_sum * iw_sum +
+                    (uint64_t)c->oc * (p->kh * p->kw * c->ic + c->quan_size);
+  cost.nr_loads = c->t.nr_tiles + 2 * c->nr_oc;
+  cost.store_bytes = (uint64_t)c->n * c->oc * c->oh * c->ow;
+  cost.nr_stores = c->t.nr_tiles;
+  cost.tiu_cycles = (uint64_t)c->nr_oh * c->nr_ow *
+                    tile_tiu_cycles(&ctx->info, c->n, c->oc,
+                                    c->t.oh_step * c->t.ow_step,
+                                    (uint64_t)c->ic * p->kh * p->kw);
+  cost.nr_tius = c->t.nr_tiles;
+  return cost;
+}
+
+static void set_nr(cvk_context_t *ctx, conv_tiled_t *c, const uint32_t *nr)
+{
+  c->nr_n = nr[0];
+  c->nr_oc = nr[1];
+  c->nr_oh = nr[2];
+  c->nr_ow = nr[3];
+  set_steps(ctx, c);
+}
+
+static int tune_fits(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  conv_tiled_t *c = arg;
+  set_nr(ctx, c, nr);
+  return tiling_lmem_size(ctx, c) <= c->lmem_free;
+}
+
+static uint64_t tune_cycles(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  conv_tiled_t *c = arg;
+  set_nr(ctx, c, nr);
+
+  tile_cost_t cost = tiling_cost(ctx, c);
+  return tile_cost_cycles(&cost);
+}
+
+static int tune_alloc(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  conv_tiled_t *c = arg;
+  set_nr(ctx, c, nr);
+  if (alloc_buffers(ctx, c))
+    return -1;
+
+  c->t.lmem_size = tiling_lmem_size(ctx, c);
+  return 0;
+}
+
+// Split of the fewest estimated cycles, see tile_tune.
+static int tune_tiling(cvk_context_t *ctx, conv_tiled_t *c)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  tile_tuner_t tu = {
+      {c->n, c->oc, c->oh, c->ow}, {1, ctx->info.npu_num, 1, 1},
+      tune_fits, tune_cycles, tune_alloc};
+  uint32_t words[] = {
+      'C', ctx->info.npu_num, ctx->info.eu_num, ctx->info.lmem_size,
+      c->n, c->ic, c->ih, c->iw, c->oc, p->kh, p->kw,
+      p->pad_top, p->pad_bottom, p->pad_left, p->pad_right,
+      p->stride_h, p->stride_w, p->dilation_h, p->dilation_w,
+      c->quan_size};
+
+  return tile_tune(ctx, &tu, c, p->cache,
+                   tile_cache_key(words, sizeof(words) / sizeof(words[0])));
+}
+
+// Largest tiles whose buffers fit in the local memory left free, shrinking
+// the batch first, then output channels, rows and columns. With autotune
+// the split estimated fastest instead, the largest tiles if none fits.
+static int choose_tiling(cvk_context_t *ctx, conv_tiled_t *c)
+{
+  uint32_t npu_num = ctx->info.npu_num;
+
+  c->lmem_free = tile_lmem_free(ctx);
+  if (c->p->autotune && !tune_tiling(ctx, c))
+    return 0;
+
+  c->nr_n = c->nr_oc = c->nr_oh = c->nr_ow = 1;
+  for (;;) {
+    set_steps(ctx, c);
+
+    uint32_t size = tiling_lmem_size(ctx, c);
+    if (size <= c->lmem_free && !alloc_buffers(ctx, c)) {
+      c->t.lmem_size = size;
+      return 0;
+    }
+
+    if (!tile_split_more(c->n, 1, &c->nr_n) &&
+        !tile_split_more(c->oc, npu_num, &c->nr_oc) &&
+        !tile_split_more(c->oh, 1, &c->nr_oh) &&
+        !tile_split_more(c->ow, 1, &c->nr_ow))
+      return -1;
+  }
+}
+
+static void get_tile(const conv_tiled_t *c, uint32_t i, conv_tile_t *tile)
+{
+  uint32_t ow_i = i % c->nr_ow;
+  i /= c->nr_ow;
+  uint32_t oh_i = i % c->nr_oh;
+  i /= c->nr_oh;
+  uint32_t n_i = i % c->nr_n;
+  uint32_t oc_i = i / c->nr_n;
+
+  tile->n = n_i * c->t.n_step;
+  tile->oc = oc_i * c->t.oc_step;
+  tile->oh = oh_i * c->t.oh_step;
+  tile->ow = ow_i * c->t.ow_step;
+  tile->nn = min_u32(c->t.n_step, c->n - tile->n);
+  tile->ocn = min_u32(c->t.oc_step, c->oc - tile->oc);
+  tile->ohn = min_u32(c->t.oh_step, c->oh - tile->oh);
+  tile->own = min_u32(c->t.ow_step, c->ow - tile->ow);
+  tile->oc_idx = oc_i;
+}
+
+static cvk_tl_t tl_view(
+    cvk_context_t *ctx, const cvk_tl_t *buf, cvk_tl_shape_t shape,
+    int eu_align)
+{
+  cvk_tl_t t = *buf;
+  t.shape = shape;
+  t.stride = ctx->ops->tl_default_stride(ctx, shape, t.fmt, eu_align);
+  return t;
+}
+
+static cvk_tg_t tg_view(
+    const cvk_tg_t *tg, uint32_t n, uint32_t c, uint32_t h, uint32_t w,
+    cvk_tg_shape_t shape)
+{
+  cvk_tg_t t = *tg;
+  t.start_address += (uint64_t)n * tg->stride.n + (uint64_t)c * tg->stride.c +
+                     (uint64_t)h * tg->stride.h + (uint64_t)w * tg->stride.w;
+  t.shape = shape;
+  return t;
+}
+
+static void load_weight(
+    cvk_context_t *ctx, const conv_tiled_t *c, const conv_tile_t *tile)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  uint32_t slot = tile->oc_idx % c->nr_weight_bufs;
+  cvk_tdma_g2l_tensor_copy_param_t param;
+
+  cvk_tg_shape_t ws = {1, tile->ocn, p->kh * p->kw, c->ic};
+  cvk_tl_shape_t wl = {1, tile->ocn, p->kh * p->kw, c->ic};
+  cvk_tg_t w_src = tg_view(p->weight, 0, tile->oc, 0, 0, ws);
+  cvk_tl_t w_dst = tl_view(ctx, c->weight[slot], wl, 0);
+
+  memset(&param, 0, sizeof(param));
+  param.src = &w_src;
+  param.dst = &w_dst;
+  param.layer_id = p->layer_id;
+  ctx->ops->tdma_g2l_tensor_copy(ctx, &param);
+
+  cvk_tg_shape_t qs = {1, tile->ocn, 1, c->quan_size};
+  cvk_tl_shape_t ql = {1, tile->ocn, 1, c->quan_size};
+  cvk_tg_t q_src = tg_view(p->chl_quan_param, 0, tile->oc, 0, 0, qs);
+  cvk_tl_t q_dst = tl_view(ctx, c->chl_quan[slot], ql, 0);
+
+  memset(&param, 0, sizeof(param));
+  param.src = &q_src;
+  param.dst = &q_dst;
+  param.layer_id = p->layer_id;
+  ctx->ops->tdma_g2l_tensor_copy(ctx, &param);
+}
+
+typedef struct {
+  uint32_t h, w;                // start
+  cvk_tl_shape_t shape;
+  uint8_t pad_top, pad_bottom;
+  uint8_t pad_left, pad_right;
+} ifmap_tile_t;
+
+static void get_ifmap_tile(
+    const conv_tiled_t *c, const conv_tile_t *tile, ifmap_tile_t *it)
+{
+  const cvk_conv_tiled_param_t *p = c->p;
+  uint32_t ihn, iwn;
+
+  tile_input_range(tile->oh, tile->ohn, p->stride_h, c->kh_ext,
+                   p->pad_top, c->ih, &it->h, &ihn, &it->pad_top,
+                   &it->pad_bottom);
+  tile_input_range(tile->ow, tile->own, p->stride_w, c->kw_ext,
+                   p->pad_left, c->iw, &it->w, &iwn, &it->pad_left,
+                   &it->pad_right);
+
+  it->shape.n = tile->nn;
+  it->shape.c = c->ic;
+  it->shape.h = ihn;
+  it->shape.w = iwn;
+}
+
+static void conv_load(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const conv_tiled_t *c = arg;
+  const cvk_conv_tiled_param_t *p = c->p;
+  conv_tile_t tile;
+  ifmap_tile_t it;
+
+  get_tile(c, i, &tile);
+  if (i % (c->nr_n * c->nr_oh * c->nr_ow) == 0)
+    load_weight(ctx, c, &tile);
+
+  get_ifmap_tile(c, &tile, &it);
+  cvk_tg_shape_t s = {it.shape.n, it.shape.c, it.shape.h, it.shape.w};
+  cvk_tg_t src = tg_view(p->ifmap, tile.n, 0, it.h, it.w, s);
+  cvk_tl_t dst = tl_view(ctx, c->ifmap[buf], it.shape, 1);
+
+  cvk_tdma_g2l_tensor_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = &src;
+  param.dst = &dst;
+  param.layer_id = p->layer_id;
+  ctx->ops->tdma_g2l_tensor_copy(ctx, &param);
+}
+
+static void conv_compute(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const conv_tiled_t *c = arg;
+  const cvk_conv_tiled_param_t *p = c->p;
+  uint32_t slot;
+  conv_tile_t tile;
+  ifmap_tile_t it;
+
+  get_tile(c, i, &tile);
+  get_ifmap_tile(c, &tile, &it);
+  slot = tile.oc_idx % c->nr_weight_bufs;
+
+  cvk_tl_shape_t os = {tile.nn, tile.ocn, tile.ohn, tile.own};
+  cvk_tl_shape_t ws = {c->ic, tile.ocn, p->kh, p->kw};
+  cvk_tl_shape_t qs = {1, tile.ocn, 1, 1};
+  cvk_tl_t ifmap = tl_view(ctx, c->ifmap[buf], it.shape, 1);
+  cvk_tl_t ofmap = tl_view(ctx, c->ofmap[buf], os, 1);
+  cvk_tl_t weight = tl_view(ctx, c->weight[slot], ws, 0);
+  cvk_tl_t chl_quan = tl_view(ctx, c->chl_quan[slot], qs, 0);
+
+  cvk_tiu_convolution_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.ofmap = &ofmap;
+  param.ifmap = &ifmap;
+  param.weight = &weight;
+  param.chl_quan_param = &chl_quan;
+  param.pad_top = it.pad_top;
+  param.pad_bottom = it.pad_bottom;
+  param.pad_left = it.pad_left;
+  param.pad_right = it.pad_right;
+  param.stride_h = p->stride_h;
+  param.stride_w = p->stride_w;
+  param.dilation_h = p->dilation_h;
+  param.dilation_w = p->dilation_w;
+  param.has_bias = p->has_bias;
+  param.relu_enable = p->relu_enable;
+  param.layer_id = p->layer_id;
+  param.ins_val = p->ins_val;
+  ctx->ops->tiu_convolution(ctx, &param);
+}
+
+static void conv_store(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const conv_tiled_t *c = arg;
+  const cvk_conv_tiled_param_t *p = c->p;
+  conv_tile_t tile;
+
+  get_tile(c, i, &tile);
+
+  cvk_tl_shape_t ls = {tile.nn, tile.ocn, tile.ohn, tile.own};
+  cvk_tg_shape_t gs = {tile.nn, tile.ocn, tile.ohn, tile.own};
+  cvk_tl_t src = tl_view(ctx, c->ofmap[buf], ls, 1);
+  cvk_tg_t dst = tg_view(p->ofmap, tile.n, tile.oc, tile.oh, tile.ow, gs);
+
+  cvk_tdma_l2g_tensor_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = &src;
+  param.dst = &dst;
+  param.layer_id = p->layer_id;
+  ctx->ops->tdma_l2g_tensor_copy(ctx, &param);
+}
+
+static int check_param(const cvk_conv_tiled_param_t *p)
+{
+  if (!p || !p->ifmap || !p->weight || !p->chl_quan_param || !p->ofmap)
+    return -1;
+  if (p->ifmap->fmt == CVK_FMT_BF16 || p->ofmap->fmt == CVK_FMT_BF16 ||
+      p->weight->fmt == CVK_FMT_BF16)
+    return -1;
+  if (!p->kh || !p->kw || !p->stride_h || !p->stride_w ||
+      !p->dilation_h || !p->dilation_w)
+    return -1;
+
+  uint32_t kh_ext = (p->kh - 1) * p->dilation_h + 1;
+  uint32_t kw_ext = (p->kw - 1) * p->dilation_w + 1;
+  const cvk_tg_shape_t *i = &p->ifmap->shape;
+  const cvk_tg_shape_t *o = &p->ofmap->shape;
+  const cvk_tg_shape_t *w = &p->weight->shape;
+  const cvk_tg_shape_t *q = &p->chl_quan_param->shape;
+
+  // Every output must read at least one real input row and column.
+  if (p->pad_top >= kh_ext || p->pad_bottom >= kh_ext ||
+      p->pad_left >= kw_ext || p->pad_right >= kw_ext)
+    return -1;
+  if (i->h + p->pad_top + p->pad_bottom < kh_ext ||
+      i->w + p->pad_left + p->pad_right < kw_ext)
+    return -1;
+
+  if (!i->n || !i->c || o->n != i->n ||
+      o->h != (i->h + p->pad_top + p->pad_bottom - kh_ext) / p->stride_h + 1 ||
+      o->w != (i->w + p->pad_left + p->pad_right - kw_ext) / p->stride_w + 1)
+    return -1;
+  if (w->n != 1 || w->c != o->c || w->h != (uint32_t)p->kh * p->kw ||
+      w->w != i->c)
+    return -1;
+  if (q->n != 1 || q->c != o->c || q->h != 1 ||
+      q->w != (p->has_bias ? 9u : 5u))
+    return -1;
+
+  return 0;
+}
+
+int cvk_conv_tiled(
+    cvk_context_t *ctx,
+    const cvk_conv_tiled_param_t *p,
+    cvk_conv_tiling_t *tiling)
+{
+  conv_tiled_t c;
+
+  if (tiling)
+    memset(tiling, 0, sizeof(*tiling));
+  if (check_param(p))
+    return -1;
+
+  memset(&c, 0, sizeof(c));
+  c.p = p;
+  c.n = p->ifmap->shape.n;
+  c.ic = p->ifmap->shape.c;
+  c.ih = p->ifmap->shape.h;
+  c.iw = p->ifmap->shape.w;
+  c.oc = p->ofmap->shape.c;
+  c.oh = p->ofmap->shape.h;
+  c.ow = p->ofmap->shape.w;
+  c.kh_ext = (p->kh - 1) * p->dilation_h + 1;
+  c.kw_ext = (p->kw - 1) * p->dilation_w + 1;
+  c.quan_size = p->chl_quan_param->shape.w;
+
+  if (choose_tiling(ctx, &c))
+    return -1;
+
+  tile_cost_t cost = tiling_cost(ctx, &c);
+  c.t.cycles = tile_cost_cycles(&cost);
+
+  static const tile_pipeline_t pl = {
+      conv_load, conv_compute, conv_store, 2};
+  int ret = tile_pipeline_run(ctx, &pl, &c, c.t.nr_tiles);
+
+  free_buffers(ctx, &c);
+
+  if (tiling)
+    *tiling = c.t;
+  return ret;
+}
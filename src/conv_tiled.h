@@ -0,0 +1,13 @@
+#ifndef CVIKERNEL_CONV_TILED_H
+#define CVIKERNEL_CONV_TILED_H
+
+#include <cvikernel/cvikernel.h>
+
+// Convolution of global memory tensors tiled over local memory, shared by
+// the chip backends, see conv_tiled in cvk_misc_operations_t.
+int cvk_conv_tiled(
+    cvk_context_t *ctx,
+    const cvk_conv_tiled_param_t *p,
+    cvk_conv_tiling_t *tiling);
+
+#endif /* CVIKERNEL_CONV_TILED_H */
@@ -0,0 +1,49 @@
+#ifndef CVIKERNEL_COST_MODEL_H
+#define CVIKERNEL_COST_MODEL_H
+
+#include <stdint.h>
+
+// Nominal costs shared by the descriptor cost estimate and the split
+// search of the tiled ops, the same for every chip: the TIU scales with
+// the lane and EU count, the TDMA moves a bus word per cycle and pays for
+// every burst it starts in global memory.
+#define TIU_DESC_CYCLES             32
+#define TDMA_DESC_CYCLES            64
+#define TDMA_BYTES_PER_CYCLE        16
+#define TDMA_BURST_CYCLES           4
+#define TDMA_CMPR_BYTES_PER_CYCLE   4   // codec, one symbol per cycle
+
+static inline uint64_t cost_ceil_div(uint64_t a, uint64_t b)
+{
+  return (a + b - 1) / b;
+}
+
+// Lane passes over an (n, c, hw) result: c spread over the NPUs, hw over
+// the EUs of each.
+static inline uint64_t cost_tiu_passes(
+    uint32_t npu_num, uint32_t eu_num, uint32_t n, uint32_t c, uint64_t hw)
+{
+  return (uint64_t)n * cost_ceil_div(c, npu_num) * cost_ceil_div(hw, eu_num);
+}
+
+// nr_descs TIU commands taking steps lane steps in all.
+static inline uint64_t cost_tiu_cycles(uint64_t nr_descs, uint64_t steps)
+{
+  return nr_descs * TIU_DESC_CYCLES + steps;
+}
+
+// Moving bytes in nr_bursts contiguous runs, descriptors not counted.
+static inline uint64_t cost_tdma_move_cycles(
+    uint64_t bytes, uint64_t nr_bursts)
+{
+  return cost_ceil_div(bytes, TDMA_BYTES_PER_CYCLE) +
+         nr_bursts * TDMA_BURST_CYCLES;
+}
+
+// nr_descs TDMA descriptors moving bytes in all, a burst each.
+static inline uint64_t cost_tdma_cycles(uint64_t nr_descs, uint64_t bytes)
+{
+  return nr_descs * TDMA_DESC_CYCLES + cost_tdma_move_cycles(bytes, nr_descs);
+}
+
+#endif /* CVIKERNEL_COST_MODEL_H */
@@ -8,6 +8,9 @@ extern "C" {
 #include "engine_conductor.h"
 #include "engine_state.h"
 #include "mode_manager.h"
+#include "cmdbuf_chain.h"
+#include "lmem_heap.h"
+#include "desc_pool.h"
 #include <cvikernel/cvikernel.h>
 #include <cvikernel/cvk_fp_convert.h>
 #include "../../include/cvikernel/cv180x/cv180x_tiu_reg.h"
@@ -29,11 +32,68 @@ typedef struct __cmd_hdr_s {
   uint8_t cmd[0];
 } __attribute__((packed)) cmd_hdr_t;
 
+#define CMDBUF_HDR_MAGIC_180X     0xA8
+
 typedef struct {
-  cmd_hdr_t *cmd_hdr;
+  cmd_hdr_t *cmd_hdr;       // NULL with direct dmabuf emission
   ec_desc_t *ec_desc;
+  uint32_t dmabuf_offset;   // in its engine region, direct dmabuf only
 } desc_pair_t;
 
+typedef struct {
+  uint32_t num_tiu;
+  uint32_t num_tdma;
+  uint32_t tiu_offset;      // relative to the tiu region
+  uint32_t tdma_offset;     // relative to the tdma region
+} dmabuf_segment_t;
+
+// Direct dmabuf emission.
+// Descriptors are written in their final dmabuf form: tiu descriptors go
+// reordered into the tiu region of buf, behind room for the dmabuf header
+// and cpu sync descs, tdma descriptors go into tdma_buf. acquire_cmdbuf
+// only fills in the header and cpu descs and appends the tdma region.
+typedef struct {
+  uint8_t *buf;
+  uint32_t buf_size;
+  uint32_t tiu_base;        // tiu region in buf
+  uint32_t tiu_used;
+
+  uint8_t *tdma_buf;
+  uint32_t tdma_buf_size;
+  uint32_t tdma_used;
+
+  uint32_t nr_segments;     // closed segments
+  uint32_t max_nr_segments;
+  dmabuf_segment_t *segments;
+
+  dmabuf_segment_t cur;     // open segment
+  uint32_t last_tiu;        // last descriptors of open segment
+  uint32_t last_tdma;
+  uint32_t close_pending;   // a sync id reached 0xffff
+
+  // EOD marked on the open segment by acquire_cmdbuf, undone once more
+  // descriptors are added.
+  uint32_t eod_marked;
+  uint32_t eod_saved_tiu;   // eod bits of word 0 before marking
+  uint32_t eod_saved_tdma;
+} dmabuf_writer_t;
+
+typedef struct {
+  uint32_t nr_layers;
+  uint32_t max_nr_layers;
+  uint32_t last;            // layer found by the previous lookup
+  cvk_conv_report_t *layers;
+} conv_report_t;
+
+typedef struct {
+  uint32_t enabled;
+  cvk_stats_t s;            // without lmem_high_water, nr_removed_waits
+  uint32_t nr_layers;
+  uint32_t max_nr_layers;
+  uint32_t last;            // layer found by the previous lookup
+  cvk_layer_stats_t *layers;
+} stats_t;
+
 typedef struct cvk_prv_data {
   ec_t ec;
   mode_manager_t mode_manager;
@@ -41,16 +101,34 @@ typedef struct cvk_prv_data {
   uint32_t cmdbuf_ptr;
   uint32_t max_nr_desc;
   uint32_t cur_nr_desc;
+  uint32_t nr_synced_desc;  // descriptors already carrying final sync ids
   desc_pair_t *desc_pairs;
 
-  uint32_t lmem_ptr;
+  lmem_heap_t lmem_heap;
+  desc_pool_t tl_ml_pool;    // cvk_tl_t and cvk_ml_t handed out
   uint16_t layer_id;
 
   uint32_t cmdbuf_size;
   uint8_t *cmdbuf;
+
+  // Growable mode, registered without cmdbuf.
+  // Descriptors are written into cmdbuf_chain, cmdbuf is owned by the
+  // context and only holds the stitched copy returned by acquire_cmdbuf.
+  uint32_t growable;
+  cmdbuf_chain_t cmdbuf_chain;
+
+  // Direct dmabuf emission, cmdbuf is not used.
+  uint32_t direct_dmabuf;
+  dmabuf_writer_t dmabuf_writer;
+
+  conv_report_t conv_report;
+  stats_t stats;
+  uint32_t nr_dropped_cmds;  // wrong parameter or no descriptor left
 } cvk_prv_data_t;
 
 desc_pair_t *cvkcv180x_get_desc_pair(cvk_context_t *ctx, uint8_t eng_id);
+uint32_t *cvkcv180x_desc_pair_body(cvk_context_t *ctx, desc_pair_t *dp);
+void cvkcv180x_desc_pair_emitted(cvk_context_t *ctx, desc_pair_t *dp);
 
 #define CHECK(_status, _cond)       \
   do {                              \
@@ -457,22 +535,160 @@ static inline void fill_same_tensor_stride_type(tiu_reg_t *r, int type)
   r->short_res0_str = type & 0b11;
 }
 
+void cvkcv180x_record_tiu_hazard(
+    cvk_context_t *ctx,
+    ec_desc_t *d,
+    const tiu_reg_t *r);
+void cvkcv180x_record_tdma_hazard(
+    cvk_context_t *ctx,
+    ec_desc_t *d,
+    const tdma_reg_t *r);
+void cvkcv180x_stats_record_tiu(cvk_context_t *ctx, const tiu_reg_t *r);
+void cvkcv180x_stats_record_tdma(cvk_context_t *ctx, const tdma_reg_t *r);
+void cvkcv180x_conv_report_record(cvk_context_t *ctx, const tiu_reg_t *r);
+
+static inline void cvkcv180x_check_failed(cvk_context_t *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  prv_data->nr_dropped_cmds++;
+  if (prv_data->stats.enabled)
+    prv_data->stats.s.nr_check_failed++;
+}
+
 static inline ec_desc_t * emit_tiu_cmdbuf(cvk_context_t *ctx, tiu_reg_t *r)
 {
   int engine_id = CV180X_TIU;
 
   desc_pair_t *dp = cvkcv180x_get_desc_pair(ctx, engine_id);
-  uint32_t *cmdbuf = (uint32_t *)dp->cmd_hdr->cmd;
+  if (!dp) {
+    printf("cvkcv180x tiu: fail to allocate descriptor\n");
+    ((cvk_prv_data_t *)ctx->priv_data)->nr_dropped_cmds++;
+    return NULL;
+  }
+
+  uint32_t *cmdbuf = cvkcv180x_desc_pair_body(ctx, dp);
   emit_tiu_reg(r, cmdbuf);
+  cvkcv180x_desc_pair_emitted(ctx, dp);
+  cvkcv180x_record_tiu_hazard(ctx, dp->ec_desc, r);
+  if (((cvk_prv_data_t *)ctx->priv_data)->stats.enabled)
+    cvkcv180x_stats_record_tiu(ctx, r);
+  if (r->tsk_typ == DCR_TYPE_CONV_FIX8B)
+    cvkcv180x_conv_report_record(ctx, r);
 
   return dp->ec_desc;
 }
 
 void cvkcv180x_cleanup(struct cvikernel_context *ctx);
 void cvkcv180x_reset(struct cvikernel_context *ctx);
+void cvkcv180x_dmabuf_size(
+    uint8_t *cmdbuf,
+    uint32_t sz,
+    uint32_t *psize,
+    uint32_t *pmu_size);
+void cvkcv180x_dmabuf_convert(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf);
+
+void cvkcv180x_dmabuf_writer_init(dmabuf_writer_t *w);
+void cvkcv180x_dmabuf_writer_reset(dmabuf_writer_t *w);
+void cvkcv180x_dmabuf_writer_destroy(dmabuf_writer_t *w);
+int cvkcv180x_dmabuf_writer_alloc(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t *offset);
+uint32_t *cvkcv180x_dmabuf_writer_body(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset);
+uint32_t *cvkcv180x_dmabuf_writer_reg(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset);
+void cvkcv180x_dmabuf_writer_read(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset,
+    uint32_t *regs);
+void cvkcv180x_dmabuf_writer_emitted(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset);
+uint8_t *cvkcv180x_dmabuf_writer_finish(dmabuf_writer_t *w, uint32_t *size);
+
+// Call fn on each tiu/tdma descriptor of a dmabuf with its registers in
+// cmdbuf form, segment by segment, tiu before tdma. Returns the number of
+// descriptors, -1 if the dmabuf is malformed.
+typedef void (*dmabuf_walk_fn)(
+    void *arg,
+    uint32_t segment,
+    uint32_t eng_id,
+    const uint32_t *regs);
+int cvkcv180x_dmabuf_walk(
+    const uint8_t *dmabuf,
+    uint32_t size,
+    dmabuf_walk_fn fn,
+    void *arg);
 
 void cvkcv180x_parallel_enable(struct cvikernel_context *ctx);
 void cvkcv180x_parallel_disable(struct cvikernel_context *ctx);
+void cvkcv180x_hazard_tracking_enable(struct cvikernel_context *ctx);
+void cvkcv180x_hazard_tracking_disable(struct cvikernel_context *ctx);
+int cvkcv180x_direct_dmabuf_enable(struct cvikernel_context *ctx);
+uint32_t cvkcv180x_conv_report(
+    struct cvikernel_context *ctx,
+    cvk_conv_report_t *layers,
+    uint32_t max_layers);
+void cvkcv180x_conv_report_reset(struct cvikernel_context *ctx);
+int cvkcv180x_desc_template_capture(
+    struct cvikernel_context *ctx,
+    cvk_desc_template_t *t);
+int cvkcv180x_desc_template_emit(
+    struct cvikernel_context *ctx,
+    const cvk_desc_template_t *t,
+    const cvk_desc_patch_t *patch);
+void cvkcv180x_tiu_cost(const tiu_reg_t *r, cvk_desc_cost_t *cost);
+void cvkcv180x_tdma_cost(const tdma_reg_t *r, cvk_desc_cost_t *cost);
+int cvkcv180x_desc_cost(
+    struct cvikernel_context *ctx,
+    const cvk_desc_template_t *desc,
+    cvk_desc_cost_t *cost);
+int cvkcv180x_cmdbuf_cost(
+    struct cvikernel_context *ctx,
+    const uint8_t *cmdbuf,
+    uint32_t size,
+    cvk_cmdbuf_cost_t *cost);
+int cvkcv180x_cmdbuf_timeline(
+    struct cvikernel_context *ctx,
+    const cvk_timeline_param_t *p,
+    cvk_timeline_event_t *events,
+    uint32_t max_events,
+    cvk_timeline_t *summary);
+int cvkcv180x_timeline_trace(
+    struct cvikernel_context *ctx,
+    const cvk_timeline_event_t *events,
+    uint32_t nr_events,
+    const char *path);
+void cvkcv180x_stats_enable(struct cvikernel_context *ctx);
+void cvkcv180x_stats_disable(struct cvikernel_context *ctx);
+uint32_t cvkcv180x_stats(
+    struct cvikernel_context *ctx,
+    cvk_stats_t *stats,
+    cvk_layer_stats_t *layers,
+    uint32_t max_layers);
+void cvkcv180x_stats_reset(struct cvikernel_context *ctx);
+int cvkcv180x_pmu_decode(
+    struct cvikernel_context *ctx,
+    const uint8_t *dmabuf,
+    uint32_t dmabuf_size,
+    const uint8_t *pmu,
+    uint32_t pmu_size,
+    cvk_pmu_event_t *events,
+    uint32_t max_events,
+    uint32_t *nr_events);
+uint32_t cvkcv180x_pmu_layer_report(
+    struct cvikernel_context *ctx,
+    const cvk_pmu_event_t *events,
+    uint32_t nr_events,
+    cvk_pmu_layer_t *layers,
+    uint32_t max_layers);
 void cvkcv180x_set_layer_id(
     struct cvikernel_context *ctx,
     uint16_t layer_id);
@@ -491,6 +707,22 @@ cvk_ml_t *cvkcv180x_lmem_alloc_ps32_matrix(
     cvk_ml_shape_t shape,
     cvk_fmt_t fmt,
     int eu_align);
+cvk_tl_t *cvkcv180x_lmem_alloc_bank_tensor(
+    struct cvikernel_context *ctx,
+    uint32_t bank_id,
+    cvk_tl_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align);
+cvk_ml_t *cvkcv180x_lmem_alloc_bank_matrix(
+    struct cvikernel_context *ctx,
+    uint32_t bank_id,
+    cvk_ml_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align);
+uint32_t cvkcv180x_lmem_high_water(struct cvikernel_context *ctx);
+void cvkcv180x_lmem_reset_high_water(struct cvikernel_context *ctx);
+uint32_t cvkcv180x_lmem_largest_free(struct cvikernel_context *ctx);
+uint32_t cvkcv180x_nr_dropped_cmds(struct cvikernel_context *ctx);
 void cvkcv180x_lmem_free_tensor(
     struct cvikernel_context *ctx,
     const cvk_tl_t *tl);
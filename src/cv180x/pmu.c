@@ -0,0 +1,61 @@
+#include "cvkcv180x.h"
+#include <string.h>
+#include "pmu_decode.h"
+
+static void pmu_add_desc(
+    void *arg,
+    uint32_t segment,
+    uint32_t eng_id,
+    const uint32_t *regs)
+{
+  pmu_descs_t *d = (pmu_descs_t *)arg;
+
+  (void)segment;
+
+  if (eng_id == CV180X_TIU) {
+    tiu_reg_t reg;
+    parse_tiu_reg(&reg, regs);
+    pmu_descs_add(d, eng_id, reg.cmd_id_tpu, reg.layer_info);
+  } else {
+    tdma_reg_t reg;
+    parse_tdma_reg(&reg, regs);
+    pmu_descs_add(d, eng_id, reg.cmd_id, reg.layer_ID);
+  }
+}
+
+int cvkcv180x_pmu_decode(
+    struct cvikernel_context *ctx,
+    const uint8_t *dmabuf,
+    uint32_t dmabuf_size,
+    const uint8_t *pmu,
+    uint32_t pmu_size,
+    cvk_pmu_event_t *events,
+    uint32_t max_events,
+    uint32_t *nr_events)
+{
+  pmu_descs_t d;
+
+  (void)ctx;
+  memset(&d, 0, sizeof(d));
+
+  int ret = cvkcv180x_dmabuf_walk(dmabuf, dmabuf_size, pmu_add_desc, &d);
+  if (ret >= 0)
+    ret = pmu_decode_records(&d, pmu, pmu_size, events, max_events,
+                             nr_events);
+  else if (nr_events)
+    *nr_events = 0;
+
+  pmu_descs_free(&d);
+  return (ret < 0) ? -1 : 0;
+}
+
+uint32_t cvkcv180x_pmu_layer_report(
+    struct cvikernel_context *ctx,
+    const cvk_pmu_event_t *events,
+    uint32_t nr_events,
+    cvk_pmu_layer_t *layers,
+    uint32_t max_layers)
+{
+  (void)ctx;
+  return pmu_layer_report(events, nr_events, layers, max_layers);
+}
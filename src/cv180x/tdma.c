@@ -329,12 +329,21 @@ static ec_desc_t * emit_tdma_cmdbuf(cvk_context_t *ctx, tdma_reg_t *reg)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
   desc_pair_t *dp = cvkcv180x_get_desc_pair(ctx, CV180X_TDMA);
+  if (!dp) {
+    printf("cvkcv180x tdma: fail to allocate descriptor\n");
+    prv_data->nr_dropped_cmds++;
+    return NULL;
+  }
 
   reg->layer_ID = prv_data->layer_id;
   //CHECK(status, reg->rsv5 != 0x0);// "this is debug use, it's fine for skip";
 
-  uint32_t *cmdbuf = (uint32_t *)dp->cmd_hdr->cmd;
+  uint32_t *cmdbuf = cvkcv180x_desc_pair_body(ctx, dp);
   emit_tdma_reg(reg, cmdbuf);
+  cvkcv180x_desc_pair_emitted(ctx, dp);
+  cvkcv180x_record_tdma_hazard(ctx, dp->ec_desc, reg);
+  if (prv_data->stats.enabled)
+    cvkcv180x_stats_record_tdma(ctx, reg);
 
   return dp->ec_desc;
 }
@@ -440,6 +449,7 @@ void cvkcv180x_tdma_l2l_tensor_copy(
   reg.outstanding_en = p->outstanding;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2l: wrong parameter\n");
     return;
   }
@@ -501,6 +511,7 @@ void cvkcv180x_tdma_l2l_bf16_tensor_copy(
   reg.outstanding_en = p->outstanding;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2l bf16: wrong parameter\n");
     return;
   }
@@ -626,6 +637,7 @@ void cvkcv180x_tdma_l2l_tensor_lrn_shift(
   }
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tdma l2l lrn shift: wrong parameter\n");
     return;
   }
@@ -677,6 +689,7 @@ static void tdma_l2g_tensor_copy(
   reg.intra_cmd_paral = p->intra_cmd_paral;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g: wrong parameter\n");
     return;
   }
@@ -731,6 +744,7 @@ static void tdma_l2g_bf16_tensor_copy(
   //trace_tdma_reg(&reg, __func__);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g bf16: wrong parameter\n");
     return;
   }
@@ -779,6 +793,7 @@ static void tdma_l2g_tensor_copy_nc_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvcv180x l2g nc tp: wrong parameter\n");
     return;
   }
@@ -829,6 +844,7 @@ static void tdma_l2g_bf16_tensor_copy_nc_transposed(
   set_int8_rnd_mode(&reg, p->dst->int8_rnd_mode);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x: l2g bf16 nc tp: wrong parameter\n");
     return;
   }
@@ -877,6 +893,7 @@ static void tdma_l2g_tensor_copy_cw_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g cw tp: wrong parameter\n");
     return;
   }
@@ -930,6 +947,7 @@ static void tdma_l2g_bf16_tensor_copy_cw_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g bf16 cw tp: wrong parameter\n");
     return;
   }
@@ -1002,6 +1020,7 @@ static void tdma_l2g_tensor_copy_compressed(
   reg.intra_cmd_paral = p->intra_cmd_paral;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x: l2g cmpr: wrong parameter\n");
     return;
   }
@@ -1041,6 +1060,7 @@ static void tdma_l2g_tensor_fill_constant(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g fill const: wrong parameter\n");
     return;
   }
@@ -1083,6 +1103,7 @@ static void tdma_l2g_matrix_copy(
   fill_dst_c_stride(&reg, p->dst->stride.row);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g matrix: wrong parameter\n");
     return;
   }
@@ -1148,6 +1169,7 @@ static void tdma_l2g_matrix_copy_compressed(
   fill_dst_c_stride(&reg, p->dst->m.stride.row);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g matrix cmpr: wrong parameter\n");
     return;
   }
@@ -1193,6 +1215,7 @@ static void tdma_l2g_bf16_matrix_copy(
   set_int8_rnd_mode(&reg, p->dst->int8_rnd_mode);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g bf16 matrix: wrong paramter\n");
     return;
   }
@@ -1224,6 +1247,7 @@ static void tdma_l2g_general_copy(
   reg.src_n_stride = p->bytes;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g general: wrong parameter\n");
     return;
   }
@@ -1258,6 +1282,7 @@ static void tdma_l2g_bf16_general_copy(
   reg.src_n_stride = p->src_bytes;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x l2g bf16 general: wrong parameter\n");
     return;
   }
@@ -1413,6 +1438,7 @@ static void tdma_g2l_tensor_copy(
   reg.intra_cmd_paral = p->intra_cmd_paral;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l: wrong parameter\n");
     return;
   }
@@ -1465,6 +1491,7 @@ static void tdma_g2l_bf16_tensor_copy(
   reg.intra_cmd_paral = p->intra_cmd_paral;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l bf16: wrong parameter\n");
     return;
   }
@@ -1515,6 +1542,7 @@ static void tdma_g2l_tensor_copy_nc_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l nc tp: wrong parameter\n");
     return;
   }
@@ -1566,6 +1594,7 @@ static void tdma_g2l_bf16_tensor_copy_nc_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l bf16 nc tp: wrong parameter\n");
     return;
   }
@@ -1629,6 +1658,7 @@ static void tdma_g2l_tensor_copy_chw_rotated(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l chw: wrong parameter\n");
     return;
   }
@@ -1681,6 +1711,7 @@ static void tdma_g2l_tensor_copy_decompressed(
   reg.intra_cmd_paral = p->intra_cmd_paral;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l cmpr: wrong parameter\n");
     return;
   }
@@ -1720,6 +1751,7 @@ static void tdma_g2l_tensor_fill_constant(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l fill const: wrong parameter\n");
     return;
   }
@@ -1757,6 +1789,7 @@ static void tdma_g2l_bf16_tensor_fill_constant(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l bf16 fill const: wrong parameter\n");
     return;
   }
@@ -1801,6 +1834,7 @@ static void tdma_g2l_matrix_copy(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l matrix: wrong parameter\n");
     return;
   }
@@ -1849,6 +1883,7 @@ static void tdma_g2l_matrix_copy_decompressed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l matrix cmpr: wrong parameter\n");
     return;
   }
@@ -1895,6 +1930,7 @@ static void tdma_g2l_bf16_matrix_copy(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l bf16 matrix: wrong parameter\n");
     return;
   }
@@ -1949,6 +1985,7 @@ static void tdma_g2l_matrix_copy_row_col_transposed(
   reg.dst_h_stride = p->dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l matrix tp: wrong parameter\n");
     return;
   }
@@ -1979,6 +2016,7 @@ static void tdma_g2l_general_copy(
   reg.src_n_stride = p->bytes;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l general: wrong parameter\n");
     return;
   }
@@ -2014,6 +2052,7 @@ static void tdma_g2l_bf16_general_copy(
   reg.src_n_stride = p->src_bytes;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x g2l bf16 general: wrong parameter\n");
     return;
   }
@@ -2228,6 +2267,7 @@ static void cvkcv180x_tdma_bf16_copy_gmem(
   reg.dst_h_stride = p-> dst->stride.h;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x bf16 gmem: wrong parameter\n");
     return;
   }
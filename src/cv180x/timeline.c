@@ -0,0 +1,281 @@
+#include "cvkcv180x.h"
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Replay of a cmdbuf on in-order engine queues, honoring the sync ids.
+//
+// A descriptor waits for its engine and for the descriptor of the other
+// engine named by its wait id: cmd_id_gdma in tiu, wait_id_tpu in tdma,
+// 0 for none. Ids are dense from 1 within a segment, a segment ends at a
+// cpu descriptor or an own id of 0xffff, where all engines sync.
+//
+typedef struct {
+  uint32_t nr;
+  uint32_t max_nr;
+  uint64_t *end;            // by id - 1
+  uint32_t *desc;
+} id_ends_t;
+
+static int id_ends_add(id_ends_t *e, uint64_t end, uint32_t desc)
+{
+  if (e->nr == e->max_nr) {
+    uint32_t max_nr = e->max_nr ? e->max_nr * 2 : 256;
+    uint64_t *ends = realloc(e->end, max_nr * sizeof(*ends));
+    if (!ends)
+      return -1;
+    e->end = ends;
+
+    uint32_t *descs = realloc(e->desc, max_nr * sizeof(*descs));
+    if (!descs)
+      return -1;
+    e->desc = descs;
+
+    e->max_nr = max_nr;
+  }
+
+  e->end[e->nr] = end;
+  e->desc[e->nr] = desc;
+  e->nr++;
+  return 0;
+}
+
+typedef struct {
+  uint64_t last_end[CV180X_ENGINE_NUM];
+  uint64_t sync;            // start of the current segment
+  id_ends_t ids[CV180X_ENGINE_NUM];
+} timeline_t;
+
+static void timeline_sync(timeline_t *tl)
+{
+  for (uint32_t i = 0; i < CV180X_ENGINE_NUM; i++) {
+    if (tl->last_end[i] > tl->sync)
+      tl->sync = tl->last_end[i];
+    tl->ids[i].nr = 0;
+  }
+}
+
+static void timeline_free(timeline_t *tl)
+{
+  for (uint32_t i = 0; i < CV180X_ENGINE_NUM; i++) {
+    free(tl->ids[i].end);
+    free(tl->ids[i].desc);
+  }
+}
+
+// Engine, layer, own and waited ids of a descriptor.
+static void desc_ids(
+    const cvk_desc_template_t *t,
+    cvk_timeline_event_t *ev)
+{
+  ev->engine_id = t->engine_id;
+
+  if (t->engine_id == CV180X_TIU) {
+    tiu_reg_t reg;
+    parse_tiu_reg(&reg, t->regs);
+    ev->layer_id = reg.layer_info;
+    ev->id = reg.cmd_id_tpu;
+    ev->wait_engine_id = CV180X_TDMA;
+    ev->wait_id = reg.cmd_id_gdma;
+  } else {
+    tdma_reg_t reg;
+    parse_tdma_reg(&reg, t->regs);
+    ev->layer_id = reg.layer_ID;
+    ev->id = reg.cmd_id;
+    ev->wait_engine_id = CV180X_TIU;
+    ev->wait_id = reg.wait_id_tpu;
+  }
+}
+
+static int timeline_replay(
+    struct cvikernel_context *ctx,
+    const cvk_timeline_param_t *p,
+    timeline_t *tl,
+    cvk_timeline_event_t *events,
+    uint32_t max_events,
+    cvk_timeline_t *sum)
+{
+  const uint8_t *q = p->cmdbuf, *end = p->cmdbuf + p->size;
+
+  while (q < end) {
+    const cmd_hdr_t *hdr = (const cmd_hdr_t *)q;
+    uint32_t len = 0;
+
+    if (q + sizeof(*hdr) <= end)
+      len = hdr->len ? hdr->len : hdr->mask;
+
+    if (!len || hdr->magic != CMDBUF_HDR_MAGIC_180X ||
+        len > (uint64_t)(end - q) - sizeof(*hdr)) {
+      printf("cvkcv180x timeline: malformed cmdbuf at %u\n",
+             (uint32_t)(q - p->cmdbuf));
+      return -1;
+    }
+    q += sizeof(*hdr) + len;
+
+    if (hdr->engine_id != CV180X_TIU && hdr->engine_id != CV180X_TDMA) {
+      timeline_sync(tl);
+      continue;
+    }
+
+    cvk_desc_template_t t;
+    cvk_timeline_event_t ev;
+    memset(&t, 0, sizeof(t));
+    memset(&ev, 0, sizeof(ev));
+    t.engine_id = hdr->engine_id;
+    memcpy(t.regs, hdr->cmd, (hdr->engine_id == CV180X_TIU) ?
+           TIU_DESC_REG_BYTES : TDMA_DESC_REG_BYTES);
+    desc_ids(&t, &ev);
+
+    uint64_t cycles;
+    if (p->cost) {
+      cycles = p->cost(p->cost_arg, &t);
+    } else {
+      cvk_desc_cost_t c;
+      cvkcv180x_desc_cost(ctx, &t, &c);
+      cycles = c.cycles;
+    }
+
+    uint32_t ei = ev.engine_id;
+    id_ends_t *own = &tl->ids[ei];
+    id_ends_t *other = &tl->ids[ev.wait_engine_id];
+
+    if (ev.id != own->nr + 1 || ev.wait_id > other->nr) {
+      printf("cvkcv180x timeline: desc %u has id %u waiting for %u\n",
+             sum->nr_events, ev.id, ev.wait_id);
+      return -1;
+    }
+
+    uint64_t ready = tl->last_end[ei];
+    ev.stall_reason = CVK_STALL_NONE;
+    if (tl->sync > ready) {
+      ready = tl->sync;
+      ev.stall_reason = CVK_STALL_SYNC;
+    }
+    if (ev.wait_id) {
+      ev.wait_desc = other->desc[ev.wait_id - 1];
+      if (other->end[ev.wait_id - 1] > ready) {
+        ready = other->end[ev.wait_id - 1];
+        ev.stall_reason = CVK_STALL_WAIT;
+      }
+    }
+
+    ev.start = ready;
+    ev.end = ready + cycles;
+    ev.stall = ready - tl->last_end[ei];
+    tl->last_end[ei] = ev.end;
+
+    if (id_ends_add(own, ev.end, sum->nr_events)) {
+      printf("cvkcv180x timeline: out of memory\n");
+      return -1;
+    }
+
+    if (ei == CV180X_TIU) {
+      sum->tiu_busy += cycles;
+      sum->tiu_stall += ev.stall;
+    } else {
+      sum->tdma_busy += cycles;
+      sum->tdma_stall += ev.stall;
+    }
+    if (ev.end > sum->cycles)
+      sum->cycles = ev.end;
+
+    if (sum->nr_events < max_events)
+      events[sum->nr_events] = ev;
+    sum->nr_events++;
+
+    if (ev.id == 0xffff)
+      timeline_sync(tl);
+  }
+
+  return 0;
+}
+
+int cvkcv180x_cmdbuf_timeline(
+    struct cvikernel_context *ctx,
+    const cvk_timeline_param_t *p,
+    cvk_timeline_event_t *events,
+    uint32_t max_events,
+    cvk_timeline_t *summary)
+{
+  timeline_t tl;
+  cvk_timeline_t sum;
+
+  memset(&tl, 0, sizeof(tl));
+  memset(&sum, 0, sizeof(sum));
+
+  int ret = timeline_replay(ctx, p, &tl, events, max_events, &sum);
+  timeline_free(&tl);
+
+  if (summary)
+    *summary = sum;
+
+  return ret;
+}
+
+static const char *engine_name(uint32_t engine_id)
+{
+  return (engine_id == CV180X_TIU) ? "tiu" : "tdma";
+}
+
+int cvkcv180x_timeline_trace(
+    struct cvikernel_context *ctx,
+    const cvk_timeline_event_t *events,
+    uint32_t nr_events,
+    const char *path)
+{
+  (void)ctx;
+
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    printf("cvkcv180x timeline trace: cannot open %s\n", path);
+    return -1;
+  }
+
+  fprintf(fp, "{\"otherData\": {\"unit\": \"cycles\"}, \"traceEvents\": [\n");
+  fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+              "\"tid\": %d, \"args\": {\"name\": \"tiu\"}},\n", CV180X_TIU);
+  fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+              "\"tid\": %d, \"args\": {\"name\": \"tdma\"}}", CV180X_TDMA);
+
+  for (uint32_t i = 0; i < nr_events; i++) {
+    const cvk_timeline_event_t *ev = &events[i];
+
+    if (ev->stall && ev->stall_reason == CVK_STALL_WAIT) {
+      const cvk_timeline_event_t *w =
+          (ev->wait_desc < nr_events) ? &events[ev->wait_desc] : NULL;
+      fprintf(fp, ",\n{\"name\": \"wait %s %u\", \"cat\": \"stall\", "
+                  "\"ph\": \"X\", \"pid\": 0, \"tid\": %u, "
+                  "\"ts\": %llu, \"dur\": %llu, "
+                  "\"args\": {\"layer_id\": %u, \"wait_layer_id\": %d}}",
+              engine_name(ev->wait_engine_id), ev->wait_id, ev->engine_id,
+              (unsigned long long)(ev->start - ev->stall),
+              (unsigned long long)ev->stall, ev->layer_id,
+              w ? (int)w->layer_id : -1);
+    } else if (ev->stall && ev->stall_reason == CVK_STALL_SYNC) {
+      fprintf(fp, ",\n{\"name\": \"sync\", \"cat\": \"stall\", "
+                  "\"ph\": \"X\", \"pid\": 0, \"tid\": %u, "
+                  "\"ts\": %llu, \"dur\": %llu, "
+                  "\"args\": {\"layer_id\": %u}}",
+              ev->engine_id,
+              (unsigned long long)(ev->start - ev->stall),
+              (unsigned long long)ev->stall, ev->layer_id);
+    }
+
+    fprintf(fp, ",\n{\"name\": \"layer %u\", \"cat\": \"%s\", "
+                "\"ph\": \"X\", \"pid\": 0, \"tid\": %u, "
+                "\"ts\": %llu, \"dur\": %llu, "
+                "\"args\": {\"layer_id\": %u, \"id\": %u, \"wait_id\": %u}}",
+            ev->layer_id, engine_name(ev->engine_id), ev->engine_id,
+            (unsigned long long)ev->start,
+            (unsigned long long)(ev->end - ev->start),
+            ev->layer_id, ev->id, ev->wait_id);
+  }
+
+  fprintf(fp, "\n]}\n");
+
+  int ret = ferror(fp) ? -1 : 0;
+  if (fclose(fp))
+    ret = -1;
+
+  return ret;
+}
@@ -80,6 +80,7 @@ void cvkcv180x_tiu_add(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu_add: wrong parameter\n");
     return;
   }
@@ -86,6 +86,7 @@ void cvkcv180x_tiu_average_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu avg pool: wrong parameter\n");
     return;
   }
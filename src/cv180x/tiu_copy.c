@@ -39,6 +39,7 @@ void cvkcv180x_tiu_copy(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu copy: wrong parameter\n");
     return;
   }
@@ -139,6 +139,7 @@ void cvkcv180x_tiu_depthwise_convolution(
   reg.cmd_pre_exe = p->cmd_pre_exe;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu_dw_conv: wrong parameter\n");
     return;
   }
@@ -53,6 +53,7 @@ void cvkcv180x_tiu_ge(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu ge: wrong parameter\n");
     return;
   }
@@ -115,6 +116,7 @@ void cvkcv180x_tiu_ge(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu ge: wrong parameter\n");
     return;
   }
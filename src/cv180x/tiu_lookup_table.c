@@ -108,6 +108,7 @@ void cvkcv180x_tiu_lookup_table(
   reg.layer_info = p->layer_id;
   
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu lookup: wrong parameter\n");
     return;
   }
@@ -65,6 +65,7 @@ void cvkcv180x_tiu_mac(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu avg pool: wrong paramter\n");
     return;
   }
@@ -151,6 +151,7 @@ void cvkcv180x_tiu_matrix_multiplication(cvk_context_t *ctx, const cvk_tiu_matri
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu matrix: wrong parameter");
     assert(0);
     return;
@@ -54,6 +54,7 @@ void cvkcv180x_tiu_max(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu max: wrong parameter\n");
     return;
   }
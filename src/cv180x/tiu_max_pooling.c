@@ -66,6 +66,7 @@ void cvkcv180x_tiu_max_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu max pool: wrong parameter\n");
     return;
   }
@@ -55,6 +55,7 @@ void cvkcv180x_tiu_min(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu min: wrong parameter\n");
     return;
   }
@@ -57,6 +57,7 @@ void cvkcv180x_tiu_min_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu min pool: wrong parameter\n");
     return;
   }
@@ -132,6 +133,7 @@ void cvkcv180x_tiu_min_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu min pool: wrong parameter\n");
     return;
   }
@@ -64,6 +64,7 @@ void cvkcv180x_tiu_mul_qm(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu mul qm: wrong parameter\n");
   }
 
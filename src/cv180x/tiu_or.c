@@ -40,6 +40,7 @@ void cvkcv180x_tiu_or_int8(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu or: wrong parameter\n");
     return;
   }
@@ -104,6 +105,7 @@ void cvkcv180x_tiu_or_int16(
   fill_res0_stride(&reg, &p->res_low->stride);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu or: wrong parameter\n");
     return;
   }
@@ -1,16 +1,27 @@
 #include "cvkcv180x.h"
 
-static int can_do_double_conv(cvk_context_t *ctx, const cvk_tiu_pt_convolution_param_t *p)
+// CVK_CONV_SINGLE_* reasons against double conv, 0 if it can be done.
+static uint32_t single_conv_reasons(cvk_context_t *ctx, const cvk_tiu_pt_convolution_param_t *p)
 {
-  uint8_t bf16_enable = (p->ifmap->fmt == CVK_FMT_BF16) ? 1 : 0;
-
-  if (((p->ifmap->start_address % ctx->info.lmem_size) % 2 == 0 &&
-      p->ifmap->shape.c % 2 == 0 &&
-      p->ifmap->shape.c >= 4 &&
-      p->weight->start_address % 2 == 0) && !bf16_enable)
-    return 1;
+  uint32_t reasons = 0;
+
+  if ((p->ifmap->start_address % ctx->info.lmem_size) % 2)
+    reasons |= CVK_CONV_SINGLE_IFMAP_ADDR;
+  if (p->ifmap->shape.c % 2)
+    reasons |= CVK_CONV_SINGLE_ODD_C;
+  if (p->ifmap->shape.c < 4)
+    reasons |= CVK_CONV_SINGLE_SMALL_C;
+  if (p->weight->start_address % 2)
+    reasons |= CVK_CONV_SINGLE_WEIGHT_ADDR;
+  if (p->ifmap->fmt == CVK_FMT_BF16)
+    reasons |= CVK_CONV_SINGLE_BF16;
+
+  return reasons;
+}
 
-  return 0;
+static int can_do_double_conv(cvk_context_t *ctx, const cvk_tiu_pt_convolution_param_t *p)
+{
+  return !single_conv_reasons(ctx, p);
 }
 
 static int8_t check_conv_param(cvk_context_t *ctx, const cvk_tiu_pt_convolution_param_t *p)
@@ -175,6 +186,7 @@ void cvkcv180x_tiu_pt_convolution(cvk_context_t *ctx, const cvk_tiu_pt_convoluti
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu_pt_conv: wrong parameter\n");
     return;
   }
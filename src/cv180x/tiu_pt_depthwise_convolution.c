@@ -150,6 +150,7 @@ void cvkcv180x_tiu_pt_depthwise_convolution(
   reg.cmd_pre_exe = p->cmd_pre_exe;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x pt dw-conv: invalid param\n");
     return;
   }
@@ -55,6 +55,7 @@ void cvkcv180x_tiu_arith_shift(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu shift: wrong parameter\n");
     return;
   }
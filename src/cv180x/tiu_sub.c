@@ -65,6 +65,7 @@ void cvkcv180x_tiu_sub(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu sub: wrong parameter\n");
     return;
   }
@@ -39,6 +39,7 @@ void cvkcv180x_tiu_xor_int8(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu xor: wrong parameter\n");
     return;
   }
@@ -103,6 +104,7 @@ void cvkcv180x_tiu_xor_int16(
   fill_res0_stride(&reg, &p->res_low->stride);
 
   if (status) {
+    cvkcv180x_check_failed(ctx);
     printf("cvkcv180x tiu xor: wrong parameter\n");
     return;
   }
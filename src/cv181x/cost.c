@@ -0,0 +1,260 @@
+#include "cvkcv181x.h"
+#include <string.h>
+#include "cost_model.h"
+
+//
+// Analytic cycle estimate of tiu/tdma descriptors from their registers,
+// with the nominal figures of the tiling cost model.
+//
+void cvkcv181x_tiu_cost(const tiu_reg_t *r, cvk_desc_cost_t *cost)
+{
+  uint64_t res_hw = (uint64_t)r->res0_h * r->res0_w;
+  uint64_t passes = cost_tiu_passes(CV181X_HW_NPU_NUM, CV181X_HW_EU_NUM,
+                                    r->res0_n, r->res0_c, res_hw);
+  uint64_t kernel = (uint64_t)r->opd1_h * r->opd1_w;
+  uint64_t steps, macs;
+
+  switch (r->tsk_typ) {
+    case DCR_TYPE_CONV_FIX8B: {
+      // Weight is (ic, oc, kh, kw), double conv takes two ic per step.
+      uint64_t ic = r->opd0_c;
+      macs = (uint64_t)r->res0_n * r->res0_c * res_hw * ic * kernel;
+      if (r->double_conv)
+        ic = cost_ceil_div(ic, 2);
+      steps = passes * ic * kernel;
+
+      // Partial sums are read and written as four bytes per element.
+      if (r->ps32_md & 1)
+        steps += passes * 4;
+      if (r->ps32_md & 2)
+        steps += passes * 3;
+      break;
+    }
+    case DCR_TYPE_DEPTHWISE_POOL_FIX8B:
+      macs = (uint64_t)r->res0_n * r->res0_c * res_hw * kernel;
+      steps = passes * kernel;
+      break;
+    case DCR_TYPE_FC_FIX8B: {
+      // Left is (m, k) spread over opd0_c lanes, the last one opd1_w wide.
+      uint64_t k = (uint64_t)(r->opd0_c - 1) * r->opd0_w + r->opd1_w;
+      if (!r->opd0_c)
+        k = 0;
+      macs = (uint64_t)r->res0_n * r->res0_c * r->res0_w * k;
+      steps = passes * k;
+
+      if (r->ps32_md & 1)
+        steps += passes * 4;
+      if (r->ps32_md & 2)
+        steps += passes * 3;
+      break;
+    }
+    default:
+      // Element ops, a 16 bit result is written as two planes.
+      macs = (uint64_t)r->res0_n * r->res0_c * res_hw;
+      steps = passes * (r->opt_res0_seg ? 1 : 2);
+      break;
+  }
+
+  cost->cycles = cost_tiu_cycles(1, steps);
+  cost->macs = macs;
+  cost->bytes = 0;
+}
+
+typedef struct {
+  uint32_t n, c, h, w;
+  uint64_t n_str, c_str, h_str;
+} gmem_opd_t;
+
+// Cycles to move a global memory operand, a burst per contiguous run.
+static uint64_t gmem_burst_cycles(const gmem_opd_t *o, uint32_t esize)
+{
+  uint64_t run = (uint64_t)o->w * esize;
+  uint64_t nr_runs = (uint64_t)o->n * o->c * o->h;
+
+  if (o->h_str == run) {
+    run *= o->h;
+    nr_runs /= o->h ? o->h : 1;
+    if (o->c_str == run) {
+      run *= o->c;
+      nr_runs /= o->c ? o->c : 1;
+      if (o->n_str == run || o->n == 1) {
+        run *= o->n;
+        nr_runs = 1;
+      }
+    }
+  }
+
+  return nr_runs * cost_tdma_move_cycles(run, 1);
+}
+
+void cvkcv181x_tdma_cost(const tdma_reg_t *r, cvk_desc_cost_t *cost)
+{
+  int src_gmem = (r->trans_dir == 0 || r->trans_dir == 2);
+  int dst_gmem = (r->trans_dir == 1 || r->trans_dir == 2);
+  uint32_t esize = (r->src_fmt == 2) ? 2 : 1;
+  uint64_t bytes, cycles;
+
+  if (r->trans_fmt) {
+    // General copy, a linear byte stream.
+    bytes = r->src_n_stride;
+    cycles = cost_tdma_move_cycles(bytes, 1);
+  } else if (r->spec_func == 4) {
+    // Constant fill, nothing is read.
+    bytes = (uint64_t)r->src_n * r->dst_c * r->dst_h * r->dst_w * esize;
+    cycles = cost_tdma_move_cycles(bytes, 0);
+  } else if (r->sys_dtype) {
+    // Matrix, rows of cols elements on the global memory side, the row
+    // stride in the c stride.
+    gmem_opd_t m = {
+      1, r->src_n, 1, r->src_w, 0,
+      r->src_c_stride_low | ((uint64_t)r->src_c_stride_high << 16),
+      (uint64_t)r->src_w * esize
+    };
+    if (!src_gmem) {
+      m.c = r->dst_c;
+      m.w = r->dst_w;
+      m.c_str = r->dst_c_stride_low | ((uint64_t)r->dst_c_stride_high << 16);
+      m.h_str = (uint64_t)r->dst_w * esize;
+    }
+
+    bytes = (uint64_t)m.c * m.w * esize;
+    cycles = cost_tdma_move_cycles(bytes, 0);
+
+    if (r->compress_en) {
+      uint64_t c = cost_ceil_div(bytes, TDMA_CMPR_BYTES_PER_CYCLE);
+      cycles = (c > cycles) ? c : cycles;
+    } else if (src_gmem || dst_gmem) {
+      uint64_t c = gmem_burst_cycles(&m, esize);
+      cycles = (c > cycles) ? c : cycles;
+    }
+  } else {
+    uint64_t elts = (uint64_t)r->src_n * r->src_c * r->src_h * r->src_w;
+    bytes = elts * esize;
+    cycles = cost_tdma_move_cycles(bytes, 0);
+
+    if (r->compress_en) {
+      // The compressed side is one stream, the codec sets the pace.
+      uint64_t c = cost_ceil_div(bytes, TDMA_CMPR_BYTES_PER_CYCLE);
+      cycles = (c > cycles) ? c : cycles;
+    } else if (r->spec_func == 1 && r->transpose_md) {
+      // Transposes within a plane scatter every element.
+      uint64_t c = elts * (1 + TDMA_BURST_CYCLES);
+      cycles = (c > cycles) ? c : cycles;
+    } else {
+      if (src_gmem) {
+        gmem_opd_t src = {
+          r->src_n, r->src_c, r->src_h, r->src_w,
+          r->src_n_stride,
+          r->src_c_stride_low | ((uint64_t)r->src_c_stride_high << 16),
+          r->src_h_stride
+        };
+        uint64_t c = gmem_burst_cycles(&src, esize);
+        cycles = (c > cycles) ? c : cycles;
+      }
+
+      if (dst_gmem) {
+        // Destination has no n, it holds whatever src_n does not cover.
+        uint64_t chw = (uint64_t)r->dst_c * r->dst_h * r->dst_w;
+        gmem_opd_t dst = {
+          chw ? (uint32_t)(elts / chw) : 0, r->dst_c, r->dst_h, r->dst_w,
+          r->dst_n_stride,
+          r->dst_c_stride_low | ((uint64_t)r->dst_c_stride_high << 16),
+          r->dst_h_stride
+        };
+        uint64_t c = gmem_burst_cycles(&dst, (r->dst_fmt == 2) ? 2 : 1);
+        cycles = (c > cycles) ? c : cycles;
+      }
+    }
+  }
+
+  cost->cycles = TDMA_DESC_CYCLES + cycles;
+  cost->macs = 0;
+  cost->bytes = bytes;
+}
+
+static int desc_regs_cost(
+    uint32_t engine_id,
+    const uint32_t *regs,
+    cvk_desc_cost_t *cost)
+{
+  switch (engine_id) {
+    case CV181X_TIU: {
+      tiu_reg_t reg;
+      parse_tiu_reg(&reg, regs);
+      cvkcv181x_tiu_cost(&reg, cost);
+      return 0;
+    }
+    case CV181X_TDMA: {
+      tdma_reg_t reg;
+      parse_tdma_reg(&reg, regs);
+      cvkcv181x_tdma_cost(&reg, cost);
+      return 0;
+    }
+    default:
+      return -1;
+  }
+}
+
+int cvkcv181x_desc_cost(
+    struct cvikernel_context *ctx,
+    const cvk_desc_template_t *desc,
+    cvk_desc_cost_t *cost)
+{
+  (void)ctx;
+
+  if (desc_regs_cost(desc->engine_id, desc->regs, cost)) {
+    printf("cvkcv181x desc cost: unknown engine %u\n", desc->engine_id);
+    return -1;
+  }
+
+  return 0;
+}
+
+int cvkcv181x_cmdbuf_cost(
+    struct cvikernel_context *ctx,
+    const uint8_t *cmdbuf,
+    uint32_t size,
+    cvk_cmdbuf_cost_t *cost)
+{
+  const uint8_t *p = cmdbuf, *end = cmdbuf + size;
+
+  (void)ctx;
+  memset(cost, 0, sizeof(*cost));
+
+  while (p < end) {
+    const cmd_hdr_t *hdr = (const cmd_hdr_t *)p;
+    uint32_t len = 0;
+
+    if (p + sizeof(*hdr) <= end)
+      len = hdr->len ? hdr->len : hdr->mask;
+
+    if (!len || hdr->magic != CMDBUF_HDR_MAGIC_181X ||
+        len > (uint64_t)(end - p) - sizeof(*hdr)) {
+      printf("cvkcv181x cmdbuf cost: malformed cmdbuf at %u\n",
+             (uint32_t)(p - cmdbuf));
+      return -1;
+    }
+
+    // Registers may be unaligned in the cmdbuf.
+    uint32_t regs[CVK_DESC_TEMPLATE_WORDS];
+    cvk_desc_cost_t c;
+
+    if (hdr->engine_id == CV181X_TIU) {
+      memcpy(regs, hdr->cmd, TIU_DESC_REG_BYTES);
+      desc_regs_cost(CV181X_TIU, regs, &c);
+      cost->nr_tiu++;
+      cost->tiu_cycles += c.cycles;
+      cost->macs += c.macs;
+    } else if (hdr->engine_id == CV181X_TDMA) {
+      memcpy(regs, hdr->cmd, TDMA_DESC_REG_BYTES);
+      desc_regs_cost(CV181X_TDMA, regs, &c);
+      cost->nr_tdma++;
+      cost->tdma_cycles += c.cycles;
+      cost->tdma_bytes += c.bytes;
+    }
+
+    p += sizeof(*hdr) + len;
+  }
+
+  return 0;
+}
@@ -1,4 +1,9 @@
 #include "cvkcv181x.h"
+#include "lmem_plan.h"
+#include "conv_tiled.h"
+#include "gemm_tiled.h"
+#include "eltwise_tiled.h"
+#include "pool_tiled.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -21,25 +26,37 @@ static inline int bitsize_of_fmt(cvk_fmt_t fmt)
   }
 }
 
+// Patch sync ids in place, same result as parse_*_reg/emit_*_reg:
+//   TIU : p[0] bit 2 cmd_id_en, p[1] cmd_id_tpu[15:0] | cmd_id_gdma[31:16]
+//   TDMA: p[0] bit 4 bar_en, cmd_id[31:16], p[1] wait_id_tpu[31:16]
 static void cvkcv181x_replace_cmd_id(uint32_t *desc, uint32_t eng_id, uint16_t ids[])
 {
   if (eng_id == CV181X_TIU) {
-    tiu_reg_t reg;
-    parse_tiu_reg(&reg, desc);
-    reg.cmd_id_en = 1;
-    reg.cmd_id_tpu = ids[eng_id];
-    reg.cmd_id_gdma = ids[CV181X_TDMA];
-    emit_tiu_reg(&reg, desc);
+    desc[0] |= 1u << 2;
+    desc[1] = (uint32_t)ids[eng_id] | ((uint32_t)ids[CV181X_TDMA] << 16);
   } else if (eng_id == CV181X_TDMA) {
-    tdma_reg_t tdma_reg;
-    parse_tdma_reg(&tdma_reg, desc);
-    tdma_reg.cmd_id = ids[eng_id];
-    tdma_reg.wait_id_tpu = ids[CV181X_TIU];
-    tdma_reg.bar_en = 1;
-    emit_tdma_reg(&tdma_reg, desc);
+    desc[0] = (desc[0] & 0xffff) | (1u << 4) | ((uint32_t)ids[eng_id] << 16);
+    desc[1] = (desc[1] & 0xffff) | ((uint32_t)ids[CV181X_TIU] << 16);
   }
 }
 
+// Patch descriptors whose sync ids became final since the last call.
+static void cvkcv181x_sync_final_desc(cvk_prv_data_t *prv_data)
+{
+  uint32_t nr_final = prv_data->ec.nr_final;
+
+  for (uint32_t di = prv_data->nr_synced_desc; di < nr_final; di++) {
+    desc_pair_t *dp = &prv_data->desc_pairs[di];
+    uint8_t eng_id = dp->ec_desc->engine_id;
+    uint32_t *desc = dp->cmd_hdr ? (uint32_t *)dp->cmd_hdr->cmd
+                     : cvkcv181x_dmabuf_writer_reg(&prv_data->dmabuf_writer,
+                                                   eng_id, dp->dmabuf_offset);
+    cvkcv181x_replace_cmd_id(desc, eng_id, dp->ec_desc->sync_ids);
+  }
+
+  prv_data->nr_synced_desc = nr_final;
+}
+
 static int cvkcv181x_get_engine_desc_length(uint32_t engine_id)
 {
   switch (engine_id) {
@@ -78,11 +95,19 @@ static cmd_hdr_t *kernel_alloc_cmd_hdr(
   uint32_t free_len = prv_data->cmdbuf_size - prv_data->cmdbuf_ptr;
   uint32_t hdr_len = sizeof(cmd_hdr_t);
   uint32_t total_len = hdr_len + desc_len;
+  cmd_hdr_t *hdr;
 
-  if (total_len > free_len)
-    return NULL;
+  if (prv_data->growable) {
+    hdr = (cmd_hdr_t *)cmdbuf_chain_alloc(&prv_data->cmdbuf_chain, total_len);
+    if (!hdr)
+      return NULL;
+  } else {
+    if (total_len > free_len)
+      return NULL;
+
+    hdr = (cmd_hdr_t *)&prv_data->cmdbuf[prv_data->cmdbuf_ptr];
+  }
 
-  cmd_hdr_t *hdr = (cmd_hdr_t *)&prv_data->cmdbuf[prv_data->cmdbuf_ptr];
   hdr->magic = 0xA7; // CMDBUF_HDR_MAGIC_181X
   hdr->len = desc_len;
   hdr->engine_id = eng_id;
@@ -94,18 +119,57 @@ static cmd_hdr_t *kernel_alloc_cmd_hdr(
   return hdr;
 }
 
+static int kernel_grow_desc_pairs(cvk_prv_data_t *prv_data)
+{
+  uint32_t max_nr_desc = prv_data->max_nr_desc * 2;
+  desc_pair_t *desc_pairs =
+      realloc(prv_data->desc_pairs, max_nr_desc * sizeof(desc_pair_t));
+  if (!desc_pairs)
+    return -1;
+
+  prv_data->desc_pairs = desc_pairs;
+  prv_data->max_nr_desc = max_nr_desc;
+  return 0;
+}
+
 static desc_pair_t *kernel_alloc_desc_pair(cvk_context_t *ctx, uint8_t eng_id)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
 
-  if (eng_id >= CV181X_ENGINE_NUM || prv_data->cur_nr_desc >= prv_data->max_nr_desc)
+  if (eng_id >= CV181X_ENGINE_NUM)
     return NULL;
 
-  uint32_t desc_len = cvkcv181x_get_engine_desc_length(eng_id);
+  if (prv_data->cur_nr_desc >= prv_data->max_nr_desc) {
+    if (!prv_data->growable || kernel_grow_desc_pairs(prv_data))
+      return NULL;
+  }
+
+  cmd_hdr_t *cmd_hdr = NULL;
+  uint32_t dmabuf_offset = 0;
+  if (prv_data->direct_dmabuf) {
+    if (cvkcv181x_dmabuf_writer_alloc(&prv_data->dmabuf_writer, eng_id,
+                                      &dmabuf_offset))
+      return NULL;
+  } else {
+    uint32_t desc_len = cvkcv181x_get_engine_desc_length(eng_id);
+    cmd_hdr = kernel_alloc_cmd_hdr(ctx, eng_id, desc_len);
+    if (!cmd_hdr)
+      return NULL;
+  }
+
   desc_pair_t *dp = &prv_data->desc_pairs[prv_data->cur_nr_desc++];
-  dp->cmd_hdr = kernel_alloc_cmd_hdr(ctx, eng_id, desc_len);
+  dp->cmd_hdr = cmd_hdr;
+  dp->dmabuf_offset = dmabuf_offset;
   dp->ec_desc = ec_alloc_desc(&prv_data->ec, eng_id);
 
+  // Own sync id does not change any more, the dmabuf segment ends here.
+  if (prv_data->direct_dmabuf && dp->ec_desc->sync_ids[eng_id] == 0xffff)
+    prv_data->dmabuf_writer.close_pending = 1;
+
+  // Previous descriptor is emitted and its sync ids are final now.
+  if (!prv_data->ec.dirty)
+    cvkcv181x_sync_final_desc(prv_data);
+
   mode_manager_record_ec_desc(&prv_data->mode_manager, dp->ec_desc);
   return dp;
 }
@@ -113,14 +177,14 @@ static desc_pair_t *kernel_alloc_desc_pair(cvk_context_t *ctx, uint8_t eng_id)
 static void cvkcv181x_update_sync_id(cvk_context_t *ctx)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  // Sync ids are assigned while recording, only the last descriptor is
+  // left, unless out-of-order dependencies forced a full recompute.
   ec_compute_sync_ids(&prv_data->ec);
+  if (prv_data->ec.dirty)
+    prv_data->nr_synced_desc = 0;
 
-  for (uint32_t di = 0; di < prv_data->cur_nr_desc; di++) {
-    desc_pair_t *dp = &prv_data->desc_pairs[di];
-    uint8_t eng_id = dp->ec_desc->engine_id;
-    uint32_t *desc = (uint32_t *)dp->cmd_hdr->cmd;
-    cvkcv181x_replace_cmd_id(desc, eng_id, dp->ec_desc->sync_ids);
-  }
+  cvkcv181x_sync_final_desc(prv_data);
 }
 
 desc_pair_t *cvkcv181x_get_desc_pair(cvk_context_t *ctx, uint8_t eng_id)
@@ -138,6 +202,30 @@ desc_pair_t *cvkcv181x_get_desc_pair(cvk_context_t *ctx, uint8_t eng_id)
   return kernel_alloc_desc_pair(ctx, eng_id);
 }
 
+uint32_t *cvkcv181x_desc_pair_body(cvk_context_t *ctx, desc_pair_t *dp)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  if (dp->cmd_hdr)
+    return (uint32_t *)dp->cmd_hdr->cmd;
+
+  return cvkcv181x_dmabuf_writer_body(&prv_data->dmabuf_writer,
+                                      dp->ec_desc->engine_id,
+                                      dp->dmabuf_offset);
+}
+
+// Register is emitted, bring it into dmabuf form.
+void cvkcv181x_desc_pair_emitted(cvk_context_t *ctx, desc_pair_t *dp)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  if (dp->cmd_hdr)
+    return;
+
+  cvkcv181x_dmabuf_writer_emitted(&prv_data->dmabuf_writer,
+                                  dp->ec_desc->engine_id, dp->dmabuf_offset);
+}
+
 void cvkcv181x_cleanup(cvk_context_t *ctx)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
@@ -145,6 +233,18 @@ void cvkcv181x_cleanup(cvk_context_t *ctx)
   free(prv_data->desc_pairs);
   ec_destroy(&prv_data->ec);
   mode_manager_destroy(&prv_data->mode_manager);
+  cvkcv181x_dmabuf_writer_destroy(&prv_data->dmabuf_writer);
+  lmem_heap_destroy(&prv_data->lmem_heap);
+  desc_pool_destroy(&prv_data->tl_ml_pool);
+  cvkcv181x_conv_report_reset(ctx);
+  cvkcv181x_stats_reset(ctx);
+
+  if (prv_data->growable) {
+    cmdbuf_chain_destroy(&prv_data->cmdbuf_chain);
+    free(prv_data->cmdbuf);
+    prv_data->cmdbuf = NULL;
+    prv_data->cmdbuf_size = 0;
+  }
 }
 
 void cvkcv181x_reset(cvk_context_t *ctx)
@@ -152,8 +252,13 @@ void cvkcv181x_reset(cvk_context_t *ctx)
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
 
   prv_data->cur_nr_desc = 0;
+  prv_data->nr_synced_desc = 0;
   prv_data->cmdbuf_ptr = 0;
 
+  if (prv_data->growable)
+    cmdbuf_chain_reset(&prv_data->cmdbuf_chain);
+  cvkcv181x_dmabuf_writer_reset(&prv_data->dmabuf_writer);
+
   ec_reset(&prv_data->ec);
   mode_manager_reset(&prv_data->mode_manager);
 }
@@ -164,9 +269,80 @@ static uint8_t *cvkcv181x_acquire_cmdbuf(cvk_context_t *ctx, uint32_t *size)
 
   *size = prv_data->cmdbuf_ptr;
   cvkcv181x_update_sync_id(ctx);
+
+  if (prv_data->direct_dmabuf)
+    return cvkcv181x_dmabuf_writer_finish(&prv_data->dmabuf_writer, size);
+
+  if (!prv_data->growable)
+    return prv_data->cmdbuf;
+
+  // No copy if everything fits in the first chunk.
+  cmdbuf_chunk_t *head = prv_data->cmdbuf_chain.head;
+  if (!head || head->used == prv_data->cmdbuf_ptr)
+    return head ? head->buf : NULL;
+
+  if (prv_data->cmdbuf_size < prv_data->cmdbuf_ptr) {
+    free(prv_data->cmdbuf);
+    prv_data->cmdbuf_size = 0;
+    prv_data->cmdbuf = malloc(prv_data->cmdbuf_ptr);
+    if (!prv_data->cmdbuf) {
+      printf("cvkcv181x acquire cmdbuf: fail to allocate %u bytes\n",
+             prv_data->cmdbuf_ptr);
+      *size = 0;
+      return NULL;
+    }
+    prv_data->cmdbuf_size = prv_data->cmdbuf_ptr;
+  }
+
+  cmdbuf_chain_copy(&prv_data->cmdbuf_chain, prv_data->cmdbuf);
   return prv_data->cmdbuf;
 }
 
+static uint32_t cvkcv181x_acquire_cmdbuf_chunks(
+    cvk_context_t *ctx,
+    cvk_cmdbuf_chunk_t *chunks,
+    uint32_t max_chunks)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  uint32_t nr_chunks = 0;
+
+  cvkcv181x_update_sync_id(ctx);
+
+  if (prv_data->direct_dmabuf) {
+    uint32_t size;
+    uint8_t *dmabuf =
+        cvkcv181x_dmabuf_writer_finish(&prv_data->dmabuf_writer, &size);
+    if (!dmabuf)
+      return 0;
+    if (chunks && max_chunks) {
+      chunks[0].buf = dmabuf;
+      chunks[0].size = size;
+    }
+    return 1;
+  }
+
+  if (!prv_data->growable) {
+    if (chunks && max_chunks) {
+      chunks[0].buf = prv_data->cmdbuf;
+      chunks[0].size = prv_data->cmdbuf_ptr;
+    }
+    return 1;
+  }
+
+  for (cmdbuf_chunk_t *c = prv_data->cmdbuf_chain.head; c; c = c->next) {
+    if (!c->used)
+      continue;
+
+    if (chunks && nr_chunks < max_chunks) {
+      chunks[nr_chunks].buf = c->buf;
+      chunks[nr_chunks].size = c->used;
+    }
+    nr_chunks++;
+  }
+
+  return nr_chunks;
+}
+
 void cvkcv181x_set_layer_id(
     struct cvikernel_context *ctx,
     uint16_t layer_id)
@@ -190,6 +366,34 @@ void cvkcv181x_parallel_disable(struct cvikernel_context *ctx)
   mode_manager_disable_parallel(&prv_data->mode_manager);
 }
 
+void cvkcv181x_hazard_tracking_enable(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  mode_manager_enable_hazard(&prv_data->mode_manager);
+}
+
+void cvkcv181x_hazard_tracking_disable(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  mode_manager_disable_hazard(&prv_data->mode_manager);
+}
+
+int cvkcv181x_direct_dmabuf_enable(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  if (prv_data->cur_nr_desc) {
+    printf("cvkcv181x direct dmabuf: %u descriptors already recorded\n",
+           prv_data->cur_nr_desc);
+    return -1;
+  }
+
+  prv_data->direct_dmabuf = 1;
+  return 0;
+}
+
 cvk_tl_stride_t cvkcv181x_tl_default_stride(
     cvk_context_t *ctx,
     cvk_tl_shape_t s,
@@ -242,22 +446,21 @@ uint32_t cvkcv181x_lmem_tensor_to_size(
   return needed;
 }
 
-cvk_tl_t *cvkcv181x_lmem_alloc_tensor(
+static cvk_tl_t *lmem_alloc_tensor(
     cvk_context_t *ctx,
+    int bank_id,
     cvk_tl_shape_t shape,
     cvk_fmt_t fmt,
     int eu_align)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
-  uint32_t lmem_size = ctx->info.lmem_size;
   uint32_t eu_num = ctx->info.eu_num;
 
-  cvk_tl_t *t = malloc(sizeof(*t));
+  cvk_tl_t *t = desc_pool_alloc(&prv_data->tl_ml_pool);
   if (!t)
     return NULL;
 
   memset(t, 0, sizeof(*t));
-  t->start_address = prv_data->lmem_ptr;
   t->fmt = fmt;
   t->cmprs_fmt = fmt;
   t->shape = shape;
@@ -265,15 +468,38 @@ cvk_tl_t *cvkcv181x_lmem_alloc_tensor(
   t->stride = cvkcv181x_tl_default_stride(ctx, shape, fmt, eu_align);
 
   uint32_t needed = align_up(t->shape.n * t->stride.n, eu_num);
-  if ((lmem_size - prv_data->lmem_ptr < needed) || !needed) {
-    free(t);
+  uint32_t addr = lmem_heap_alloc(&prv_data->lmem_heap, bank_id, needed);
+  if (addr == LMEM_HEAP_INVALID) {
+    desc_pool_free(&prv_data->tl_ml_pool, t);
     return NULL;
   }
 
-  prv_data->lmem_ptr += needed;
+  t->start_address = addr;
   return t;
 }
 
+cvk_tl_t *cvkcv181x_lmem_alloc_tensor(
+    cvk_context_t *ctx,
+    cvk_tl_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  return lmem_alloc_tensor(ctx, LMEM_HEAP_ANY_BANK, shape, fmt, eu_align);
+}
+
+cvk_tl_t *cvkcv181x_lmem_alloc_bank_tensor(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_tl_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  if (bank_id >= ctx->info.lmem_banks)
+    return NULL;
+
+  return lmem_alloc_tensor(ctx, bank_id, shape, fmt, eu_align);
+}
+
 void cvkcv181x_lmem_free_tensor(
     struct cvikernel_context *ctx,
     const cvk_tl_t *tl)
@@ -285,12 +511,10 @@ void cvkcv181x_lmem_free_tensor(
 
   prv_data = (cvk_prv_data_t *)ctx->priv_data;
 
-  if (tl->start_address >= prv_data->lmem_ptr)
+  if (lmem_heap_free(&prv_data->lmem_heap, tl->start_address))
     printf("cvkcv181x lm free tensor: ptr out of range\n");
 
-  prv_data->lmem_ptr = tl->start_address;
-
-  free((void *)tl);
+  desc_pool_free(&prv_data->tl_ml_pool, (void *)tl);
 }
 
 static void try_optimize_matrix_shape(cvk_context_t *ctx, cvk_ml_shape_t *s,
@@ -432,24 +656,23 @@ uint32_t cvkcv181x_lmem_ps32_matrix_to_size(
 
 }
 
-cvk_ml_t *cvkcv181x_lmem_alloc_matrix(
+static cvk_ml_t *lmem_alloc_matrix(
     cvk_context_t *ctx,
+    int bank_id,
     cvk_ml_shape_t s,
     cvk_fmt_t fmt,
     int eu_align)
 {
   cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
-  uint32_t lmem_size = ctx->info.lmem_size;
   uint32_t npu_num = ctx->info.npu_num;
   uint32_t eu_num = ctx->info.eu_num;
   uint32_t val = (fmt == CVK_FMT_BF16) ? 2 : 1;
 
-  cvk_ml_t *t = malloc(sizeof(*t));
+  cvk_ml_t *t = desc_pool_alloc(&prv_data->tl_ml_pool);
   if (!t)
     return NULL;
 
   memset(t, 0, sizeof(*t));
-  t->start_address = prv_data->lmem_ptr;
   t->fmt = fmt;
   t->shape = s;
   t->stride.h = s.w * val;
@@ -461,15 +684,38 @@ cvk_ml_t *cvkcv181x_lmem_alloc_matrix(
   t->eu_align = eu_align;
 
   uint32_t needed = align_up(t->shape.n * t->stride.n, eu_num);
-  if (lmem_size - prv_data->lmem_ptr < needed) {
-    free(t);
+  uint32_t addr = lmem_heap_alloc(&prv_data->lmem_heap, bank_id, needed);
+  if (addr == LMEM_HEAP_INVALID) {
+    desc_pool_free(&prv_data->tl_ml_pool, t);
     return NULL;
   }
-  prv_data->lmem_ptr += needed;
 
+  t->start_address = addr;
   return t;
 }
 
+cvk_ml_t *cvkcv181x_lmem_alloc_matrix(
+    cvk_context_t *ctx,
+    cvk_ml_shape_t s,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  return lmem_alloc_matrix(ctx, LMEM_HEAP_ANY_BANK, s, fmt, eu_align);
+}
+
+cvk_ml_t *cvkcv181x_lmem_alloc_bank_matrix(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_ml_shape_t s,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  if (bank_id >= ctx->info.lmem_banks)
+    return NULL;
+
+  return lmem_alloc_matrix(ctx, bank_id, s, fmt, eu_align);
+}
+
 void cvkcv181x_lmem_free_matrix(
     struct cvikernel_context *ctx,
     const cvk_ml_t *ml)
@@ -481,11 +727,137 @@ void cvkcv181x_lmem_free_matrix(
 
   prv_data = (cvk_prv_data_t *)ctx->priv_data;
 
-  if (ml->start_address >= prv_data->lmem_ptr)
+  if (lmem_heap_free(&prv_data->lmem_heap, ml->start_address))
     printf("cvkcv181x lm free matrix: ptr out of range\n");
 
-  prv_data->lmem_ptr = ml->start_address;
-  free((void *)ml);
+  desc_pool_free(&prv_data->tl_ml_pool, (void *)ml);
+}
+
+// CVK_CONV_SINGLE_* reasons of an emitted convolution, from its registers
+// as desc_template_emit replays them too.
+static uint32_t single_conv_reasons(cvk_context_t *ctx, const tiu_reg_t *reg)
+{
+  uint32_t reasons = 0;
+
+  if (reg->double_conv)
+    return 0;
+
+  if ((reg->opd0_addr % ctx->info.lmem_size) % 2)
+    reasons |= CVK_CONV_SINGLE_IFMAP_ADDR;
+  if (reg->opd0_c % 2)
+    reasons |= CVK_CONV_SINGLE_ODD_C;
+  if (reg->opd0_c < 4)
+    reasons |= CVK_CONV_SINGLE_SMALL_C;
+  if (reg->opd1_addr % 2)
+    reasons |= CVK_CONV_SINGLE_WEIGHT_ADDR;
+  if (reg->opd_typ)
+    reasons |= CVK_CONV_SINGLE_BF16;
+
+  return reasons;
+}
+
+void cvkcv181x_conv_report_record(cvk_context_t *ctx, const tiu_reg_t *reg)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  conv_report_t *r = &prv_data->conv_report;
+  cvk_conv_report_t *l = NULL;
+  uint16_t layer_id = reg->layer_info;
+  uint32_t single_reasons = single_conv_reasons(ctx, reg);
+
+  // Convolutions of a layer mostly come in a row.
+  if (r->last < r->nr_layers && r->layers[r->last].layer_id == layer_id) {
+    l = &r->layers[r->last];
+  } else {
+    for (uint32_t i = 0; i < r->nr_layers; i++) {
+      if (r->layers[i].layer_id == layer_id) {
+        l = &r->layers[i];
+        r->last = i;
+        break;
+      }
+    }
+  }
+
+  if (!l) {
+    if (r->nr_layers == r->max_nr_layers) {
+      uint32_t max_nr = r->max_nr_layers ? r->max_nr_layers * 2 : 16;
+      cvk_conv_report_t *layers =
+          realloc(r->layers, max_nr * sizeof(*layers));
+      if (!layers)
+        return;
+
+      r->layers = layers;
+      r->max_nr_layers = max_nr;
+    }
+
+    r->last = r->nr_layers++;
+    l = &r->layers[r->last];
+    memset(l, 0, sizeof(*l));
+    l->layer_id = layer_id;
+  }
+
+  if (!single_reasons) {
+    l->nr_double++;
+    return;
+  }
+
+  l->nr_single++;
+  l->nr_ifmap_addr += !!(single_reasons & CVK_CONV_SINGLE_IFMAP_ADDR);
+  l->nr_weight_addr += !!(single_reasons & CVK_CONV_SINGLE_WEIGHT_ADDR);
+  l->nr_odd_c += !!(single_reasons & CVK_CONV_SINGLE_ODD_C);
+  l->nr_small_c += !!(single_reasons & CVK_CONV_SINGLE_SMALL_C);
+  l->nr_bf16 += !!(single_reasons & CVK_CONV_SINGLE_BF16);
+}
+
+uint32_t cvkcv181x_conv_report(
+    struct cvikernel_context *ctx,
+    cvk_conv_report_t *layers,
+    uint32_t max_layers)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  conv_report_t *r = &prv_data->conv_report;
+
+  uint32_t nr = (r->nr_layers < max_layers) ? r->nr_layers : max_layers;
+  if (layers && nr)
+    memcpy(layers, r->layers, nr * sizeof(layers[0]));
+
+  return r->nr_layers;
+}
+
+void cvkcv181x_conv_report_reset(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  conv_report_t *r = &prv_data->conv_report;
+
+  free(r->layers);
+  memset(r, 0, sizeof(*r));
+}
+
+uint32_t cvkcv181x_lmem_high_water(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  return lmem_heap_high_water(&prv_data->lmem_heap);
+}
+
+void cvkcv181x_lmem_reset_high_water(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  lmem_heap_reset_high_water(&prv_data->lmem_heap);
+}
+
+uint32_t cvkcv181x_lmem_largest_free(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  return lmem_heap_largest_free(&prv_data->lmem_heap);
+}
+
+uint32_t cvkcv181x_nr_dropped_cmds(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  return prv_data->nr_dropped_cmds;
 }
 
 cvk_ml_t *cvkcv181x_lmem_alloc_ps32_matrix(
@@ -734,6 +1106,8 @@ static cvk_operations_t cvk_cv181x_ops = {
   .cleanup = cvkcv181x_cleanup,
   .reset = cvkcv181x_reset,
   .acquire_cmdbuf = cvkcv181x_acquire_cmdbuf,
+  .dmabuf_size = cvkcv181x_dmabuf_size,
+  .dmabuf_convert = cvkcv181x_dmabuf_convert,
   .set_layer_id = cvkcv181x_set_layer_id,
   .parallel_enable = cvkcv181x_parallel_enable,
   .parallel_disable = cvkcv181x_parallel_disable,
@@ -819,6 +1193,35 @@ static cvk_operations_t cvk_cv181x_ops = {
 static cvk_misc_operations_t cvk_cv181x_misc_ops = {
   .float_to_bfloat16 = cvkcv181x_float_to_bfloat16,
   .bf16_table_shape = cvkcv181x_bf16_table_shape,
+  .acquire_cmdbuf_chunks = cvkcv181x_acquire_cmdbuf_chunks,
+  .hazard_tracking_enable = cvkcv181x_hazard_tracking_enable,
+  .hazard_tracking_disable = cvkcv181x_hazard_tracking_disable,
+  .direct_dmabuf_enable = cvkcv181x_direct_dmabuf_enable,
+  .desc_template_capture = cvkcv181x_desc_template_capture,
+  .desc_template_emit = cvkcv181x_desc_template_emit,
+  .lmem_alloc_bank_tensor = cvkcv181x_lmem_alloc_bank_tensor,
+  .lmem_alloc_bank_matrix = cvkcv181x_lmem_alloc_bank_matrix,
+  .lmem_high_water = cvkcv181x_lmem_high_water,
+  .lmem_reset_high_water = cvkcv181x_lmem_reset_high_water,
+  .lmem_largest_free = cvkcv181x_lmem_largest_free,
+  .nr_dropped_cmds = cvkcv181x_nr_dropped_cmds,
+  .lmem_plan = cvk_lmem_plan,
+  .conv_report = cvkcv181x_conv_report,
+  .conv_report_reset = cvkcv181x_conv_report_reset,
+  .conv_tiled = cvk_conv_tiled,
+  .gemm_tiled = cvk_gemm_tiled,
+  .eltwise_tiled = cvk_eltwise_tiled,
+  .pool_tiled = cvk_pool_tiled,
+  .desc_cost = cvkcv181x_desc_cost,
+  .cmdbuf_cost = cvkcv181x_cmdbuf_cost,
+  .cmdbuf_timeline = cvkcv181x_cmdbuf_timeline,
+  .timeline_trace = cvkcv181x_timeline_trace,
+  .stats_enable = cvkcv181x_stats_enable,
+  .stats_disable = cvkcv181x_stats_disable,
+  .stats = cvkcv181x_stats,
+  .stats_reset = cvkcv181x_stats_reset,
+  .pmu_decode = cvkcv181x_pmu_decode,
+  .pmu_layer_report = cvkcv181x_pmu_layer_report,
 };
 
 char *cvikernel_get_chip_info_cv181x(void)
@@ -830,10 +1233,23 @@ void cvikernel_init_cv181x(
     cvk_reg_info_t *req_info,
     cvk_context_t *ctx)
 {
-  uint32_t max_nr_desc = cvkcv181x_estimate_nr_desc(req_info->cmdbuf_size);
+  uint32_t growable = req_info && !req_info->cmdbuf;
+  uint32_t chunk_size = 0;
+  uint32_t max_nr_desc;
   cvk_prv_data_t *prv_data;
   desc_pair_t *desc_pairs;
 
+  if (growable) {
+    // Descriptors and engine conductor grow one chunk worth at a time.
+    uint32_t min_size = sizeof(cmd_hdr_t) + TIU_DESC_REG_BYTES;
+    chunk_size = req_info->cmdbuf_size ? req_info->cmdbuf_size
+                                       : CVK_CMDBUF_CHUNK_SIZE;
+    chunk_size = (chunk_size > min_size) ? chunk_size : min_size;
+    max_nr_desc = cvkcv181x_estimate_nr_desc(chunk_size);
+  } else {
+    max_nr_desc = cvkcv181x_estimate_nr_desc(req_info->cmdbuf_size);
+  }
+
   prv_data = malloc(sizeof(cvk_prv_data_t));
   desc_pairs = malloc(max_nr_desc * sizeof(desc_pair_t));
   if (!req_info || !ctx || !prv_data || !desc_pairs) {
@@ -867,8 +1283,19 @@ void cvikernel_init_cv181x(
   prv_data->cmdbuf_ptr = 0;
   prv_data->max_nr_desc = max_nr_desc;
   prv_data->cur_nr_desc = 0;
+  prv_data->nr_synced_desc = 0;
   prv_data->desc_pairs = desc_pairs;
-  prv_data->lmem_ptr = 0;
+  lmem_heap_init(&prv_data->lmem_heap, ctx->info.lmem_size,
+                 ctx->info.lmem_banks, ctx->info.lmem_bank_size,
+                 ctx->info.eu_num);
+  desc_pool_init(&prv_data->tl_ml_pool,
+                 sizeof(cvk_tl_t) > sizeof(cvk_ml_t) ? sizeof(cvk_tl_t)
+                                                     : sizeof(cvk_ml_t),
+                 64);
+  prv_data->layer_id = 0;
+  memset(&prv_data->conv_report, 0, sizeof(prv_data->conv_report));
+  memset(&prv_data->stats, 0, sizeof(prv_data->stats));
+  prv_data->nr_dropped_cmds = 0;
 
   if (!prv_data->desc_pairs) {
     printf("cvkcv181x init: fail to allocate internal data\n");
@@ -876,10 +1303,22 @@ void cvikernel_init_cv181x(
     return;
   }
 
-  ec_init(&prv_data->ec, CV181X_ENGINE_NUM, max_nr_desc);
+  if (growable)
+    ec_init_growable(&prv_data->ec, CV181X_ENGINE_NUM, max_nr_desc);
+  else
+    ec_init(&prv_data->ec, CV181X_ENGINE_NUM, max_nr_desc);
   mode_manager_init(&prv_data->mode_manager, &prv_data->ec, CV181X_ENGINE_NUM);
 
-  prv_data->cmdbuf = req_info->cmdbuf;
-  prv_data->cmdbuf_size = req_info->cmdbuf_size;
+  prv_data->growable = growable;
+  cmdbuf_chain_init(&prv_data->cmdbuf_chain, chunk_size);
+  prv_data->direct_dmabuf = 0;
+  cvkcv181x_dmabuf_writer_init(&prv_data->dmabuf_writer);
+  if (growable) {
+    prv_data->cmdbuf = NULL;
+    prv_data->cmdbuf_size = 0;
+  } else {
+    prv_data->cmdbuf = req_info->cmdbuf;
+    prv_data->cmdbuf_size = req_info->cmdbuf_size;
+  }
   ctx->priv_data = prv_data;
 }
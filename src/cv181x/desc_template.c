@@ -0,0 +1,146 @@
+#include "cvkcv181x.h"
+#include <string.h>
+
+//
+// Record-and-patch re-emission of tiu/tdma descriptors.
+//
+// Templates hold register words in cmdbuf form. Sync ids are left as
+// captured, they are replaced once the new descriptor's ids are final.
+//
+static uint32_t desc_template_len(uint32_t engine_id)
+{
+  switch (engine_id) {
+    case CV181X_TIU:
+      return TIU_DESC_REG_BYTES;
+    case CV181X_TDMA:
+      return TDMA_DESC_REG_BYTES;
+    default:
+      return 0;
+  }
+}
+
+int cvkcv181x_desc_template_capture(
+    struct cvikernel_context *ctx,
+    cvk_desc_template_t *t)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+
+  if (!prv_data->cur_nr_desc) {
+    printf("cvkcv181x desc template: no descriptor to capture\n");
+    return -1;
+  }
+
+  desc_pair_t *dp = &prv_data->desc_pairs[prv_data->cur_nr_desc - 1];
+  uint32_t engine_id = dp->ec_desc->engine_id;
+  uint32_t len = desc_template_len(engine_id);
+  if (!len)
+    return -1;
+
+  memset(t, 0, sizeof(*t));
+  t->engine_id = engine_id;
+
+  if (dp->cmd_hdr)
+    memcpy(t->regs, dp->cmd_hdr->cmd, len);
+  else
+    cvkcv181x_dmabuf_writer_read(&prv_data->dmabuf_writer, engine_id,
+                                 dp->dmabuf_offset, t->regs);
+
+  return 0;
+}
+
+// Same fields as emit_tiu_reg: p[8] res0_addr[23:0] | opd0_addr[7:0],
+// p[9] opd0_addr[23:8] | opd1_addr, p[10] opd2_addr[15:0]
+static void patch_tiu_desc(uint32_t *p, const cvk_desc_patch_t *patch)
+{
+  uint32_t mask = patch->mask;
+
+  if (mask & CVK_DESC_PATCH_RES0)
+    p[8] = (p[8] & 0xff000000) | (patch->res0_addr & 0xffffff);
+  if (mask & CVK_DESC_PATCH_OPD0) {
+    p[8] = (p[8] & 0x00ffffff) | (patch->opd0_addr << 24);
+    p[9] = (p[9] & 0xffff0000) | ((patch->opd0_addr >> 8) & 0xffff);
+  }
+  if (mask & CVK_DESC_PATCH_OPD1)
+    p[9] = (p[9] & 0x0000ffff) | (patch->opd1_addr << 16);
+  if (mask & CVK_DESC_PATCH_OPD2)
+    p[10] = (p[10] & 0xffff0000) | (patch->opd2_addr & 0xffff);
+}
+
+// Same fields as emit_tdma_reg: p[11] dst low, p[12] src low,
+// p[13] dst high[23:16] | src high[31:24]
+static void patch_tdma_desc(uint32_t *p, const cvk_desc_patch_t *patch)
+{
+  uint32_t mask = patch->mask;
+
+  if (mask & CVK_DESC_PATCH_SRC) {
+    p[12] = (uint32_t)patch->src_address;
+    p[13] = (p[13] & 0x00ffffff) |
+            ((uint32_t)(patch->src_address >> 32) << 24);
+  }
+  if (mask & CVK_DESC_PATCH_DST) {
+    p[11] = (uint32_t)patch->dst_address;
+    p[13] = (p[13] & 0xff00ffff) |
+            (((uint32_t)(patch->dst_address >> 32) & 0xff) << 16);
+  }
+}
+
+// tsk_typ read as parse_tiu_reg does, without parsing the rest.
+static int tiu_desc_is_conv(const uint32_t *p)
+{
+  return ((p[0] >> 5) & ((1u << 4) - 1)) == DCR_TYPE_CONV_FIX8B;
+}
+
+int cvkcv181x_desc_template_emit(
+    struct cvikernel_context *ctx,
+    const cvk_desc_template_t *t,
+    const cvk_desc_patch_t *patch)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  uint32_t len = desc_template_len(t->engine_id);
+
+  if (!len) {
+    printf("cvkcv181x desc template: invalid engine %u\n", t->engine_id);
+    return -1;
+  }
+
+  desc_pair_t *dp = cvkcv181x_get_desc_pair(ctx, t->engine_id);
+  if (!dp) {
+    printf("cvkcv181x desc template: fail to allocate descriptor\n");
+    return -1;
+  }
+
+  uint32_t *p = cvkcv181x_desc_pair_body(ctx, dp);
+  memcpy(p, t->regs, len);
+
+  if (t->engine_id == CV181X_TIU)
+    patch_tiu_desc(p, patch);
+  else
+    patch_tdma_desc(p, patch);
+
+  // Hazard mode needs the operand footprint, stats the shapes and the conv
+  // report the convolutions, only then parse it back.
+  int hazard = (prv_data->mode_manager.mode == BMK_HAZARD_MODE);
+  int conv = (t->engine_id == CV181X_TIU) && tiu_desc_is_conv(p);
+  if (hazard || prv_data->stats.enabled || conv) {
+    if (t->engine_id == CV181X_TIU) {
+      tiu_reg_t reg;
+      parse_tiu_reg(&reg, p);
+      if (hazard)
+        cvkcv181x_record_tiu_hazard(ctx, dp->ec_desc, &reg);
+      if (prv_data->stats.enabled)
+        cvkcv181x_stats_record_tiu(ctx, &reg);
+      if (conv)
+        cvkcv181x_conv_report_record(ctx, &reg);
+    } else {
+      tdma_reg_t reg;
+      parse_tdma_reg(&reg, p);
+      if (hazard)
+        cvkcv181x_record_tdma_hazard(ctx, dp->ec_desc, &reg);
+      if (prv_data->stats.enabled)
+        cvkcv181x_stats_record_tdma(ctx, &reg);
+    }
+  }
+
+  cvkcv181x_desc_pair_emitted(ctx, dp);
+  return 0;
+}
@@ -0,0 +1,643 @@
+#include "cvkcv181x.h"
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Convert the command buffer into the dmabuf layout loaded by the runtime:
+//
+//   dma_hdr_t | cpu sync descs | tiu descs + eod padding | tdma descs
+//
+// Every cpu sync desc starts a segment of tiu/tdma descriptors, a new one
+// is inserted whenever a sync id reaches 0xffff and after the last one.
+//
+#define DMABUF_HDR_MAGIC_M        0xB5B5
+#define DMABUF_HDR_MAGIC_S        0x1810
+
+#define TIU_DESC_ALIGN_SIZE       (1 << 8)
+#define TDMA_DESC_ALIGN_SIZE      (1 << 6)
+#define TIU_EOD_PADDING_BYTES     128
+#define CPU_ENGINE_BYTES          (56 * sizeof(uint32_t))
+#define CPU_OP_SYNC               2
+
+#define PMU_PER_DESC_SIZE         16
+#define PMU_PADDING_SIZE          (1024 * 1024)
+
+typedef struct {
+  uint16_t dmabuf_magic_m;
+  uint16_t dmabuf_magic_s;
+  uint32_t dmabuf_size;
+  uint32_t cpu_desc_count;
+  uint32_t bd_desc_count;
+  uint32_t tdma_desc_count;
+  uint32_t tpu_clk_rate;
+  uint32_t pmubuf_size;
+  uint32_t pmubuf_offset;
+  uint32_t arraybase[16];
+  uint32_t reserve[8];
+} dma_hdr_t;
+
+typedef struct {
+  uint32_t op_type;
+  uint32_t num_tiu;
+  uint32_t num_tdma;
+  uint32_t offset_tiu;
+  uint32_t offset_tdma;
+  uint32_t offset_tiu_ori_bk;
+  uint32_t offset_tdma_ori_bk;
+  char str[CPU_ENGINE_BYTES - 7 * sizeof(uint32_t)];
+} __attribute__((packed)) cpu_sync_desc_t;
+
+typedef struct {
+  uint32_t nr_cpu_desc;
+  uint32_t nr_tiu_desc;
+  uint32_t nr_tdma_desc;
+  uint32_t tiu_size;   // tiu region including eod padding of segments
+} dmabuf_layout_t;
+
+static inline uint32_t dmabuf_align(uint32_t x, uint32_t n)
+{
+  return (x + n - 1) & ~(n - 1);
+}
+
+static inline cmd_hdr_t *next_cmd_hdr(cmd_hdr_t *hdr)
+{
+  uint32_t len = hdr->len ? hdr->len : hdr->mask;
+  return (cmd_hdr_t *)(hdr->cmd + len);
+}
+
+// Own sync id, read without parsing the whole register.
+static inline uint32_t cmd_sync_id(cmd_hdr_t *hdr)
+{
+  const uint32_t *p = (const uint32_t *)hdr->cmd;
+
+  if (hdr->engine_id == CV181X_TIU)
+    return p[1] & 0xffff;
+
+  return p[0] >> 16;
+}
+
+static uint32_t tiu_segment_size(uint32_t nr_tiu)
+{
+  if (!nr_tiu)
+    return 0;
+
+  return dmabuf_align(nr_tiu * TIU_DESC_REG_BYTES + TIU_EOD_PADDING_BYTES,
+                      TIU_DESC_ALIGN_SIZE);
+}
+
+static uint32_t tiu_region_offset(const dmabuf_layout_t *l)
+{
+  return dmabuf_align(sizeof(dma_hdr_t) + l->nr_cpu_desc * CPU_ENGINE_BYTES,
+                      TIU_DESC_ALIGN_SIZE);
+}
+
+static uint32_t tdma_region_offset(const dmabuf_layout_t *l)
+{
+  return dmabuf_align(tiu_region_offset(l) + l->tiu_size, TDMA_DESC_ALIGN_SIZE);
+}
+
+//
+// Split the command buffer into segments.
+// With segments != NULL, the cpu sync descs are written as well, with
+// their tiu/tdma counts only.
+// Returns 0, -1 on a malformed cmdbuf.
+//
+static int scan_cmdbuf(
+    uint8_t *cmdbuf,
+    uint32_t sz,
+    dmabuf_layout_t *l,
+    cpu_sync_desc_t *segments)
+{
+  uint32_t nr_tiu = 0, nr_tdma = 0;
+  uint8_t *end = cmdbuf + sz;
+
+  memset(l, 0, sizeof(*l));
+
+  for (cmd_hdr_t *hdr = (cmd_hdr_t *)cmdbuf; (uint8_t *)hdr < end;) {
+    if ((uint8_t *)hdr + sizeof(*hdr) > end ||
+        hdr->magic != CMDBUF_HDR_MAGIC_181X) {
+      printf("cvkcv181x dmabuf: wrong cmdbuf magic at %u\n",
+             (uint32_t)((uint8_t *)hdr - cmdbuf));
+      return -1;
+    }
+
+    cmd_hdr_t *next = next_cmd_hdr(hdr);
+    int new_segment = 0;
+
+    if ((uint8_t *)next > end) {
+      printf("cvkcv181x dmabuf: truncated cmdbuf at %u\n",
+             (uint32_t)((uint8_t *)hdr - cmdbuf));
+      return -1;
+    }
+
+    cpu_sync_desc_t *seg = segments ? &segments[l->nr_cpu_desc] : NULL;
+
+    if (hdr->engine_id == CV181X_CPU) {
+      if (seg)
+        memcpy(seg, hdr->cmd, sizeof(*seg));
+      new_segment = 1;
+    } else {
+      if (hdr->engine_id == CV181X_TIU)
+        nr_tiu++;
+      else
+        nr_tdma++;
+
+      if (cmd_sync_id(hdr) == 0xffff || (uint8_t *)next >= end) {
+        if (seg) {
+          memset(seg, 0, sizeof(*seg));
+          seg->op_type = CPU_OP_SYNC;
+          strncpy(seg->str, "layer_end", sizeof(seg->str) - 1);
+        }
+        new_segment = 1;
+      }
+    }
+
+    if (new_segment) {
+      if (seg) {
+        seg->num_tiu = nr_tiu;
+        seg->num_tdma = nr_tdma;
+      }
+      l->nr_cpu_desc++;
+      l->nr_tiu_desc += nr_tiu;
+      l->nr_tdma_desc += nr_tdma;
+      l->tiu_size += tiu_segment_size(nr_tiu);
+      nr_tiu = 0;
+      nr_tdma = 0;
+    }
+
+    hdr = next;
+  }
+
+  return 0;
+}
+
+// Swap the first and last 128-bit words, tag each word with its index.
+static void reorder_tiu_reg(uint8_t *desc)
+{
+  const int nr_words = TIU_DESC_REG_BYTES / 16;
+
+  for (int i = 0; i < nr_words; i++)
+    desc[i * 16 + 15] |= i << 4;
+
+  uint8_t tmp[16];
+  uint8_t *last = &desc[(nr_words - 1) * 16];
+  memcpy(tmp, last, sizeof(tmp));
+  memcpy(last, desc, sizeof(tmp));
+  memcpy(desc, tmp, sizeof(tmp));
+}
+
+// tiu: p[0] bit 1 cmd_end, bit 4 cmd_intr_en
+static void adjust_tiu_desc(uint32_t *p, int eod)
+{
+  if (eod)
+    p[0] |= (1u << 1) | (1u << 4);
+
+  reorder_tiu_reg((uint8_t *)p);
+}
+
+// tdma: p[0] bit 2 eod, bit 3 intp_en, bit 4 bar_en
+static void adjust_tdma_desc(uint32_t *p, int eod)
+{
+  if (eod)
+    p[0] |= (1u << 2) | (1u << 3);
+
+  p[0] |= 1u << 4;
+}
+
+void cvkcv181x_dmabuf_size(
+    uint8_t *cmdbuf,
+    uint32_t sz,
+    uint32_t *psize,
+    uint32_t *pmu_size)
+{
+  dmabuf_layout_t l;
+
+  if (scan_cmdbuf(cmdbuf, sz, &l, NULL)) {
+    *psize = 0;
+    *pmu_size = 0;
+    return;
+  }
+
+  *psize = tdma_region_offset(&l) + l.nr_tdma_desc * TDMA_DESC_ALIGN_SIZE;
+  *pmu_size = dmabuf_align(
+      (l.nr_tiu_desc + l.nr_tdma_desc) * PMU_PER_DESC_SIZE + PMU_PADDING_SIZE,
+      0x1000);
+}
+
+void cvkcv181x_dmabuf_convert(uint8_t *cmdbuf, uint32_t sz, uint8_t *dmabuf)
+{
+  dma_hdr_t *hdr = (dma_hdr_t *)dmabuf;
+  cpu_sync_desc_t *segments = (cpu_sync_desc_t *)(dmabuf + sizeof(dma_hdr_t));
+  dmabuf_layout_t l;
+
+  // Cpu sync descs are in front of everything else, only their number
+  // decides where the tiu/tdma regions go. A malformed cmdbuf stops the
+  // scan, the header is left unwritten then.
+  if (scan_cmdbuf(cmdbuf, sz, &l, segments))
+    return;
+
+  uint32_t tiu_offset = tiu_region_offset(&l);
+  uint32_t tdma_offset = tdma_region_offset(&l);
+
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->dmabuf_magic_m = DMABUF_HDR_MAGIC_M;
+  hdr->dmabuf_magic_s = DMABUF_HDR_MAGIC_S;
+  hdr->dmabuf_size = tdma_offset + l.nr_tdma_desc * TDMA_DESC_ALIGN_SIZE;
+  hdr->cpu_desc_count = l.nr_cpu_desc;
+  hdr->bd_desc_count = l.nr_tiu_desc;
+  hdr->tdma_desc_count = l.nr_tdma_desc;
+
+  cmd_hdr_t *cmd = (cmd_hdr_t *)cmdbuf;
+  for (uint32_t i = 0; i < l.nr_cpu_desc; i++) {
+    cpu_sync_desc_t *seg = &segments[i];
+    uint32_t nr_tiu = seg->num_tiu;
+    uint32_t nr_tdma = seg->num_tdma;
+
+    if (nr_tiu)
+      seg->offset_tiu = tiu_offset;
+    if (nr_tdma)
+      seg->offset_tdma = tdma_offset;
+
+    while (nr_tiu || nr_tdma) {
+      uint8_t *dst;
+
+      switch (cmd->engine_id) {
+        case CV181X_TIU:
+          dst = dmabuf + tiu_offset;
+          tiu_offset += TIU_DESC_REG_BYTES;
+          memcpy(dst, cmd->cmd, TIU_DESC_REG_BYTES);
+          adjust_tiu_desc((uint32_t *)dst, --nr_tiu == 0);
+          break;
+        case CV181X_TDMA:
+          dst = dmabuf + tdma_offset;
+          tdma_offset += TDMA_DESC_ALIGN_SIZE;
+          memcpy(dst, cmd->cmd, TDMA_DESC_REG_BYTES);
+          adjust_tdma_desc((uint32_t *)dst, --nr_tdma == 0);
+          break;
+        default:
+          break;
+      }
+      cmd = next_cmd_hdr(cmd);
+    }
+
+    // Cpu descriptor closing this segment.
+    if ((uint8_t *)cmd < cmdbuf + sz && cmd->engine_id == CV181X_CPU)
+      cmd = next_cmd_hdr(cmd);
+
+    // Zero padding after eod to work around hardware bug.
+    if (seg->num_tiu) {
+      uint32_t seg_end =
+          seg->offset_tiu + tiu_segment_size(seg->num_tiu);
+      memset(dmabuf + tiu_offset, 0, seg_end - tiu_offset);
+      tiu_offset = seg_end;
+    }
+  }
+}
+
+//
+// Direct dmabuf emission, same output as dmabuf_convert of the cmdbuf.
+//
+#define TIU_EOD_BITS              ((1u << 1) | (1u << 4))
+#define TDMA_EOD_BITS             ((1u << 2) | (1u << 3))
+
+static int writer_reserve(uint8_t **buf, uint32_t *buf_size, uint32_t size)
+{
+  if (size <= *buf_size)
+    return 0;
+
+  uint32_t new_size = *buf_size ? *buf_size : (64 << 10);
+  while (new_size < size)
+    new_size *= 2;
+
+  uint8_t *new_buf = realloc(*buf, new_size);
+  if (!new_buf) {
+    printf("cvkcv181x dmabuf: fail to allocate %u bytes\n", new_size);
+    return -1;
+  }
+
+  *buf = new_buf;
+  *buf_size = new_size;
+  return 0;
+}
+
+void cvkcv181x_dmabuf_writer_init(dmabuf_writer_t *w)
+{
+  memset(w, 0, sizeof(*w));
+  w->tiu_base = dmabuf_align(sizeof(dma_hdr_t), TIU_DESC_ALIGN_SIZE);
+}
+
+void cvkcv181x_dmabuf_writer_reset(dmabuf_writer_t *w)
+{
+  w->tiu_used = 0;
+  w->tdma_used = 0;
+  w->nr_segments = 0;
+  memset(&w->cur, 0, sizeof(w->cur));
+  w->close_pending = 0;
+  w->eod_marked = 0;
+}
+
+void cvkcv181x_dmabuf_writer_destroy(dmabuf_writer_t *w)
+{
+  free(w->buf);
+  free(w->tdma_buf);
+  free(w->segments);
+  cvkcv181x_dmabuf_writer_init(w);
+}
+
+uint32_t *cvkcv181x_dmabuf_writer_body(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset)
+{
+  if (eng_id == CV181X_TIU)
+    return (uint32_t *)(w->buf + w->tiu_base + offset);
+
+  return (uint32_t *)(w->tdma_buf + offset);
+}
+
+// Register words as in the cmdbuf, tiu words 0-3 are in the last 128-bit
+// word after reorder_tiu_reg.
+uint32_t *cvkcv181x_dmabuf_writer_reg(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset)
+{
+  uint32_t *p = cvkcv181x_dmabuf_writer_body(w, eng_id, offset);
+
+  if (eng_id == CV181X_TIU)
+    return p + (TIU_DESC_REG_BYTES - 16) / sizeof(uint32_t);
+
+  return p;
+}
+
+void cvkcv181x_dmabuf_writer_emitted(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset)
+{
+  uint32_t *p = cvkcv181x_dmabuf_writer_body(w, eng_id, offset);
+
+  if (eng_id == CV181X_TIU)
+    adjust_tiu_desc(p, 0);
+  else
+    adjust_tdma_desc(p, 0);
+}
+
+// Register words in cmdbuf form, without the reorder and eod.
+static void read_desc_regs(const void *p, uint32_t eng_id, uint32_t *regs)
+{
+  if (eng_id == CV181X_TIU) {
+    const int nr_words = TIU_DESC_REG_BYTES / 16;
+    uint8_t *desc = (uint8_t *)regs;
+
+    memcpy(regs, p, TIU_DESC_REG_BYTES);
+    reorder_tiu_reg(desc);
+    for (int i = 0; i < nr_words; i++)
+      desc[i * 16 + 15] &= 0x0f;  // reserved bits, tagged by reorder
+    regs[0] &= ~TIU_EOD_BITS;
+  } else {
+    memcpy(regs, p, TDMA_DESC_REG_BYTES);
+    regs[0] &= ~TDMA_EOD_BITS;
+  }
+}
+
+void cvkcv181x_dmabuf_writer_read(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t offset,
+    uint32_t *regs)
+{
+  read_desc_regs(cvkcv181x_dmabuf_writer_body(w, eng_id, offset), eng_id,
+                 regs);
+}
+
+static void mark_eod(dmabuf_writer_t *w)
+{
+  if (w->cur.num_tiu)
+    *cvkcv181x_dmabuf_writer_reg(w, CV181X_TIU, w->last_tiu) |= TIU_EOD_BITS;
+  if (w->cur.num_tdma)
+    *cvkcv181x_dmabuf_writer_reg(w, CV181X_TDMA, w->last_tdma) |= TDMA_EOD_BITS;
+}
+
+// Undo the eod marked by cvkcv181x_dmabuf_writer_finish.
+static void unmark_eod(dmabuf_writer_t *w)
+{
+  uint32_t *p;
+
+  if (w->cur.num_tiu) {
+    p = cvkcv181x_dmabuf_writer_reg(w, CV181X_TIU, w->last_tiu);
+    *p = (*p & ~TIU_EOD_BITS) | w->eod_saved_tiu;
+  }
+  if (w->cur.num_tdma) {
+    p = cvkcv181x_dmabuf_writer_reg(w, CV181X_TDMA, w->last_tdma);
+    *p = (*p & ~TDMA_EOD_BITS) | w->eod_saved_tdma;
+  }
+
+  w->eod_marked = 0;
+}
+
+static int close_segment(dmabuf_writer_t *w)
+{
+  w->close_pending = 0;
+
+  if (!w->cur.num_tiu && !w->cur.num_tdma)
+    return 0;
+
+  if (w->nr_segments == w->max_nr_segments) {
+    uint32_t max_nr = w->max_nr_segments ? w->max_nr_segments * 2 : 16;
+    dmabuf_segment_t *segments =
+        realloc(w->segments, max_nr * sizeof(dmabuf_segment_t));
+    if (!segments) {
+      printf("cvkcv181x dmabuf: fail to allocate %u segments\n", max_nr);
+      return -1;
+    }
+    w->segments = segments;
+    w->max_nr_segments = max_nr;
+  }
+
+  mark_eod(w);
+
+  // Zero padding after eod, room is reserved by cvkcv181x_dmabuf_writer_alloc.
+  uint32_t seg_end = w->cur.tiu_offset + tiu_segment_size(w->cur.num_tiu);
+  memset(w->buf + w->tiu_base + w->tiu_used, 0, seg_end - w->tiu_used);
+  w->tiu_used = seg_end;
+
+  w->segments[w->nr_segments++] = w->cur;
+  w->cur.num_tiu = 0;
+  w->cur.num_tdma = 0;
+  w->cur.tiu_offset = w->tiu_used;
+  w->cur.tdma_offset = w->tdma_used;
+  return 0;
+}
+
+int cvkcv181x_dmabuf_writer_alloc(
+    dmabuf_writer_t *w,
+    uint32_t eng_id,
+    uint32_t *offset)
+{
+  if (eng_id != CV181X_TIU && eng_id != CV181X_TDMA)
+    return -1;
+
+  if (w->eod_marked && !w->close_pending)
+    unmark_eod(w);
+  w->eod_marked = 0;
+
+  if (w->close_pending && close_segment(w))
+    return -1;
+
+  if (eng_id == CV181X_TIU) {
+    uint32_t seg_end =
+        w->cur.tiu_offset + tiu_segment_size(w->cur.num_tiu + 1);
+    if (writer_reserve(&w->buf, &w->buf_size, w->tiu_base + seg_end))
+      return -1;
+
+    *offset = w->tiu_used;
+    w->tiu_used += TIU_DESC_REG_BYTES;
+    w->last_tiu = *offset;
+    w->cur.num_tiu++;
+  } else {
+    uint32_t end = w->tdma_used + TDMA_DESC_ALIGN_SIZE;
+    if (writer_reserve(&w->tdma_buf, &w->tdma_buf_size, end))
+      return -1;
+
+    *offset = w->tdma_used;
+    w->tdma_used = end;
+    w->last_tdma = *offset;
+    w->cur.num_tdma++;
+
+    // Tail of the slot is not covered by the register.
+    memset(w->tdma_buf + *offset + TDMA_DESC_REG_BYTES, 0,
+           TDMA_DESC_ALIGN_SIZE - TDMA_DESC_REG_BYTES);
+  }
+
+  return 0;
+}
+
+//
+// Lay out the final dmabuf in buf and return it.
+// The open segment is ended with eod, more descriptors may still follow.
+//
+uint8_t *cvkcv181x_dmabuf_writer_finish(dmabuf_writer_t *w, uint32_t *size)
+{
+  dmabuf_segment_t *open = (w->cur.num_tiu || w->cur.num_tdma) ? &w->cur : NULL;
+  uint32_t nr_segments = w->nr_segments + (open ? 1 : 0);
+  uint32_t nr_tiu = 0, nr_tdma = 0;
+
+  *size = 0;
+
+  if (open && !w->eod_marked) {
+    if (w->cur.num_tiu)
+      w->eod_saved_tiu =
+          *cvkcv181x_dmabuf_writer_reg(w, CV181X_TIU, w->last_tiu) &
+          TIU_EOD_BITS;
+    if (w->cur.num_tdma)
+      w->eod_saved_tdma =
+          *cvkcv181x_dmabuf_writer_reg(w, CV181X_TDMA, w->last_tdma) &
+          TDMA_EOD_BITS;
+    mark_eod(w);
+    w->eod_marked = 1;
+  }
+
+  dmabuf_layout_t l;
+  l.nr_cpu_desc = nr_segments;
+  l.tiu_size = w->cur.tiu_offset + tiu_segment_size(w->cur.num_tiu);
+
+  uint32_t tiu_offset = tiu_region_offset(&l);
+  uint32_t tdma_offset = tdma_region_offset(&l);
+  uint32_t total = tdma_offset + w->tdma_used;
+  uint32_t old_end = w->tiu_base + w->tiu_used;
+
+  if (writer_reserve(&w->buf, &w->buf_size,
+                     (total > old_end) ? total : old_end))
+    return NULL;
+
+  // Cpu sync descs decide where the tiu region goes.
+  if (tiu_offset != w->tiu_base) {
+    memmove(w->buf + tiu_offset, w->buf + w->tiu_base, w->tiu_used);
+    w->tiu_base = tiu_offset;
+  }
+
+  memset(w->buf + w->tiu_base + w->tiu_used, 0, l.tiu_size - w->tiu_used);
+  memcpy(w->buf + tdma_offset, w->tdma_buf, w->tdma_used);
+
+  cpu_sync_desc_t *cpu_descs = (cpu_sync_desc_t *)(w->buf + sizeof(dma_hdr_t));
+  memset(cpu_descs, 0, tiu_offset - sizeof(dma_hdr_t));
+
+  for (uint32_t i = 0; i < nr_segments; i++) {
+    dmabuf_segment_t *s = (i < w->nr_segments) ? &w->segments[i] : open;
+    cpu_sync_desc_t *desc = &cpu_descs[i];
+
+    desc->op_type = CPU_OP_SYNC;
+    desc->num_tiu = s->num_tiu;
+    desc->num_tdma = s->num_tdma;
+    if (s->num_tiu)
+      desc->offset_tiu = tiu_offset + s->tiu_offset;
+    if (s->num_tdma)
+      desc->offset_tdma = tdma_offset + s->tdma_offset;
+    strncpy(desc->str, "layer_end", sizeof(desc->str) - 1);
+
+    nr_tiu += s->num_tiu;
+    nr_tdma += s->num_tdma;
+  }
+
+  dma_hdr_t *hdr = (dma_hdr_t *)w->buf;
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->dmabuf_magic_m = DMABUF_HDR_MAGIC_M;
+  hdr->dmabuf_magic_s = DMABUF_HDR_MAGIC_S;
+  hdr->dmabuf_size = total;
+  hdr->cpu_desc_count = nr_segments;
+  hdr->bd_desc_count = nr_tiu;
+  hdr->tdma_desc_count = nr_tdma;
+
+  *size = total;
+  return w->buf;
+}
+
+int cvkcv181x_dmabuf_walk(
+    const uint8_t *dmabuf,
+    uint32_t size,
+    dmabuf_walk_fn fn,
+    void *arg)
+{
+  const dma_hdr_t *hdr = (const dma_hdr_t *)dmabuf;
+
+  if (size < sizeof(*hdr) || hdr->dmabuf_magic_m != DMABUF_HDR_MAGIC_M ||
+      (uint64_t)hdr->cpu_desc_count * sizeof(cpu_sync_desc_t) >
+          size - sizeof(*hdr)) {
+    printf("cvkcv181x dmabuf: wrong dmabuf header\n");
+    return -1;
+  }
+
+  const cpu_sync_desc_t *segments =
+      (const cpu_sync_desc_t *)(dmabuf + sizeof(*hdr));
+  uint32_t regs[TIU_DESC_REG_BYTES / sizeof(uint32_t)];
+  int nr = 0;
+
+  for (uint32_t i = 0; i < hdr->cpu_desc_count; i++) {
+    const cpu_sync_desc_t *seg = &segments[i];
+
+    if ((uint64_t)seg->offset_tiu + (uint64_t)seg->num_tiu *
+            TIU_DESC_REG_BYTES > size ||
+        (uint64_t)seg->offset_tdma + (uint64_t)seg->num_tdma *
+            TDMA_DESC_ALIGN_SIZE > size) {
+      printf("cvkcv181x dmabuf: segment %u out of range\n", i);
+      return -1;
+    }
+
+    for (uint32_t j = 0; j < seg->num_tiu; j++) {
+      const uint8_t *p = dmabuf + seg->offset_tiu + j * TIU_DESC_REG_BYTES;
+      read_desc_regs(p, CV181X_TIU, regs);
+      fn(arg, i, CV181X_TIU, regs);
+      nr++;
+    }
+
+    for (uint32_t j = 0; j < seg->num_tdma; j++) {
+      const uint8_t *p = dmabuf + seg->offset_tdma + j * TDMA_DESC_ALIGN_SIZE;
+      read_desc_regs(p, CV181X_TDMA, regs);
+      fn(arg, i, CV181X_TDMA, regs);
+      nr++;
+    }
+  }
+
+  return nr;
+}
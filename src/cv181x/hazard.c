@@ -0,0 +1,227 @@
+#include "cvkcv181x.h"
+
+//
+// LMEM ranges read and written by TIU/TDMA descriptors, for hazard mode.
+//
+// Ranges are offsets within one NPU, which NPUs are touched is ignored.
+// Whenever the exact footprint is not known the range is widened, a wider
+// range only costs some overlap, a narrower one would be a race.
+//
+// Only LMEM is tracked: TIU never accesses GMEM and TDMA commands are
+// executed in order, so GMEM accesses never need a cross-engine wait.
+//
+#define MAX_NR_RANGES 8
+
+typedef struct {
+  uint32_t nr;
+  mem_range_t r[MAX_NR_RANGES];
+} range_list_t;
+
+static void add_range(
+    cvk_context_t *ctx,
+    range_list_t *l,
+    uint64_t start,
+    uint64_t size,
+    uint32_t is_write)
+{
+  uint32_t lmem_size = ctx->info.lmem_size;
+
+  if (!size || l->nr == MAX_NR_RANGES)
+    return;
+
+  mem_range_t *r = &l->r[l->nr++];
+  r->mem = MEM_RANGE_LMEM;
+  r->is_write = is_write;
+  r->start = start;
+  r->end = (start + size < lmem_size) ? start + size : lmem_size;
+}
+
+static void add_whole_lmem(cvk_context_t *ctx, range_list_t *l, uint32_t is_write)
+{
+  add_range(ctx, l, 0, ctx->info.lmem_size, is_write);
+}
+
+typedef struct {
+  uint32_t addr;
+  uint32_t addr_bits;   // valid address bits in the register field
+  uint32_t n, c, h, w;
+  uint32_t n_str, c_str, h_str, w_str;
+  int default_stride;   // strides derived by hardware from shape
+  uint32_t esize;
+} lmem_opd_t;
+
+// Bytes spanned within one NPU by an operand, from its first byte.
+static uint64_t lmem_opd_span(cvk_context_t *ctx, const lmem_opd_t *o)
+{
+  uint32_t npu_num = ctx->info.npu_num;
+  uint32_t lmem_size = ctx->info.lmem_size;
+
+  if (!o->n || !o->c || !o->h || !o->w)
+    return 0;
+
+  // Start NPU is unknown if the field cannot hold the NPU index bits.
+  uint32_t npu = npu_num - 1;
+  if (o->addr_bits >= ctx->info.lmem_shift + ctx->info.npu_shift)
+    npu = (o->addr / lmem_size) % npu_num;
+
+  uint64_t cpl = ceiling_func(npu + o->c, npu_num);
+
+  if (o->default_stride) {
+    // Eu-aligned stride bounds the compact one as well.
+    uint64_t c_str = align_up((uint64_t)o->h * o->w * o->esize, ctx->info.eu_num);
+    return o->n * cpl * c_str;
+  }
+
+  return (uint64_t)(o->n - 1) * o->n_str + (cpl - 1) * o->c_str +
+         (uint64_t)(o->h - 1) * o->h_str + (uint64_t)(o->w - 1) * o->w_str +
+         o->esize;
+}
+
+static void add_tiu_opd(
+    cvk_context_t *ctx,
+    range_list_t *l,
+    const lmem_opd_t *o,
+    uint32_t short_str,
+    uint32_t seg,
+    uint32_t b_str,
+    uint32_t ps32,
+    uint32_t is_write)
+{
+  uint64_t start = o->addr % ctx->info.lmem_size;
+  uint64_t span = lmem_opd_span(ctx, o);
+
+  if (ps32) {
+    // Partial sums are kept in up to four planes b_str apart.
+    add_range(ctx, l, start, 3 * (uint64_t)b_str + span, is_write);
+  } else if (!seg) {
+    // 16-bit operand split into low and high planes, the high plane is
+    // n * n_str above when the stride is derived by hardware.
+    if (short_str == 0 || short_str == 1) {
+      add_range(ctx, l, start, 2 * span, is_write);
+    } else {
+      add_range(ctx, l, start, span, is_write);
+      add_range(ctx, l, (start + b_str) & 0xffff, span, is_write);
+    }
+  } else {
+    add_range(ctx, l, start, span, is_write);
+  }
+}
+
+void cvkcv181x_record_tiu_hazard(
+    cvk_context_t *ctx,
+    ec_desc_t *d,
+    const tiu_reg_t *r)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  if (prv_data->mode_manager.mode != BMK_HAZARD_MODE)
+    return;
+
+  range_list_t l;
+  l.nr = 0;
+
+  uint32_t esize = r->opd_typ ? 2 : 1;
+
+  lmem_opd_t res0 = {
+    r->res0_addr, 24, r->res0_n, r->res0_c, r->res0_h, r->res0_w,
+    r->res0_n_str, r->res0_c_str, r->res0_h_str, r->res0_w_str,
+    r->short_res0_str != 3, esize
+  };
+  lmem_opd_t opd0 = {
+    r->opd0_addr, 24, r->opd0_n, r->opd0_c, r->opd0_h, r->opd0_w,
+    r->opd0_n_str, r->opd0_c_str, r->opd0_h_str, r->opd0_w_str,
+    r->short_opd0_str != 3, esize
+  };
+  lmem_opd_t opd1 = {
+    r->opd1_addr, 16, r->opd1_n, r->opd1_c, r->opd1_h, r->opd1_w,
+    r->opd1_n_str, r->opd1_c_str, r->opd1_h_str, r->opd1_w_str,
+    r->short_opd1_str != 3, esize
+  };
+  lmem_opd_t opd2 = {
+    r->opd2_addr, 16, r->opd2_n, r->opd2_c, r->opd2_h, r->opd2_w,
+    r->opd2_n_str, r->opd2_c_str, r->opd2_h_str, r->opd2_w_str,
+    r->short_opd2_str != 3, esize
+  };
+
+  // Result may also be read back (mac, ps32, res_add), a write covers it.
+  add_tiu_opd(ctx, &l, &res0, r->short_res0_str, r->opt_res0_seg,
+              r->res0_b_str, r->ps32_md, 1);
+
+  add_tiu_opd(ctx, &l, &opd0, r->short_opd0_str, r->opt_opd0_seg,
+              r->opd0_b_str, 0, 0);
+
+  if (r->tsk_opd_num >= 2 && !r->opt_opd1_const)
+    add_tiu_opd(ctx, &l, &opd1, r->short_opd1_str, r->opt_opd1_seg,
+                r->opd1_b_str, 0, 0);
+
+  if ((r->tsk_opd_num >= 3 || r->opt_chl_quan) && !r->opt_opd2_const) {
+    if (r->opt_chl_quan) {
+      // Per-channel bias, multiplier and shift, up to 9 bytes per channel.
+      opd2.n = 1;
+      opd2.h = 1;
+      opd2.w = 9;
+      opd2.esize = 1;
+      opd2.default_stride = 1;
+    }
+    add_tiu_opd(ctx, &l, &opd2, r->short_opd2_str, r->opt_opd2_seg,
+                r->opd2_b_str, 0, 0);
+  }
+
+  mode_manager_record_mem_ranges(&prv_data->mode_manager, d, l.r, l.nr);
+}
+
+void cvkcv181x_record_tdma_hazard(
+    cvk_context_t *ctx,
+    ec_desc_t *d,
+    const tdma_reg_t *r)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  if (prv_data->mode_manager.mode != BMK_HAZARD_MODE)
+    return;
+
+  range_list_t l;
+  l.nr = 0;
+
+  uint32_t lmem_size = ctx->info.lmem_size;
+  int src_lmem = (r->trans_dir == 1 || r->trans_dir == 3);
+  int dst_lmem = (r->trans_dir == 0 || r->trans_dir == 3);
+
+  if (r->trans_fmt) {
+    // General copy, a linear byte stream over NPUs.
+    if (src_lmem)
+      add_whole_lmem(ctx, &l, 0);
+    if (dst_lmem)
+      add_whole_lmem(ctx, &l, 1);
+  } else {
+    if (src_lmem) {
+      lmem_opd_t src = {
+        r->src_base_addr_low, 32, r->src_n, r->src_c, r->src_h, r->src_w,
+        r->src_n_stride,
+        r->src_c_stride_low | (r->src_c_stride_high << 16),
+        r->src_h_stride, r->src_fmt == 2 ? 2 : 1,
+        0, r->src_fmt == 2 ? 2 : 1
+      };
+      add_range(ctx, &l, src.addr % lmem_size, lmem_opd_span(ctx, &src), 0);
+    }
+
+    if (dst_lmem) {
+      // Destination has no n, it is src_n unless the copy transposes.
+      uint32_t n = r->src_n;
+      if (r->spec_func == 1) {
+        n = (r->src_c > n) ? r->src_c : n;
+        n = (r->src_h > n) ? r->src_h : n;
+        n = (r->src_w > n) ? r->src_w : n;
+      }
+
+      lmem_opd_t dst = {
+        r->dst_base_addr_low, 32, n, r->dst_c, r->dst_h, r->dst_w,
+        r->dst_n_stride,
+        r->dst_c_stride_low | (r->dst_c_stride_high << 16),
+        r->dst_h_stride, r->dst_fmt == 2 ? 2 : 1,
+        0, r->dst_fmt == 2 ? 2 : 1
+      };
+      add_range(ctx, &l, dst.addr % lmem_size, lmem_opd_span(ctx, &dst), 1);
+    }
+  }
+
+  mode_manager_record_mem_ranges(&prv_data->mode_manager, d, l.r, l.nr);
+}
@@ -0,0 +1,115 @@
+#include "cvkcv181x.h"
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Opt-in counters of the emitted commands, see stats_enable.
+//
+static cvk_layer_stats_t *stats_layer(stats_t *st, uint16_t layer_id)
+{
+  // Descriptors of a layer mostly come in a row.
+  if (st->last < st->nr_layers && st->layers[st->last].layer_id == layer_id)
+    return &st->layers[st->last];
+
+  for (uint32_t i = 0; i < st->nr_layers; i++) {
+    if (st->layers[i].layer_id == layer_id) {
+      st->last = i;
+      return &st->layers[i];
+    }
+  }
+
+  if (st->nr_layers == st->max_nr_layers) {
+    uint32_t max_nr = st->max_nr_layers ? st->max_nr_layers * 2 : 16;
+    cvk_layer_stats_t *layers = realloc(st->layers, max_nr * sizeof(*layers));
+    if (!layers)
+      return NULL;
+
+    st->layers = layers;
+    st->max_nr_layers = max_nr;
+  }
+
+  st->last = st->nr_layers++;
+  cvk_layer_stats_t *l = &st->layers[st->last];
+  memset(l, 0, sizeof(*l));
+  l->layer_id = layer_id;
+  return l;
+}
+
+void cvkcv181x_stats_record_tiu(cvk_context_t *ctx, const tiu_reg_t *r)
+{
+  stats_t *st = &((cvk_prv_data_t *)ctx->priv_data)->stats;
+  cvk_desc_cost_t cost;
+
+  st->s.nr_tiu++;
+
+  cvkcv181x_tiu_cost(r, &cost);
+  if (r->tsk_typ < CVK_TIU_NR_TYPES)
+    st->s.tiu_macs[r->tsk_typ] += cost.macs;
+
+  cvk_layer_stats_t *l = stats_layer(st, r->layer_info);
+  if (l)
+    l->nr_tiu++;
+}
+
+void cvkcv181x_stats_record_tdma(cvk_context_t *ctx, const tdma_reg_t *r)
+{
+  stats_t *st = &((cvk_prv_data_t *)ctx->priv_data)->stats;
+  cvk_desc_cost_t cost;
+
+  st->s.nr_tdma++;
+
+  // trans_dir is CVK_TDMA_G2L, L2G, G2G or L2L.
+  cvkcv181x_tdma_cost(r, &cost);
+  st->s.tdma_bytes[r->trans_dir] += cost.bytes;
+  if (r->compress_en)
+    st->s.tdma_cmpr_bytes[r->trans_dir] += cost.bytes;
+
+  cvk_layer_stats_t *l = stats_layer(st, r->layer_ID);
+  if (l)
+    l->nr_tdma++;
+}
+
+void cvkcv181x_stats_enable(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  prv_data->stats.enabled = 1;
+}
+
+void cvkcv181x_stats_disable(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  prv_data->stats.enabled = 0;
+}
+
+uint32_t cvkcv181x_stats(
+    struct cvikernel_context *ctx,
+    cvk_stats_t *stats,
+    cvk_layer_stats_t *layers,
+    uint32_t max_layers)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  stats_t *st = &prv_data->stats;
+
+  if (stats) {
+    *stats = st->s;
+    stats->lmem_high_water = lmem_heap_high_water(&prv_data->lmem_heap);
+    stats->nr_removed_waits = ec_get_nr_removed_waits(&prv_data->ec);
+  }
+
+  uint32_t nr = (st->nr_layers < max_layers) ? st->nr_layers : max_layers;
+  if (layers && nr)
+    memcpy(layers, st->layers, nr * sizeof(layers[0]));
+
+  return st->nr_layers;
+}
+
+void cvkcv181x_stats_reset(struct cvikernel_context *ctx)
+{
+  cvk_prv_data_t *prv_data = (cvk_prv_data_t *)ctx->priv_data;
+  stats_t *st = &prv_data->stats;
+  uint32_t enabled = st->enabled;
+
+  free(st->layers);
+  memset(st, 0, sizeof(*st));
+  st->enabled = enabled;
+}
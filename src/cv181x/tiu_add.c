@@ -80,6 +80,7 @@ void cvkcv181x_tiu_add(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu_add: wrong parameter\n");
     return;
   }
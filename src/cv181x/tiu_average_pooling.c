@@ -86,6 +86,7 @@ void cvkcv181x_tiu_average_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu avg pool: wrong parameter\n");
     return;
   }
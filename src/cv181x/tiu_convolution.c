@@ -2,15 +2,26 @@
 
 typedef cvk_tiu_convolution_param_t param_t;
 
-static int can_do_double_conv(cvk_context_t *ctx, const param_t *p)
+// CVK_CONV_SINGLE_* reasons against double conv, 0 if it can be done.
+static uint32_t single_conv_reasons(cvk_context_t *ctx, const param_t *p)
 {
-  if ((p->ifmap->start_address % ctx->info.lmem_size) % 2 == 0 &&
-      p->ifmap->shape.c % 2 == 0 &&
-      p->ifmap->shape.c >= 4 &&
-      p->weight->start_address % 2 == 0)
-    return 1;
+  uint32_t reasons = 0;
+
+  if ((p->ifmap->start_address % ctx->info.lmem_size) % 2)
+    reasons |= CVK_CONV_SINGLE_IFMAP_ADDR;
+  if (p->ifmap->shape.c % 2)
+    reasons |= CVK_CONV_SINGLE_ODD_C;
+  if (p->ifmap->shape.c < 4)
+    reasons |= CVK_CONV_SINGLE_SMALL_C;
+  if (p->weight->start_address % 2)
+    reasons |= CVK_CONV_SINGLE_WEIGHT_ADDR;
+
+  return reasons;
+}
 
-  return 0;
+static int can_do_double_conv(cvk_context_t *ctx, const param_t *p)
+{
+  return !single_conv_reasons(ctx, p);
 }
 
 static int8_t check_conv_param(cvk_context_t *ctx, const param_t *p)
@@ -167,6 +178,7 @@ void cvkcv181x_tiu_convolution(cvk_context_t *ctx, const param_t *p)
   reg.cmd_pre_exe = p->cmd_pre_exe;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu conv: wrong parameter\n");
     return;
   }
@@ -39,6 +39,7 @@ void cvkcv181x_tiu_copy(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu copy: wrong parameter\n");
     return;
   }
@@ -139,6 +139,7 @@ void cvkcv181x_tiu_depthwise_convolution(
   reg.cmd_pre_exe = p->cmd_pre_exe;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu_dw_conv: wrong parameter\n");
     return;
   }
@@ -53,6 +53,7 @@ void cvkcv181x_tiu_ge(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu ge: wrong parameter\n");
     return;
   }
@@ -115,6 +116,7 @@ void cvkcv181x_tiu_ge(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu ge: wrong parameter\n");
     return;
   }
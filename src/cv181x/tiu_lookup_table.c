@@ -108,6 +108,7 @@ void cvkcv181x_tiu_lookup_table(
   reg.layer_info = p->layer_id;
   
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu lookup: wrong parameter\n");
     return;
   }
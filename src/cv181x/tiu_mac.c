@@ -65,6 +65,7 @@ void cvkcv181x_tiu_mac(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu avg pool: wrong paramter\n");
     return;
   }
@@ -54,6 +54,7 @@ void cvkcv181x_tiu_max(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu max: wrong parameter\n");
     return;
   }
@@ -66,6 +66,7 @@ void cvkcv181x_tiu_max_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu max pool: wrong parameter\n");
     return;
   }
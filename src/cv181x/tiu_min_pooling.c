@@ -57,6 +57,7 @@ void cvkcv181x_tiu_min_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu min pool: wrong parameter\n");
     return;
   }
@@ -132,6 +133,7 @@ void cvkcv181x_tiu_min_pooling(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu min pool: wrong parameter\n");
     return;
   }
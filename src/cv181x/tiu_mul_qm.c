@@ -64,6 +64,7 @@ void cvkcv181x_tiu_mul_qm(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu mul qm: wrong parameter\n");
   }
 
@@ -150,6 +150,7 @@ void cvkcv181x_tiu_pt_depthwise_convolution(
   reg.cmd_pre_exe = p->cmd_pre_exe;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x pt dw-conv: invalid param\n");
     return;
   }
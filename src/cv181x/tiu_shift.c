@@ -55,6 +55,7 @@ void cvkcv181x_tiu_arith_shift(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu shift: wrong parameter\n");
     return;
   }
@@ -65,6 +65,7 @@ void cvkcv181x_tiu_sub(
   reg.layer_info = p->layer_id;
 
   if (status) {
+    cvkcv181x_check_failed(ctx);
     printf("cvkcv181x tiu sub: wrong parameter\n");
     return;
   }
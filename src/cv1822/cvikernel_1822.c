@@ -1,6 +1,12 @@
 #include "kernel_internal.h"
 #include <assert.h>
 #include "cvikernel/cvikernel.h"
+#include "lmem_plan.h"
+#include "conv_tiled.h"
+#include "gemm_tiled.h"
+#include "eltwise_tiled.h"
+#include "pool_tiled.h"
+#include "pmu_decode.h"
 #include "../bm1822/kernel_1822.h"
 #include "bmkernel/bm1822/1822_fp_convert.h"
 
@@ -253,6 +259,68 @@ cvk_ml_t *cvk1822_lmem_alloc_ps32_matrix(
   return (cvk_ml_t *)bmk_ml;
 }
 
+cvk_tl_t *cvk1822_lmem_alloc_bank_tensor(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_tl_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  bmk1822_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1822_tensor_lmem_shape_t bmk_shape;
+  SET_TL_SHAPE(bmk_shape, shape);
+
+  bmk1822_tensor_lmem_t *bmk_tl =
+      bmk1822_lmem_alloc_bank_tensor(bmk_ctx, bank_id, bmk_shape, fmt, eu_align);
+
+  return (cvk_tl_t *)bmk_tl;
+}
+
+cvk_ml_t *cvk1822_lmem_alloc_bank_matrix(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_ml_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  bmk1822_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1822_matrix_lmem_shape_t bmk_shape;
+  SET_ML_SHAPE(bmk_shape, shape);
+
+  bmk1822_matrix_lmem_t *bmk_ml =
+      bmk1822_lmem_alloc_bank_matrix(bmk_ctx, bank_id, bmk_shape, fmt, eu_align);
+
+  return (cvk_ml_t *)bmk_ml;
+}
+
+uint32_t cvk1822_lmem_high_water(struct cvikernel_context *ctx)
+{
+  bmk1822_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  return bmk1822_lmem_high_water(bmk_ctx);
+}
+
+void cvk1822_lmem_reset_high_water(struct cvikernel_context *ctx)
+{
+  bmk1822_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1822_lmem_reset_high_water(bmk_ctx);
+}
+
+uint32_t cvk1822_lmem_largest_free(struct cvikernel_context *ctx)
+{
+  bmk1822_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  return bmk1822_lmem_largest_free(bmk_ctx);
+}
+
 void cvk1822_lmem_free_tensor(
     struct cvikernel_context *ctx,
     const cvk_tl_t *tl)
@@ -777,6 +845,8 @@ void cvk1822_tdma_l2g_bf16_general_copy(
   bmk_param.dst_base_reg_index = param->dst_base_reg_index;
   bmk_param.dst_address = param->dst_address;
   bmk_param.src_bytes = param->src_bytes;
+  bmk_param.src_fmt = param->src_fmt;
+  bmk_param.dst_fmt = param->dst_fmt;
 
   bmk1822_tdma_l2g_bf16_general_copy(bmk_ctx, &bmk_param);
 }
@@ -1022,7 +1092,7 @@ void cvk1822_tdma_g2l_general_copy(
   bmk_param.src_base_reg_index = param->src_base_reg_index;
   bmk_param.src_address = param->src_address;
   bmk_param.dst_address = param->dst_address;
-  bmk_param.bytes = param->src_base_reg_index;
+  bmk_param.bytes = param->bytes;
 
   bmk1822_tdma_g2l_general_copy(bmk_ctx, &bmk_param);
 }
@@ -1038,7 +1108,7 @@ void cvk1822_tdma_g2l_bf16_general_copy(
   bmk_param.src_base_reg_index = param->src_base_reg_index;
   bmk_param.src_address = param->src_address;
   bmk_param.dst_address = param->dst_address;
-  bmk_param.src_bytes = param->src_base_reg_index;
+  bmk_param.src_bytes = param->src_bytes;
   bmk_param.src_fmt = param->src_fmt;
   bmk_param.dst_fmt = param->dst_fmt;
 
@@ -2433,9 +2503,79 @@ static cvk_operations_t cvikernel_1822_ops = {
   .tiu_min_pooling = cvk1822_tiu_min_pooling,
 };
 
+static void pmu_add_desc(
+    void *arg,
+    uint32_t segment,
+    uint32_t eng_id,
+    const uint32_t *regs)
+{
+  pmu_descs_t *d = (pmu_descs_t *)arg;
+
+  (void)segment;
+
+  if (eng_id == BMK1822_TIU) {
+    tiu_reg_t reg;
+    parse_tiu_reg(&reg, regs);
+    pmu_descs_add(d, eng_id, reg.cmd_id_tpu, reg.layer_info);
+  } else {
+    tdma_reg_t reg;
+    parse_tdma_reg(&reg, regs);
+    pmu_descs_add(d, eng_id, reg.cmd_id, reg.layer_ID);
+  }
+}
+
+int cvk1822_pmu_decode(
+    struct cvikernel_context *ctx,
+    const uint8_t *dmabuf,
+    uint32_t dmabuf_size,
+    const uint8_t *pmu,
+    uint32_t pmu_size,
+    cvk_pmu_event_t *events,
+    uint32_t max_events,
+    uint32_t *nr_events)
+{
+  pmu_descs_t d;
+
+  (void)ctx;
+  memset(&d, 0, sizeof(d));
+
+  int ret = bmk1822_dmabuf_walk(dmabuf, dmabuf_size, pmu_add_desc, &d);
+  if (ret >= 0)
+    ret = pmu_decode_records(&d, pmu, pmu_size, events, max_events,
+                             nr_events);
+  else if (nr_events)
+    *nr_events = 0;
+
+  pmu_descs_free(&d);
+  return (ret < 0) ? -1 : 0;
+}
+
+uint32_t cvk1822_pmu_layer_report(
+    struct cvikernel_context *ctx,
+    const cvk_pmu_event_t *events,
+    uint32_t nr_events,
+    cvk_pmu_layer_t *layers,
+    uint32_t max_layers)
+{
+  (void)ctx;
+  return pmu_layer_report(events, nr_events, layers, max_layers);
+}
+
 static cvk_misc_operations_t cvikernel_1822_misc_ops = {
   .float_to_bfloat16 = cvk1822_float_to_bfloat16,
   .bf16_table_shape = cvk1822_bf16_table_shape,
+  .lmem_alloc_bank_tensor = cvk1822_lmem_alloc_bank_tensor,
+  .lmem_alloc_bank_matrix = cvk1822_lmem_alloc_bank_matrix,
+  .lmem_high_water = cvk1822_lmem_high_water,
+  .lmem_reset_high_water = cvk1822_lmem_reset_high_water,
+  .lmem_largest_free = cvk1822_lmem_largest_free,
+  .lmem_plan = cvk_lmem_plan,
+  .conv_tiled = cvk_conv_tiled,
+  .gemm_tiled = cvk_gemm_tiled,
+  .eltwise_tiled = cvk_eltwise_tiled,
+  .pool_tiled = cvk_pool_tiled,
+  .pmu_decode = cvk1822_pmu_decode,
+  .pmu_layer_report = cvk1822_pmu_layer_report,
 };
 
 char *cvikernel_get_chip_info_1822(void)
@@ -2493,7 +2633,11 @@ void cvikernel_init_1822(
   bmk_ctx->max_nr_desc = max_nr_desc;
   bmk_ctx->cur_nr_desc = 0;
   bmk_ctx->desc_pairs = xmalloc(max_nr_desc * sizeof(bmk_ctx->desc_pairs[0]));
-  bmk_ctx->lmem_ptr = 0;
+  lmem_heap_init(&bmk_ctx->lmem_heap, bmk_ctx->chip_info.lmem_size,
+                 bmk_ctx->chip_info.lmem_banks,
+                 bmk_ctx->chip_info.lmem_bank_size,
+                 bmk_ctx->chip_info.eu_num);
+  desc_pool_init(&bmk_ctx->tl_ml_pool, TL_ML_POOL_OBJ_SIZE, 64);
 
   ec_init(&bmk_ctx->ec, BMK1822_ENGINE_NUM, max_nr_desc);
   mode_manager_init(&bmk_ctx->mode_manager, &bmk_ctx->ec, BMK1822_ENGINE_NUM);
@@ -1,5 +1,10 @@
 #include "kernel_internal.h"
 #include "cvikernel/cvikernel.h"
+#include "lmem_plan.h"
+#include "conv_tiled.h"
+#include "gemm_tiled.h"
+#include "eltwise_tiled.h"
+#include "pool_tiled.h"
 #include "../bm1880v2/kernel_1880v2.h"
 #include "../bm1880v2/non_atomic/gen_lut.h"
 #include "bmkernel/bm1880v2/1880v2_fp_convert.h"
@@ -250,6 +255,68 @@ cvk_ml_t *cvk1880v2_lmem_alloc_ps32_matrix(
   return (cvk_ml_t *)bmk_ml;
 }
 
+cvk_tl_t *cvk1880v2_lmem_alloc_bank_tensor(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_tl_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  bmk1880v2_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1880v2_tensor_lmem_shape_t bmk_shape;
+  SET_TL_SHAPE(bmk_shape, shape);
+
+  bmk1880v2_tensor_lmem_t *bmk_tl =
+      bmk1880v2_lmem_alloc_bank_tensor(bmk_ctx, bank_id, bmk_shape, fmt, eu_align);
+
+  return (cvk_tl_t *)bmk_tl;
+}
+
+cvk_ml_t *cvk1880v2_lmem_alloc_bank_matrix(
+    cvk_context_t *ctx,
+    uint32_t bank_id,
+    cvk_ml_shape_t shape,
+    cvk_fmt_t fmt,
+    int eu_align)
+{
+  bmk1880v2_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1880v2_matrix_lmem_shape_t bmk_shape;
+  SET_ML_SHAPE(bmk_shape, shape);
+
+  bmk1880v2_matrix_lmem_t *bmk_ml =
+      bmk1880v2_lmem_alloc_bank_matrix(bmk_ctx, bank_id, bmk_shape, fmt, eu_align);
+
+  return (cvk_ml_t *)bmk_ml;
+}
+
+uint32_t cvk1880v2_lmem_high_water(struct cvikernel_context *ctx)
+{
+  bmk1880v2_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  return bmk1880v2_lmem_high_water(bmk_ctx);
+}
+
+void cvk1880v2_lmem_reset_high_water(struct cvikernel_context *ctx)
+{
+  bmk1880v2_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  bmk1880v2_lmem_reset_high_water(bmk_ctx);
+}
+
+uint32_t cvk1880v2_lmem_largest_free(struct cvikernel_context *ctx)
+{
+  bmk1880v2_context_t *bmk_ctx =
+      ((cvk_prv_data_t *)ctx->priv_data)->bmk_ctx;
+
+  return bmk1880v2_lmem_largest_free(bmk_ctx);
+}
+
 void cvk1880v2_lmem_free_tensor(
     struct cvikernel_context *ctx,
     const cvk_tl_t *tl)
@@ -768,6 +835,8 @@ void cvk1880v2_tdma_l2g_bf16_general_copy(
   bmk_param.dst_base_reg_index = param->dst_base_reg_index;
   bmk_param.dst_address = param->dst_address;
   bmk_param.src_bytes = param->src_bytes;
+  bmk_param.src_fmt = param->src_fmt;
+  bmk_param.dst_fmt = param->dst_fmt;
 
   bmk1880v2_tdma_l2g_bf16_general_copy(bmk_ctx, &bmk_param);
 }
@@ -1007,7 +1076,7 @@ void cvk1880v2_tdma_g2l_general_copy(
   bmk_param.src_base_reg_index = param->src_base_reg_index;
   bmk_param.src_address = param->src_address;
   bmk_param.dst_address = param->dst_address;
-  bmk_param.bytes = param->src_base_reg_index;
+  bmk_param.bytes = param->bytes;
 
   bmk1880v2_tdma_g2l_general_copy(bmk_ctx, &bmk_param);
 }
@@ -1023,7 +1092,7 @@ void cvk1880v2_tdma_g2l_bf16_general_copy(
   bmk_param.src_base_reg_index = param->src_base_reg_index;
   bmk_param.src_address = param->src_address;
   bmk_param.dst_address = param->dst_address;
-  bmk_param.src_bytes = param->src_base_reg_index;
+  bmk_param.src_bytes = param->src_bytes;
   bmk_param.src_fmt = param->src_fmt;
   bmk_param.dst_fmt = param->dst_fmt;
 
@@ -2341,6 +2410,16 @@ static cvk_operations_t cvikernel_1880v2_ops = {
 static cvk_misc_operations_t cvikernel_1880v2_misc_ops = {
   .float_to_bfloat16 = cvk1880v2_float_to_bfloat16,
   .bf16_table_shape = cvk1880v2_bf16_table_shape,
+  .lmem_alloc_bank_tensor = cvk1880v2_lmem_alloc_bank_tensor,
+  .lmem_alloc_bank_matrix = cvk1880v2_lmem_alloc_bank_matrix,
+  .lmem_high_water = cvk1880v2_lmem_high_water,
+  .lmem_reset_high_water = cvk1880v2_lmem_reset_high_water,
+  .lmem_largest_free = cvk1880v2_lmem_largest_free,
+  .lmem_plan = cvk_lmem_plan,
+  .conv_tiled = cvk_conv_tiled,
+  .gemm_tiled = cvk_gemm_tiled,
+  .eltwise_tiled = cvk_eltwise_tiled,
+  .pool_tiled = cvk_pool_tiled,
 };
 
 char *cvikernel_get_chip_info_1880v2(void)
@@ -2396,7 +2475,11 @@ void cvikernel_init_1880v2(
   bmk_ctx->max_nr_desc = max_nr_desc;
   bmk_ctx->cur_nr_desc = 0;
   bmk_ctx->desc_pairs = xmalloc(max_nr_desc * sizeof(bmk_ctx->desc_pairs[0]));
-  bmk_ctx->lmem_ptr = 0;
+  lmem_heap_init(&bmk_ctx->lmem_heap, bmk_ctx->chip_info.lmem_size,
+                 bmk_ctx->chip_info.lmem_banks,
+                 bmk_ctx->chip_info.lmem_bank_size,
+                 bmk_ctx->chip_info.eu_num);
+  desc_pool_init(&bmk_ctx->tl_ml_pool, TL_ML_POOL_OBJ_SIZE, 64);
 
   ec_init(&bmk_ctx->ec, BMK1880v2_ENGINE_NUM, max_nr_desc);
   mode_manager_init(&bmk_ctx->mode_manager, &bmk_ctx->ec, BMK1880v2_ENGINE_NUM);
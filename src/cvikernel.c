@@ -50,23 +50,24 @@ extern void cvikernel_init_1880v2(
 typedef struct chip_query_info {
   char *(*get_chip_version)(void);
   void (*chip_init)(cvk_reg_info_t *req_info, cvk_context_t *context);
+  int growable_cmdbuf;  // accepts NULL cmdbuf, see cvk_reg_info_t
 } chip_query_info_t;
 
 // Supported chips
 static chip_query_info_t cvikernel_chip_list[] = {
 #if CHIPID == 0x3
-  {cvikernel_get_chip_info_cv181x, cvikernel_init_cv181x},
+  {cvikernel_get_chip_info_cv181x, cvikernel_init_cv181x, 1},
 #elif CHIPID == 0x4
-  {cvikernel_get_chip_info_cv180x, cvikernel_init_cv180x},
+  {cvikernel_get_chip_info_cv180x, cvikernel_init_cv180x, 1},
 #elif CHIPID == 0x1
-  {cvikernel_get_chip_info_1880v2, cvikernel_init_1880v2},
+  {cvikernel_get_chip_info_1880v2, cvikernel_init_1880v2, 0},
 #elif CHIPID == 0x2
 #else
-  {cvikernel_get_chip_info_cv181x, cvikernel_init_cv181x},
-  {cvikernel_get_chip_info_cv180x, cvikernel_init_cv180x},
-  {cvikernel_get_chip_info_1880v2, cvikernel_init_1880v2},
+  {cvikernel_get_chip_info_cv181x, cvikernel_init_cv181x, 1},
+  {cvikernel_get_chip_info_cv180x, cvikernel_init_cv180x, 1},
+  {cvikernel_get_chip_info_1880v2, cvikernel_init_1880v2, 0},
 #endif
-  {cvikernel_get_chip_info_1822, cvikernel_init_1822}
+  {cvikernel_get_chip_info_1822, cvikernel_init_1822, 0}
 };
 
 #define NUM_DEVICES (sizeof(cvikernel_chip_list)/sizeof(chip_query_info_t))
@@ -75,8 +76,6 @@ cvk_context_t *cvikernel_register(cvk_reg_info_t *req_info)
 {
   if (!req_info)
     return NULL;
-  if (!req_info->cmdbuf)
-    return NULL;
 
   size_t req_chip_size = sizeof(req_info->chip_ver_str);
   size_t req_chip_len = strlen(req_info->chip_ver_str);
@@ -87,6 +86,9 @@ cvk_context_t *cvikernel_register(cvk_reg_info_t *req_info)
     // Compare chip string
     if (!strncmp(version, req_info->chip_ver_str, req_chip_size) &&
         strlen(version) == req_chip_len) {
+      if (!req_info->cmdbuf && !cvikernel_chip_list[i].growable_cmdbuf)
+        return NULL;
+
       cvk_context_t *context = malloc(sizeof(cvk_context_t));
       if (!context)
         return NULL;
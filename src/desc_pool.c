@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include "desc_pool.h"
+
+void desc_pool_init(desc_pool_t *pool, uint32_t obj_size,
+                    uint32_t objs_per_chunk)
+{
+  // Free objects hold the free list link, keep them 8-byte aligned.
+  if (obj_size < sizeof(void *))
+    obj_size = sizeof(void *);
+  obj_size = (obj_size + 7) & ~7;
+
+  pool->obj_size = obj_size;
+  pool->objs_per_chunk = objs_per_chunk ? objs_per_chunk : 1;
+  pool->chunks = NULL;
+  pool->free_list = NULL;
+}
+
+void desc_pool_destroy(desc_pool_t *pool)
+{
+  desc_pool_chunk_t *c = pool->chunks;
+  while (c) {
+    desc_pool_chunk_t *next = c->next;
+    free(c);
+    c = next;
+  }
+
+  pool->chunks = NULL;
+  pool->free_list = NULL;
+}
+
+static int add_chunk(desc_pool_t *pool)
+{
+  uint32_t n = pool->objs_per_chunk;
+  desc_pool_chunk_t *c = malloc(sizeof(*c) + (size_t)n * pool->obj_size);
+  if (!c)
+    return -1;
+
+  c->next = pool->chunks;
+  pool->chunks = c;
+
+  // Thread the new objects in address order.
+  uint8_t *buf = (uint8_t *)c->buf;
+  for (uint32_t i = n; i > 0; i--) {
+    void **obj = (void **)&buf[(size_t)(i - 1) * pool->obj_size];
+    *obj = pool->free_list;
+    pool->free_list = obj;
+  }
+
+  return 0;
+}
+
+void *desc_pool_alloc(desc_pool_t *pool)
+{
+  if (!pool->free_list && add_chunk(pool))
+    return NULL;
+
+  void **obj = pool->free_list;
+  pool->free_list = *obj;
+  return obj;
+}
+
+void desc_pool_free(desc_pool_t *pool, void *obj)
+{
+  if (!obj)
+    return;
+
+  *(void **)obj = pool->free_list;
+  pool->free_list = obj;
+}
@@ -0,0 +1,33 @@
+#ifndef CVIKERNEL_DESC_POOL_H
+#define CVIKERNEL_DESC_POOL_H
+
+#include <stdint.h>
+
+// Pool of fixed size objects, for the tensor and matrix descriptors handed
+// out by lmem_alloc_tensor/lmem_alloc_matrix.
+//
+// Objects are carved from chunks and recycled through a free list, so once
+// the pool has grown to the number of live descriptors allocation and free
+// no longer call malloc. Chunks are only released by destroy.
+typedef struct desc_pool_chunk {
+  struct desc_pool_chunk *next;
+  uint64_t buf[];
+} desc_pool_chunk_t;
+
+typedef struct {
+  uint32_t obj_size;
+  uint32_t objs_per_chunk;
+  desc_pool_chunk_t *chunks;
+  void *free_list;
+} desc_pool_t;
+
+void desc_pool_init(desc_pool_t *pool, uint32_t obj_size,
+                    uint32_t objs_per_chunk);
+void desc_pool_destroy(desc_pool_t *pool);
+
+// Return an uninitialized object, or NULL if a new chunk cannot be
+// allocated.
+void *desc_pool_alloc(desc_pool_t *pool);
+void desc_pool_free(desc_pool_t *pool, void *obj);
+
+#endif /* CVIKERNEL_DESC_POOL_H */
@@ -0,0 +1,548 @@
+#include <string.h>
+#include "eltwise_tiled.h"
+#include "tile_pipeline.h"
+
+//
+// The tensors are taken as flat arrays of count elements. Each tile is a
+// contiguous run of them viewed as (1, npu_num, h, w), so every lane gets
+// h * w elements, followed by at most two smaller tail tiles,
+// (1, c, 1, w) and (1, 1, 1, rest), for the elements left over.
+//
+// The chain runs in place on the buffer input a is loaded into, which is
+// then stored, so the buffers form a ring of three: the tile being loaded,
+// computed and stored in a stage each have their own.
+//
+// Int8 add and mac need a 16-bit accumulator: the value is first widened
+// into the second plane of its buffer (x * 1 with a 16-bit result), then
+// the tiu op narrows it back to 8 bits with the shift and relu applied.
+//
+#define ELTWISE_MAX_W     1024
+#define ELTWISE_MAX_DIM   4095
+#define ELTWISE_NR_BUFS   3
+
+typedef struct {
+  const cvk_eltwise_tiled_param_t *p;
+  cvk_fmt_t fmt;
+  uint32_t fmt_size;
+  uint64_t count;
+
+  uint32_t w;
+  uint32_t rows;                // full (1, npu_num, 1, w) rows in count
+  uint32_t nr_rows;             // tiles over them
+  uint32_t nr_tails;
+  cvk_tl_shape_t tails[2];
+  int wide;                     // x needs the 16-bit plane
+  int uses_b;
+
+  cvk_eltwise_tiling_t t;
+
+  cvk_tl_t *x[ELTWISE_NR_BUFS];
+  cvk_tl_t *b[ELTWISE_NR_BUFS];
+} eltwise_tiled_t;
+
+static uint32_t ceil_div(uint32_t a, uint32_t b)
+{
+  return (a + b - 1) / b;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+  return (a < b) ? a : b;
+}
+
+static uint32_t lmem_size(cvk_context_t *ctx, const eltwise_tiled_t *e)
+{
+  uint32_t npu_num = ctx->info.npu_num;
+  uint32_t h = e->t.h_step ? e->t.h_step : 1;
+  cvk_tl_shape_t xs = {e->wide ? 2 : 1, npu_num, h, e->w};
+  cvk_tl_shape_t bs = {1, npu_num, h, e->w};
+  uint32_t size = ctx->ops->lmem_tensor_to_size(ctx, xs, e->fmt, 1);
+
+  if (e->uses_b)
+    size += ctx->ops->lmem_tensor_to_size(ctx, bs, e->fmt, 1);
+
+  return ELTWISE_NR_BUFS * size;
+}
+
+static void free_buffers(cvk_context_t *ctx, eltwise_tiled_t *e)
+{
+  for (int i = ELTWISE_NR_BUFS - 1; i >= 0; i--) {
+    if (e->b[i])
+      ctx->ops->lmem_free_tensor(ctx, e->b[i]);
+    if (e->x[i])
+      ctx->ops->lmem_free_tensor(ctx, e->x[i]);
+    e->b[i] = NULL;
+    e->x[i] = NULL;
+  }
+}
+
+static int alloc_buffers(cvk_context_t *ctx, eltwise_tiled_t *e)
+{
+  uint32_t npu_num = ctx->info.npu_num;
+  uint32_t h = e->t.h_step ? e->t.h_step : 1;
+  cvk_tl_shape_t xs = {e->wide ? 2 : 1, npu_num, h, e->w};
+  cvk_tl_shape_t bs = {1, npu_num, h, e->w};
+
+  for (uint32_t i = 0; i < ELTWISE_NR_BUFS; i++) {
+    e->x[i] = ctx->ops->lmem_alloc_tensor(ctx, xs, e->fmt, 1);
+    if (e->uses_b)
+      e->b[i] = ctx->ops->lmem_alloc_tensor(ctx, bs, e->fmt, 1);
+
+    if (!e->x[i] || (e->uses_b && !e->b[i])) {
+      free_buffers(ctx, e);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void set_steps(cvk_context_t *ctx, eltwise_tiled_t *e, uint32_t nr)
+{
+  uint64_t lane = (uint64_t)ctx->info.npu_num * e->w;
+  uint64_t rest = e->count - (uint64_t)e->rows * lane;
+
+  e->t.h_step = e->rows ? ceil_div(e->rows, nr) : 0;
+  e->nr_rows = e->rows ? ceil_div(e->rows, e->t.h_step) : 0;
+
+  e->nr_tails = 0;
+  if (rest >= e->w) {
+    cvk_tl_shape_t s = {1, (uint32_t)(rest / e->w), 1, e->w};
+    e->tails[e->nr_tails++] = s;
+    rest %= e->w;
+  }
+  if (rest) {
+    cvk_tl_shape_t s = {1, 1, 1, (uint32_t)rest};
+    e->tails[e->nr_tails++] = s;
+  }
+
+  e->t.w = e->w;
+  e->t.nr_tiles = e->nr_rows + e->nr_tails;
+}
+
+static int set_width(cvk_context_t *ctx, eltwise_tiled_t *e, uint32_t w)
+{
+  uint64_t lane = (uint64_t)ctx->info.npu_num * w;
+
+  if (e->count / lane > UINT32_MAX)
+    return -1;
+
+  e->w = w;
+  e->rows = e->count / lane;
+  return 0;
+}
+
+// Most rows per tile whose ring of buffers fits in the local memory left
+// free. Past a single row, halve the row width, kept a multiple of eu_num,
+// down to eu_num.
+static int choose_tiling(cvk_context_t *ctx, eltwise_tiled_t *e)
+{
+  uint32_t eu_num = ctx->info.eu_num;
+  uint32_t lmem_free = tile_lmem_free(ctx);
+  uint64_t per_lane = (e->count + ctx->info.npu_num - 1) / ctx->info.npu_num;
+
+  if (set_width(ctx, e, (per_lane < ELTWISE_MAX_W) ? (uint32_t)per_lane
+                                                   : ELTWISE_MAX_W))
+    return -1;
+
+  uint32_t nr = ceil_div(e->rows, ELTWISE_MAX_DIM);
+  for (;;) {
+    set_steps(ctx, e, nr ? nr : 1);
+
+    uint32_t size = lmem_size(ctx, e);
+    if (size <= lmem_free && !alloc_buffers(ctx, e)) {
+      e->t.lmem_size = size;
+      return 0;
+    }
+
+    if (e->t.h_step > 1) {
+      // Next count of tiles with fewer rows each.
+      uint32_t h_step = e->t.h_step;
+      while (ceil_div(e->rows, ++nr) == h_step)
+        ;
+      continue;
+    }
+
+    if (e->w <= eu_num)
+      return -1;
+
+    uint32_t w = e->w / 2 / eu_num * eu_num;
+    if (set_width(ctx, e, (w > eu_num) ? w : eu_num))
+      return -1;
+    nr = ceil_div(e->rows, ELTWISE_MAX_DIM);
+  }
+}
+
+// Element offset and shape of tile i.
+static uint64_t get_tile(cvk_context_t *ctx, const eltwise_tiled_t *e,
+                         uint32_t i, cvk_tl_shape_t *shape)
+{
+  uint64_t lane = (uint64_t)ctx->info.npu_num * e->w;
+
+  if (i < e->nr_rows) {
+    uint32_t row = i * e->t.h_step;
+    cvk_tl_shape_t s = {1, ctx->info.npu_num,
+                        min_u32(e->t.h_step, e->rows - row), e->w};
+    *shape = s;
+    return (uint64_t)row * lane;
+  }
+
+  uint64_t offset = (uint64_t)e->rows * lane;
+  for (uint32_t j = 0; j < i - e->nr_rows; j++)
+    offset += (uint64_t)e->tails[j].c * e->tails[j].w;
+
+  *shape = e->tails[i - e->nr_rows];
+  return offset;
+}
+
+static cvk_tl_t tl_view(cvk_context_t *ctx, const cvk_tl_t *buf,
+                        cvk_tl_shape_t shape)
+{
+  cvk_tl_t t = *buf;
+  t.shape = shape;
+  t.stride = ctx->ops->tl_default_stride(ctx, shape, t.fmt, 1);
+  return t;
+}
+
+static cvk_tg_t tg_view(const eltwise_tiled_t *e, const cvk_tg_t *tg,
+                        uint64_t offset, cvk_tl_shape_t shape)
+{
+  cvk_tg_t t = *tg;
+  t.start_address += offset * e->fmt_size;
+  t.shape.n = shape.n;
+  t.shape.c = shape.c;
+  t.shape.h = shape.h;
+  t.shape.w = shape.w;
+  t.stride.w = e->fmt_size;
+  t.stride.h = shape.w * e->fmt_size;
+  t.stride.c = shape.h * shape.w * e->fmt_size;
+  t.stride.n = shape.c * t.stride.c;
+  return t;
+}
+
+static void load(cvk_context_t *ctx, const eltwise_tiled_t *e,
+                 const cvk_tg_t *tg, const cvk_tl_t *buf, uint64_t offset,
+                 cvk_tl_shape_t shape)
+{
+  cvk_tg_t src = tg_view(e, tg, offset, shape);
+  cvk_tl_t dst = tl_view(ctx, buf, shape);
+
+  cvk_tdma_g2l_tensor_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = &src;
+  param.dst = &dst;
+  param.layer_id = e->p->layer_id;
+  ctx->ops->tdma_g2l_tensor_copy(ctx, &param);
+}
+
+static void eltwise_load(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const eltwise_tiled_t *e = arg;
+  cvk_tl_shape_t shape;
+  uint64_t offset = get_tile(ctx, e, i, &shape);
+
+  load(ctx, e, e->p->a, e->x[buf], offset, shape);
+  if (e->uses_b)
+    load(ctx, e, e->p->b, e->b[buf], offset, shape);
+}
+
+// x widened to 16 bits, low byte in x and high byte in hi.
+static void widen(cvk_context_t *ctx, const eltwise_tiled_t *e,
+                  const cvk_tl_t *x, const cvk_tl_t *hi)
+{
+  cvk_tiu_mul_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.res_high = hi;
+  param.res_low = x;
+  param.a = x;
+  param.b_is_const = 1;
+  param.b_const.val = 1;
+  param.b_const.is_signed = (e->fmt == CVK_FMT_I8);
+  param.layer_id = e->p->layer_id;
+  ctx->ops->tiu_mul(ctx, &param);
+}
+
+static void run_step(cvk_context_t *ctx, const eltwise_tiled_t *e,
+                     const cvk_eltwise_step_t *st, const cvk_tl_t *x,
+                     const cvk_tl_t *hi, const cvk_tl_t *b)
+{
+  int bf16 = (e->fmt == CVK_FMT_BF16);
+  int is_signed = (e->fmt == CVK_FMT_I8);
+  int b_is_const = st->b_is_const && st->op != CVK_ELTWISE_MAC;
+  uint16_t layer_id = e->p->layer_id;
+
+  switch (st->op) {
+    case CVK_ELTWISE_ADD:
+      if (!bf16) {
+        widen(ctx, e, x, hi);
+        if (!b_is_const) {
+          // x + b * 1, b need not be 16-bit for mac
+          cvk_tiu_mac_param_t param;
+          memset(&param, 0, sizeof(param));
+          param.res_high = hi;
+          param.res_low = x;
+          param.a = b;
+          param.b_is_const = 1;
+          param.b_const.val = 1;
+          param.b_const.is_signed = is_signed;
+          param.res_is_int8 = 1;
+          param.rshift_bits = st->rshift_bits;
+          param.relu_enable = st->relu_enable;
+          param.layer_id = layer_id;
+          ctx->ops->tiu_mac(ctx, &param);
+          return;
+        }
+      }
+      {
+        cvk_tiu_add_param_t param;
+        memset(&param, 0, sizeof(param));
+        param.res_low = x;
+        param.a_high = bf16 ? NULL : hi;
+        param.a_low = x;
+        param.b_is_const = b_is_const;
+        if (b_is_const) {
+          param.b_const.val = st->const_val;
+          param.b_const.is_signed = is_signed;
+        } else {
+          param.b.low = b;
+        }
+        param.rshift_bits = st->rshift_bits;
+        param.relu_enable = st->relu_enable;
+        param.layer_id = layer_id;
+        ctx->ops->tiu_add(ctx, &param);
+      }
+      return;
+
+    case CVK_ELTWISE_MUL: {
+      cvk_tiu_mul_param_t param;
+      memset(&param, 0, sizeof(param));
+      param.res_low = x;
+      param.a = x;
+      param.b_is_const = b_is_const;
+      if (b_is_const) {
+        param.b_const.val = st->const_val;
+        param.b_const.is_signed = is_signed;
+      } else {
+        param.b = b;
+      }
+      param.rshift_bits = st->rshift_bits;
+      param.relu_enable = st->relu_enable;
+      param.layer_id = layer_id;
+      ctx->ops->tiu_mul(ctx, &param);
+      return;
+    }
+
+    case CVK_ELTWISE_MAC: {
+      if (!bf16)
+        widen(ctx, e, x, hi);
+
+      cvk_tiu_mac_param_t param;
+      memset(&param, 0, sizeof(param));
+      param.res_high = bf16 ? NULL : hi;
+      param.res_low = x;
+      param.a = b;
+      param.b_is_const = 1;
+      param.b_const.val = st->const_val;
+      param.b_const.is_signed = is_signed;
+      param.res_is_int8 = 1;
+      param.rshift_bits = st->rshift_bits;
+      param.relu_enable = st->relu_enable;
+      param.layer_id = layer_id;
+      ctx->ops->tiu_mac(ctx, &param);
+      return;
+    }
+
+    case CVK_ELTWISE_MAX: {
+      cvk_tiu_max_param_t param;
+      memset(&param, 0, sizeof(param));
+      param.max = x;
+      param.a = x;
+      param.b_is_const = b_is_const;
+      if (b_is_const) {
+        param.b_const.val = st->const_val;
+        param.b_const.is_signed = is_signed;
+      } else {
+        param.b = b;
+      }
+      param.layer_id = layer_id;
+      ctx->ops->tiu_max(ctx, &param);
+      return;
+    }
+
+    case CVK_ELTWISE_MIN: {
+      cvk_tiu_min_param_t param;
+      memset(&param, 0, sizeof(param));
+      param.min = x;
+      param.a = x;
+      param.b_is_const = b_is_const;
+      if (b_is_const) {
+        param.b_const.val = st->const_val;
+        param.b_const.is_signed = is_signed;
+      } else {
+        param.b = b;
+      }
+      param.layer_id = layer_id;
+      ctx->ops->tiu_min(ctx, &param);
+      return;
+    }
+
+    case CVK_ELTWISE_GE: {
+      cvk_tiu_ge_param_t param;
+      memset(&param, 0, sizeof(param));
+      param.ge = x;
+      param.a = x;
+      param.b_is_const = b_is_const;
+      if (b_is_const) {
+        param.b_const.val = st->const_val;
+        param.b_const.is_signed = is_signed;
+      } else {
+        param.b = b;
+      }
+      param.layer_id = layer_id;
+      ctx->ops->tiu_ge(ctx, &param);
+      return;
+    }
+  }
+}
+
+static void eltwise_compute(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const eltwise_tiled_t *e = arg;
+  cvk_tl_shape_t shape;
+  get_tile(ctx, e, i, &shape);
+
+  cvk_tl_t x = tl_view(ctx, e->x[buf], shape);
+  cvk_tl_t hi = x;
+  cvk_tl_t b;
+
+  // High plane of the 16-bit accumulator, the second n of the buffer.
+  if (e->wide)
+    hi.start_address = e->x[buf]->start_address + x.stride.n;
+  if (e->uses_b)
+    b = tl_view(ctx, e->b[buf], shape);
+
+  for (uint32_t s = 0; s < e->p->nr_steps; s++)
+    run_step(ctx, e, &e->p->steps[s], &x, &hi, e->uses_b ? &b : NULL);
+}
+
+static void eltwise_store(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const eltwise_tiled_t *e = arg;
+  cvk_tl_shape_t shape;
+  uint64_t offset = get_tile(ctx, e, i, &shape);
+
+  cvk_tl_t src = tl_view(ctx, e->x[buf], shape);
+  cvk_tg_t dst = tg_view(e, e->p->res, offset, shape);
+
+  cvk_tdma_l2g_tensor_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = &src;
+  param.dst = &dst;
+  param.layer_id = e->p->layer_id;
+  ctx->ops->tdma_l2g_tensor_copy(ctx, &param);
+}
+
+static uint64_t tg_count(const cvk_tg_t *t)
+{
+  return (uint64_t)t->shape.n * t->shape.c * t->shape.h * t->shape.w;
+}
+
+// Compact layout, the tensor is one run of tg_count elements.
+static int tg_is_compact(const cvk_tg_t *t, uint32_t fmt_size)
+{
+  return t->stride.w == fmt_size &&
+         t->stride.h == t->shape.w * fmt_size &&
+         t->stride.c == t->shape.h * t->stride.h &&
+         t->stride.n == t->shape.c * t->stride.c;
+}
+
+static int check_param(const cvk_eltwise_tiled_param_t *p, int *uses_b,
+                       int *wide)
+{
+  if (!p || !p->a || !p->res || !p->nr_steps || !p->steps ||
+      p->nr_steps > CVK_ELTWISE_MAX_STEPS)
+    return -1;
+
+  cvk_fmt_t fmt = p->a->fmt;
+  uint32_t fmt_size = (fmt == CVK_FMT_BF16) ? 2 : 1;
+  int bf16 = (fmt == CVK_FMT_BF16);
+
+  *uses_b = 0;
+  *wide = 0;
+  for (uint32_t i = 0; i < p->nr_steps; i++) {
+    const cvk_eltwise_step_t *st = &p->steps[i];
+
+    if (st->op > CVK_ELTWISE_GE)
+      return -1;
+    if (st->op == CVK_ELTWISE_MAC || !st->b_is_const)
+      *uses_b = 1;
+    if (!bf16 && (st->op == CVK_ELTWISE_ADD || st->op == CVK_ELTWISE_MAC))
+      *wide = 1;
+
+    int arith = (st->op == CVK_ELTWISE_ADD || st->op == CVK_ELTWISE_MUL ||
+                 st->op == CVK_ELTWISE_MAC);
+    if (!arith && (st->rshift_bits || st->relu_enable))
+      return -1;
+    if (bf16 && st->rshift_bits)
+      return -1;
+
+    // Int8 constants are 8-bit but for add, which adds to the 16-bit value.
+    int has_const = st->b_is_const || st->op == CVK_ELTWISE_MAC;
+    if (!bf16 && has_const && st->op != CVK_ELTWISE_ADD) {
+      int lo = (fmt == CVK_FMT_I8) ? -128 : 0;
+      int hi = (fmt == CVK_FMT_I8) ? 127 : 255;
+      if (st->const_val < lo || st->const_val > hi)
+        return -1;
+    }
+  }
+
+  if (*uses_b && !p->b)
+    return -1;
+
+  const cvk_tg_t *t[] = {p->a, p->res, *uses_b ? p->b : NULL};
+  for (uint32_t i = 0; i < 3; i++) {
+    if (!t[i])
+      continue;
+    if (t[i]->fmt != fmt || !tg_is_compact(t[i], fmt_size) ||
+        tg_count(t[i]) != tg_count(p->a))
+      return -1;
+  }
+
+  return tg_count(p->a) ? 0 : -1;
+}
+
+int cvk_eltwise_tiled(
+    cvk_context_t *ctx,
+    const cvk_eltwise_tiled_param_t *p,
+    cvk_eltwise_tiling_t *tiling)
+{
+  eltwise_tiled_t e;
+
+  if (tiling)
+    memset(tiling, 0, sizeof(*tiling));
+
+  memset(&e, 0, sizeof(e));
+  if (check_param(p, &e.uses_b, &e.wide))
+    return -1;
+
+  e.p = p;
+  e.fmt = p->a->fmt;
+  e.fmt_size = (e.fmt == CVK_FMT_BF16) ? 2 : 1;
+  e.count = tg_count(p->a);
+
+  if (choose_tiling(ctx, &e))
+    return -1;
+
+  static const tile_pipeline_t pl = {
+      eltwise_load, eltwise_compute, eltwise_store, ELTWISE_NR_BUFS};
+  int ret = tile_pipeline_run(ctx, &pl, &e, e.t.nr_tiles);
+
+  free_buffers(ctx, &e);
+
+  if (tiling)
+    *tiling = e.t;
+  return ret;
+}
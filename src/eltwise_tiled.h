@@ -0,0 +1,14 @@
+#ifndef CVIKERNEL_ELTWISE_TILED_H
+#define CVIKERNEL_ELTWISE_TILED_H
+
+#include <cvikernel/cvikernel.h>
+
+// Elementwise op chain over global memory tensors streamed through local
+// memory, shared by the chip backends, see eltwise_tiled in
+// cvk_misc_operations_t.
+int cvk_eltwise_tiled(
+    cvk_context_t *ctx,
+    const cvk_eltwise_tiled_param_t *p,
+    cvk_eltwise_tiling_t *tiling);
+
+#endif /* CVIKERNEL_ELTWISE_TILED_H */
@@ -31,6 +31,12 @@ void dump_desc(ec_desc_t *desc)
 }
 #endif /* CVK_EC_DEBUG */
 
+static inline ec_desc_t *desc_at(ec_t *ec, uint32_t seq_no)
+{
+  ec_block_t *b = &ec->blocks[seq_no / ec->block_nr_desc];
+  return &b->desc[seq_no % ec->block_nr_desc];
+}
+
 static void ec_desc_init(ec_desc_t *d, uint32_t engine_id, uint32_t nr_engines)
 {
   d->engine_id = engine_id;
@@ -41,36 +47,58 @@ static void ec_desc_init(ec_desc_t *d, uint32_t engine_id, uint32_t nr_engines)
 
   for (uint32_t i = 0; i < nr_engines; i++)
     d->sync_ids[i] = 0;
+
+  for (uint32_t i = 0; i < nr_engines; i++)
+    d->known_done[i] = 0;
+}
+
+static int has_follower_of(ec_desc_t *d, uint32_t engine_id, uint32_t nr_engines)
+{
+  uint32_t nr_followers = nr_engines - 1;
+  for (uint32_t fi = 0; fi < nr_followers; fi++) {
+    ec_desc_t *f = d->followers[fi];
+    if (f == NULL)
+      break;
+    if (f->engine_id == engine_id)
+      return 1;
+  }
+
+  return 0;
 }
 
-static void add_follower(ec_desc_t *d, ec_desc_t *follower, uint32_t nr_engines)
+// Return 1 if follower becomes the earliest follower of its engine.
+static int add_follower(ec_desc_t *d, ec_desc_t *follower, uint32_t nr_engines)
 {
   if (d->engine_id == follower->engine_id)
-    return;
+    return 0;
 
   uint32_t nr_followers = nr_engines - 1;
   for (uint32_t fi = 0; fi < nr_followers; fi++) {
     ec_desc_t **f = &d->followers[fi];
     if ((*f) == NULL) {
       *f = follower;
-      return;
+      return 1;
     } else if ((*f)->engine_id == follower->engine_id) {
-      if ((*f) > follower)
+      if ((*f)->seq_no > follower->seq_no) {
         (*f) = follower;
-      return;
+        return 1;
+      }
+      return 0;
     }
   }
   ASSERT(0 && "desc->followers[] overflowed");
+  return 0;
 }
 
-static uint32_t assign_sync_ids(ec_desc_t desc[], uint32_t nr_desc, uint32_t nr_engines)
+static uint32_t assign_sync_ids(ec_t *ec, uint32_t start, uint32_t nr_desc)
 {
+  uint32_t nr_engines = ec->nr_engines;
   uint32_t ids[nr_engines];
   for (uint32_t i = 0; i < nr_engines; i++)
     ids[i] = 0;
 
   for (uint32_t di = 0; di < nr_desc; di++) {
-    ec_desc_t *d = &desc[di];
+    ec_desc_t *d = desc_at(ec, start + di);
     uint32_t ei = d->engine_id; // self engine id
 
     /*
@@ -88,19 +116,19 @@ static uint32_t assign_sync_ids(ec_desc_t desc[], uint32_t nr_desc, uint32_t nr_
   return nr_desc;
 }
 
-static void update_followers(ec_desc_t desc[], uint32_t nr_desc, uint32_t nr_engines)
+static void update_followers(ec_t *ec, uint32_t start, uint32_t nr_desc)
 {
   for (uint32_t i = 0; i < nr_desc; i++) {
-    ec_desc_t *d = &desc[i];
+    ec_desc_t *d = desc_at(ec, start + i);
 
-    uint32_t nr_followers = nr_engines - 1;
+    uint32_t nr_followers = ec->nr_engines - 1;
     for (uint32_t fi = 0; fi < nr_followers; fi++) {
       ec_desc_t *f = d->followers[fi];
       if (f == NULL)
         break;
 
       // Follower must after current descriptor and before last descriptor.
-      if (f >= desc && f < &desc[nr_desc]) {
+      if (f->seq_no >= start && f->seq_no < start + nr_desc) {
         // Assign self id to follower's wait id
         uint32_t ei = d->engine_id;
         f->sync_ids[ei] = d->sync_ids[ei];
@@ -143,12 +171,12 @@ static void update_followers(ec_desc_t desc[], uint32_t nr_desc, uint32_t nr_eng
 //     TDMA: [tdma_id=5|wait_tiu_id=1]
 //     TDMA: [tdma_id=6|wait_tiu_id=1]   => Reuse previous wait_tiu_id
 //
-static void update_tdma_wait_id(ec_desc_t desc[], uint32_t nr_desc)
+static void update_tdma_wait_id(ec_t *ec, uint32_t start, uint32_t nr_desc)
 {
   uint32_t prev_wait_tiu_id = 0;
 
   for (uint32_t i = 0; i < nr_desc; i++) {
-    ec_desc_t *d = &desc[i];
+    ec_desc_t *d = desc_at(ec, start + i);
     uint32_t ei = d->engine_id;
 
     // Only handle TDMA
@@ -166,65 +194,182 @@ static void update_tdma_wait_id(ec_desc_t desc[], uint32_t nr_desc)
 }
 #endif
 
-static void compute_sync_ids(ec_desc_t desc[], uint32_t nr_desc, uint32_t nr_engines)
+static void compute_sync_ids(ec_t *ec, uint32_t nr_desc)
 {
+  for (uint32_t i = 0; i < nr_desc; i++) {
+    ec_desc_t *d = desc_at(ec, i);
+    for (uint32_t ei = 0; ei < ec->nr_engines; ei++)
+      d->sync_ids[ei] = 0;
+  }
+
   uint32_t nr_done = 0;
   for (uint32_t i = 0; i < nr_desc; i += nr_done) {
     // Assign command id of each engine (TPU, TDMA)
-    nr_done = assign_sync_ids(&desc[i], nr_desc - i, nr_engines);
+    nr_done = assign_sync_ids(ec, i, nr_desc - i);
 
     // Update wait id (wait_tdma_id in TIU, wait_tpu_id in TDMA)
-    update_followers(&desc[i], nr_done, nr_engines);
+    update_followers(ec, i, nr_done);
 
 #ifdef ENABLE_UPDATE_TDMA_WAIT_ID
     // Update wait id (wait_tpu_id in TDMA)
-    update_tdma_wait_id(&desc[i], nr_done);
+    update_tdma_wait_id(ec, i, nr_done);
+#endif
+  }
+}
+
+// Incremental counterpart of update_tdma_wait_id(), run on the last
+// descriptor once no more dependency can be recorded for it.
+static void finalize_last_desc(ec_t *ec)
+{
+  if (ec->dirty || ec->nr_final == ec->cur_nr_desc)
+    return;
+
+  ec_desc_t *d = desc_at(ec, ec->cur_nr_desc - 1);
+
+#ifdef ENABLE_UPDATE_TDMA_WAIT_ID
+  if (d->engine_id == 2) {
+    if (!d->sync_ids[0] && ec->prev_wait_tiu_id)
+      d->sync_ids[0] = ec->prev_wait_tiu_id;
+
+    ec->prev_wait_tiu_id = d->sync_ids[0];
+  }
+#else
+  (void)d;
 #endif
+
+  ec->nr_final = ec->cur_nr_desc;
+}
+
+// Incremental counterpart of assign_sync_ids().
+static void assign_next_sync_id(ec_t *ec, ec_desc_t *d)
+{
+  if (ec->seg_wrap) {
+    for (uint32_t i = 0; i < ec->nr_engines; i++)
+      ec->ids[i] = 0;
+    ec->seg_start = d->seq_no;
+    ec->seg_wrap = 0;
+    ec->prev_wait_tiu_id = 0;
   }
+
+  uint32_t ei = d->engine_id;
+  d->sync_ids[ei] = ++ec->ids[ei];
+  if (ec->ids[ei] == 0xffff)
+    ec->seg_wrap = 1;
+}
+
+static void reset_sync_id_state(ec_t *ec)
+{
+  for (uint32_t i = 0; i < ec->nr_engines; i++)
+    ec->ids[i] = 0;
+
+  ec->seg_start = 0;
+  ec->seg_wrap = 0;
+  ec->prev_wait_tiu_id = 0;
+  ec->nr_final = 0;
+  ec->dirty = 0;
+
+  for (uint32_t i = 0; i < ec->nr_engines; i++)
+    ec->last_desc[i] = 0;
+  ec->nr_removed_waits = 0;
+}
+
+static void ec_add_block(ec_t *ec)
+{
+  uint32_t n = ec->block_nr_desc;
+  uint32_t nr_followers = ec->nr_engines - 1;
+
+  ec->blocks = realloc(ec->blocks, (ec->nr_blocks + 1) * sizeof(ec->blocks[0]));
+  ASSERT(ec->blocks);
+
+  ec_block_t *b = &ec->blocks[ec->nr_blocks++];
+  b->desc = xmalloc(n * sizeof(b->desc[0]));
+  b->follower_buf = xmalloc(n * nr_followers * sizeof(b->follower_buf[0]));
+  b->sync_id_buf = xmalloc(n * ec->nr_engines * sizeof(b->sync_id_buf[0]));
+  b->known_done_buf =
+      xmalloc(n * ec->nr_engines * sizeof(b->known_done_buf[0]));
+
+  ec->max_nr_desc += n;
 }
 
 void ec_init(ec_t *ec, uint32_t nr_engines, uint32_t max_nr_desc)
 {
   ec->nr_engines = nr_engines;
 
-  ec->max_nr_desc = max_nr_desc;
+  ec->max_nr_desc = 0;
   ec->cur_nr_desc = 0;
-  ec->desc = xmalloc(max_nr_desc * sizeof(ec->desc[0]));
 
-  uint32_t nr_followers = nr_engines - 1;
-  uint32_t total_followers = max_nr_desc * nr_followers;
-  uint32_t follower_buf_size = total_followers * sizeof(ec->follower_buf[0]);
-  ec->follower_buf = xmalloc(follower_buf_size);
+  ec->growable = 0;
+  ec->block_nr_desc = max_nr_desc;
+  ec->nr_blocks = 0;
+  ec->blocks = NULL;
+  ec_add_block(ec);
+
+  ec->ids = xmalloc(nr_engines * sizeof(ec->ids[0]));
+  ec->last_desc = xmalloc(nr_engines * sizeof(ec->last_desc[0]));
+  reset_sync_id_state(ec);
+}
+
+void ec_init_growable(ec_t *ec, uint32_t nr_engines, uint32_t block_nr_desc)
+{
+  ASSERT(block_nr_desc);
 
-  uint32_t total_sync_ids = max_nr_desc * nr_engines;
-  uint32_t sync_id_buf_size = total_sync_ids * sizeof(ec->sync_id_buf[0]);
-  ec->sync_id_buf = xmalloc(sync_id_buf_size);
+  ec_init(ec, nr_engines, block_nr_desc);
+  ec->growable = 1;
 }
 
 void ec_reset(ec_t *ec)
 {
   ec->cur_nr_desc = 0;
+  reset_sync_id_state(ec);
 }
 
 void ec_destroy(ec_t *ec)
 {
-  free(ec->desc);
-  free(ec->follower_buf);
-  free(ec->sync_id_buf);
+  for (uint32_t i = 0; i < ec->nr_blocks; i++) {
+    free(ec->blocks[i].desc);
+    free(ec->blocks[i].follower_buf);
+    free(ec->blocks[i].sync_id_buf);
+    free(ec->blocks[i].known_done_buf);
+  }
+  free(ec->blocks);
+  free(ec->ids);
+  free(ec->last_desc);
+  ec->blocks = NULL;
+  ec->ids = NULL;
+  ec->last_desc = NULL;
+  ec->nr_blocks = 0;
+  ec->max_nr_desc = 0;
 }
 
 ec_desc_t * ec_alloc_desc(ec_t *ec, uint32_t engine_id)
 {
   ASSERT(engine_id < ec->nr_engines);
+  if (ec->growable && ec->cur_nr_desc == ec->max_nr_desc)
+    ec_add_block(ec);
   ASSERT(ec->cur_nr_desc < ec->max_nr_desc);
 
+  finalize_last_desc(ec);
+
   uint32_t nr_followers = ec->nr_engines - 1;
   uint32_t i = ec->cur_nr_desc++;
-
-  ec_desc_t *d = &ec->desc[i];
-  d->followers = &ec->follower_buf[i * nr_followers];
-  d->sync_ids = &ec->sync_id_buf[i * ec->nr_engines];
+  uint32_t bi = i % ec->block_nr_desc;
+  ec_block_t *b = &ec->blocks[i / ec->block_nr_desc];
+
+  ec_desc_t *d = &b->desc[bi];
+  d->seq_no = i;
+  d->followers = &b->follower_buf[bi * nr_followers];
+  d->sync_ids = &b->sync_id_buf[bi * ec->nr_engines];
+  d->known_done = &b->known_done_buf[bi * ec->nr_engines];
   ec_desc_init(d, engine_id, ec->nr_engines);
+  assign_next_sync_id(ec, d);
+
+  // Starts after the previous descriptor of the same engine.
+  if (ec->last_desc[engine_id]) {
+    ec_desc_t *prev = desc_at(ec, ec->last_desc[engine_id] - 1);
+    for (uint32_t ei = 0; ei < ec->nr_engines; ei++)
+      d->known_done[ei] = prev->known_done[ei];
+  }
+  ec->last_desc[engine_id] = i + 1;
 
 #ifdef CVK_EC_DEBUG
   d->desc_offset = i;
@@ -238,18 +383,88 @@ ec_desc_t * ec_alloc_desc(ec_t *ec, uint32_t engine_id)
   return d;
 }
 
+ec_desc_t * ec_get_desc(ec_t *ec, uint32_t seq_no)
+{
+  ASSERT(seq_no < ec->cur_nr_desc);
+
+  return desc_at(ec, seq_no);
+}
+
+// Engines start their descriptors in order. If "after" already knows
+// "before" is done, through an earlier descriptor of its own engine or
+// through a descriptor of another engine it waits for, waiting for
+// "before" again only adds a barrier.
+static int is_implied(ec_desc_t *before, ec_desc_t *after)
+{
+  if (before->engine_id == after->engine_id)
+    return 1;
+
+  return after->known_done[before->engine_id] > before->seq_no;
+}
+
+// "after" waits for "before", so does whatever "before" waited for.
+static void learn_done(ec_t *ec, ec_desc_t *before, ec_desc_t *after)
+{
+  for (uint32_t ei = 0; ei < ec->nr_engines; ei++) {
+    if (after->known_done[ei] < before->known_done[ei])
+      after->known_done[ei] = before->known_done[ei];
+  }
+
+  uint32_t ej = before->engine_id;
+  if (after->known_done[ej] < before->seq_no + 1)
+    after->known_done[ej] = before->seq_no + 1;
+}
+
 void ec_add_dependency(ec_t *ec, ec_desc_t *before, ec_desc_t *after)
 {
-  ec_desc_t *start = ec->desc;
-  ec_desc_t *end = &ec->desc[ec->cur_nr_desc];
+  ASSERT(before->seq_no < ec->cur_nr_desc);
+  ASSERT(after->seq_no < ec->cur_nr_desc);
+  ASSERT(desc_at(ec, before->seq_no) == before);
+  ASSERT(desc_at(ec, after->seq_no) == after);
+
+  // Only the last, not yet final descriptor can be updated in place.
+  if (after->seq_no + 1 != ec->cur_nr_desc || after->seq_no < ec->nr_final)
+    ec->dirty = 1;
+
+  if (!ec->dirty && is_implied(before, after)) {
+    if (before->seq_no >= ec->seg_start &&
+        before->engine_id != after->engine_id &&
+        !has_follower_of(before, after->engine_id, ec->nr_engines))
+      ec->nr_removed_waits++;
+    return;
+  }
+
+  if (!add_follower(before, after, ec->nr_engines) || ec->dirty)
+    return;
 
-  ASSERT(before >= start && before < end);
-  ASSERT(after  >= start && after  < end);
+  // Incremental counterpart of update_followers().
+  // Waits on descriptors of previous segments are dropped.
+  if (before->seq_no >= ec->seg_start) {
+    uint32_t ei = before->engine_id;
+    if (after->sync_ids[ei] < before->sync_ids[ei])
+      after->sync_ids[ei] = before->sync_ids[ei];
 
-  add_follower(before, after, ec->nr_engines);
+    learn_done(ec, before, after);
+  }
 }
 
 void ec_compute_sync_ids(ec_t *ec)
 {
-  compute_sync_ids(ec->desc, ec->cur_nr_desc, ec->nr_engines);
+#ifdef CVK_EC_DEBUG
+  printf("ec: %u descriptors, %u redundant waits removed\n",
+         ec->cur_nr_desc, ec->nr_removed_waits);
+#endif
+
+  if (ec->dirty) {
+    compute_sync_ids(ec, ec->cur_nr_desc);
+    ec->nr_final = ec->cur_nr_desc;
+    return;
+  }
+
+  finalize_last_desc(ec);
+}
+
+uint32_t ec_get_nr_removed_waits(ec_t *ec)
+{
+  return ec->nr_removed_waits;
 }
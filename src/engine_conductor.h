@@ -9,9 +9,14 @@
 
 typedef struct ec_desc {
   uint32_t engine_id;
+  uint32_t seq_no;  // allocation order, descriptors may live in different blocks
   struct ec_desc **followers;
   uint16_t *sync_ids;
 
+  // known_done[ej]: descriptors of engine ej before seq_no known_done[ej]
+  // are done whenever this descriptor starts.
+  uint32_t *known_done;
+
 #ifdef CVK_EC_DEBUG
   // desc, follower and sync_ids are pointers.
   // It is easier to debug from address offset instead of pointers.
@@ -22,24 +27,57 @@ typedef struct ec_desc {
 
 } ec_desc_t;
 
+typedef struct {
+  ec_desc_t *desc;
+  ec_desc_t **follower_buf;
+  uint16_t *sync_id_buf;
+  uint32_t *known_done_buf;
+} ec_block_t;
+
+// Descriptors are allocated in fixed-size blocks so that ec_desc_t pointers
+// held by followers and engine states stay valid when the conductor grows.
+// A fixed-size conductor has exactly one block of max_nr_desc descriptors.
 typedef struct {
   uint32_t nr_engines;
 
   uint32_t max_nr_desc;
   uint32_t cur_nr_desc;
-  ec_desc_t *desc;
 
-  ec_desc_t **follower_buf;
-  uint16_t *sync_id_buf;
+  uint32_t growable;
+  uint32_t block_nr_desc;
+  uint32_t nr_blocks;
+  ec_block_t *blocks;
+
+  // Incremental sync id assignment.
+  // Sync ids are assigned as descriptors are allocated and dependencies
+  // recorded. A descriptor is final once the next one is allocated.
+  // A dependency recorded out of allocation order sets dirty and
+  // ec_compute_sync_ids() falls back to a full pass until ec_reset().
+  uint32_t *ids;              // last sync id of each engine in segment
+  uint32_t seg_start;         // first descriptor of current 0xffff segment
+  uint32_t seg_wrap;          // current segment is full
+  uint32_t prev_wait_tiu_id;  // see update_tdma_wait_id()
+  uint32_t nr_final;          // descriptors with final sync ids
+  uint32_t dirty;
+
+  // Transitive reduction.
+  // A dependency already implied by the in-order execution of engines and
+  // the dependencies recorded before it is not added to the graph.
+  // Only done while dependencies are recorded in order (!dirty).
+  uint32_t *last_desc;        // 1 + seq_no of last descriptor of each engine
+  uint32_t nr_removed_waits;  // waits dropped since ec_reset()
 } ec_t;
 
 void ec_init(ec_t *ec, uint32_t nr_engines, uint32_t max_nr_desc);
+void ec_init_growable(ec_t *ec, uint32_t nr_engines, uint32_t block_nr_desc);
 void ec_reset(ec_t *ec);
 void ec_destroy(ec_t *ec);
 
 ec_desc_t * ec_alloc_desc(ec_t *ec, uint32_t engine_id);
+ec_desc_t * ec_get_desc(ec_t *ec, uint32_t seq_no);
 
 void ec_add_dependency(ec_t *ec, ec_desc_t *before, ec_desc_t *after);
 void ec_compute_sync_ids(ec_t *ec);
+uint32_t ec_get_nr_removed_waits(ec_t *ec);
 
 #endif /* ENGINE_CONDUCTOR_H */
@@ -0,0 +1,531 @@
+#include <string.h>
+#include "gemm_tiled.h"
+#include "tile_pipeline.h"
+#include "tile_tune.h"
+
+//
+// Tiles are walked with m outermost, then n and k. The k tiles of one
+// output tile accumulate into the same partial sum matrix: the first pass
+// starts it (ps32_mode 2), middle passes add to it (3) and the last one
+// adds the bias, shifts, applies relu and writes the result (1). With a
+// single k tile the left tile only changes with m and is loaded once per
+// row of output tiles.
+//
+// TIU matrix shape fields are 12 bits, tiles are split to stay within.
+//
+#define GEMM_MAX_DIM    4095
+
+enum { DIM_M, DIM_K, DIM_N, NR_DIMS };
+
+typedef struct {
+  const cvk_gemm_tiled_param_t *p;
+  cvk_fmt_t fmt;
+  uint32_t fmt_size;
+
+  uint32_t dim[NR_DIMS];
+  uint32_t align[NR_DIMS];
+  uint32_t nr[NR_DIMS];
+  uint32_t step[NR_DIMS];
+  uint32_t lmem_free;           // for the buffers, see tile_lmem_free
+  cvk_gemm_tiling_t t;
+
+  cvk_ml_t *left[2];
+  cvk_ml_t *right[2];
+  cvk_ml_t *bias[2];
+  cvk_ml_t *res[2];
+} gemm_tiled_t;
+
+typedef struct {
+  uint32_t m, k, n;             // start
+  uint32_t mn, kn, nn;          // length
+  uint32_t m_idx, k_idx, n_idx;
+  uint32_t out_idx;             // output tile
+} gemm_tile_t;
+
+static uint32_t ceil_div(uint32_t a, uint32_t b)
+{
+  return (a + b - 1) / b;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+  return (a < b) ? a : b;
+}
+
+static uint32_t tiling_lmem_size(
+    cvk_context_t *ctx, const gemm_tiled_t *g, const uint32_t nr[NR_DIMS])
+{
+  cvk_fmt_t fmt = g->fmt;
+  uint32_t m = tile_step(g->dim[DIM_M], g->align[DIM_M], nr[DIM_M]);
+  uint32_t k = tile_step(g->dim[DIM_K], g->align[DIM_K], nr[DIM_K]);
+  uint32_t n = tile_step(g->dim[DIM_N], g->align[DIM_N], nr[DIM_N]);
+  uint32_t size = 0;
+
+  size += 2 * ctx->ops->lmem_matrix_to_size(
+      ctx, ctx->ops->ml_default_shape(ctx, m, k, fmt), fmt, 1);
+  size += 2 * ctx->ops->lmem_matrix_to_size(
+      ctx, ctx->ops->ml_default_shape(ctx, k, n, fmt), fmt, 1);
+  size += 2 * ctx->ops->lmem_ps32_matrix_to_size(
+      ctx, ctx->ops->ml_default_shape(ctx, m, n, fmt), fmt, 1);
+  if (g->p->bias)
+    size += 2 * ctx->ops->lmem_matrix_to_size(
+        ctx, ctx->ops->ml_default_shape(ctx, 2, n, fmt), fmt, 1);
+
+  return size;
+}
+
+static void free_buffers(cvk_context_t *ctx, gemm_tiled_t *g)
+{
+  cvk_ml_t **bufs[] = {g->res, g->bias, g->right, g->left};
+
+  for (uint32_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+    for (int j = 1; j >= 0; j--) {
+      if (bufs[i][j])
+        ctx->ops->lmem_free_matrix(ctx, bufs[i][j]);
+      bufs[i][j] = NULL;
+    }
+  }
+}
+
+static int alloc_buffers(cvk_context_t *ctx, gemm_tiled_t *g)
+{
+  cvk_fmt_t fmt = g->fmt;
+  uint32_t m = g->step[DIM_M], k = g->step[DIM_K], n = g->step[DIM_N];
+
+  for (uint32_t i = 0; i < 2; i++) {
+    g->res[i] = ctx->ops->lmem_alloc_ps32_matrix(
+        ctx, ctx->ops->ml_default_shape(ctx, m, n, fmt), fmt, 1);
+    g->left[i] = ctx->ops->lmem_alloc_matrix(
+        ctx, ctx->ops->ml_default_shape(ctx, m, k, fmt), fmt, 1);
+    g->right[i] = ctx->ops->lmem_alloc_matrix(
+        ctx, ctx->ops->ml_default_shape(ctx, k, n, fmt), fmt, 1);
+    if (g->p->bias)
+      g->bias[i] = ctx->ops->lmem_alloc_matrix(
+          ctx, ctx->ops->ml_default_shape(ctx, 2, n, fmt), fmt, 1);
+
+    if (!g->res[i] || !g->left[i] || !g->right[i] ||
+        (g->p->bias && !g->bias[i])) {
+      free_buffers(ctx, g);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static void set_steps(gemm_tiled_t *g)
+{
+  for (uint32_t d = 0; d < NR_DIMS; d++) {
+    g->step[d] = tile_step(g->dim[d], g->align[d], g->nr[d]);
+    g->nr[d] = ceil_div(g->dim[d], g->step[d]);
+  }
+
+  g->t.m_step = g->step[DIM_M];
+  g->t.k_step = g->step[DIM_K];
+  g->t.n_step = g->step[DIM_N];
+  g->t.nr_tiles = g->nr[DIM_M] * g->nr[DIM_K] * g->nr[DIM_N];
+}
+
+// Columns of a matrix laid out as by ml_default_shape within the TIU
+// fields.
+static int cols_in_range(cvk_context_t *ctx, uint32_t col, cvk_fmt_t fmt)
+{
+  cvk_ml_shape_t s = ctx->ops->ml_default_shape(ctx, 1, col, fmt);
+  return s.c <= GEMM_MAX_DIM && s.w <= GEMM_MAX_DIM;
+}
+
+static int steps_in_range(cvk_context_t *ctx, const gemm_tiled_t *g)
+{
+  return g->step[DIM_M] <= GEMM_MAX_DIM && g->step[DIM_K] <= GEMM_MAX_DIM &&
+         cols_in_range(ctx, g->step[DIM_K], g->fmt) &&
+         cols_in_range(ctx, g->step[DIM_N], g->fmt);
+}
+
+static tile_cost_t tiling_cost(cvk_context_t *ctx, const gemm_tiled_t *g)
+{
+  uint64_t m = g->dim[DIM_M], k = g->dim[DIM_K], n = g->dim[DIM_N];
+  uint32_t nr_out = g->nr[DIM_M] * g->nr[DIM_N];
+  uint32_t eu_num = ctx->info.eu_num;
+  tile_cost_t cost;
+
+  memset(&cost, 0, sizeof(cost));
+  cost.nr_tiles = g->t.nr_tiles;
+
+  // Left tiles are loaded once per row of output tiles unless k is split,
+  // right tiles for every tile.
+  if (g->nr[DIM_K] > 1) {
+    cost.load_bytes = g->nr[DIM_N] * m * k;
+    cost.nr_loads = g->t.nr_tiles;
+  } else {
+    cost.load_bytes = m * k;
+    cost.nr_loads = g->nr[DIM_M];
+  }
+  cost.load_bytes += g->nr[DIM_M] * k * n;
+  cost.nr_loads += g->t.nr_tiles;
+  if (g->p->bias) {
+    cost.load_bytes += g->nr[DIM_M] * 2 * n;
+    cost.nr_loads += nr_out;
+  }
+  cost.load_bytes *= g->fmt_size;
+
+  cost.store_bytes = m * n * g->fmt_size;
+  cost.nr_stores = nr_out;
+
+  // Result rows spread over the lanes eu_num columns at a time.
+  cost.tiu_cycles = (uint64_t)g->t.nr_tiles *
+                    tile_tiu_cycles(&ctx->info, g->step[DIM_M],
+                                    (g->step[DIM_N] + eu_num - 1) / eu_num,
+                                    eu_num, g->step[DIM_K]);
+  cost.nr_tius = g->t.nr_tiles;
+  return cost;
+}
+
+// Tuner dimensions, m, k and n after one of a single tile.
+static void set_nr(gemm_tiled_t *g, const uint32_t *nr)
+{
+  g->nr[DIM_M] = nr[1];
+  g->nr[DIM_K] = nr[2];
+  g->nr[DIM_N] = nr[3];
+  set_steps(g);
+}
+
+static int tune_fits(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  gemm_tiled_t *g = arg;
+  set_nr(g, nr);
+  return steps_in_range(ctx, g) &&
+         tiling_lmem_size(ctx, g, g->nr) <= g->lmem_free;
+}
+
+static uint64_t tune_cycles(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  gemm_tiled_t *g = arg;
+  set_nr(g, nr);
+
+  tile_cost_t cost = tiling_cost(ctx, g);
+  return tile_cost_cycles(&cost);
+}
+
+static int tune_alloc(cvk_context_t *ctx, void *arg, const uint32_t *nr)
+{
+  gemm_tiled_t *g = arg;
+  set_nr(g, nr);
+  if (alloc_buffers(ctx, g))
+    return -1;
+
+  g->t.lmem_size = tiling_lmem_size(ctx, g, g->nr);
+  return 0;
+}
+
+// Split of the fewest estimated cycles, see tile_tune. Whether k is split
+// decides if partial sums are used.
+static int tune_tiling(cvk_context_t *ctx, gemm_tiled_t *g)
+{
+  const cvk_gemm_tiled_param_t *p = g->p;
+  tile_tuner_t tu = {
+      {1, g->dim[DIM_M], g->dim[DIM_K], g->dim[DIM_N]},
+      {1, g->align[DIM_M], g->align[DIM_K], g->align[DIM_N]},
+      tune_fits, tune_cycles, tune_alloc};
+  uint32_t words[] = {
+      'G', ctx->info.npu_num, ctx->info.eu_num, ctx->info.lmem_size,
+      g->fmt, g->dim[DIM_M], g->dim[DIM_K], g->dim[DIM_N], !!p->bias};
+
+  return tile_tune(ctx, &tu, g, p->cache,
+                   tile_cache_key(words, sizeof(words) / sizeof(words[0])));
+}
+
+// Split m, k and n until every tile shape fits the TIU fields, then until
+// the buffers fit in the local memory left free, each time splitting the
+// dimension that saves the most per tile it adds, n before m before k on
+// ties since k splits add partial sum passes. n steps stay at least a row
+// of lanes, npu_num * eu_num columns, as long as another split still
+// saves: narrower tiles leave lanes idle and multiply the tiles. With autotune
+// the split estimated fastest instead, the greedy one if none fits.
+static int choose_tiling(cvk_context_t *ctx, gemm_tiled_t *g)
+{
+  static const uint32_t order[] = {DIM_N, DIM_M, DIM_K};
+  uint32_t min_step = ctx->info.npu_num * ctx->info.eu_num;
+
+  g->lmem_free = tile_lmem_free(ctx);
+  if (g->p->autotune && !tune_tiling(ctx, g))
+    return 0;
+
+  for (uint32_t d = 0; d < NR_DIMS; d++)
+    g->nr[d] = 1;
+
+  for (;;) {
+    set_steps(g);
+
+    int split = -1;
+    if (g->step[DIM_M] > GEMM_MAX_DIM)
+      split = DIM_M;
+    else if (g->step[DIM_K] > GEMM_MAX_DIM ||
+             !cols_in_range(ctx, g->step[DIM_K], g->fmt))
+      split = DIM_K;
+    else if (!cols_in_range(ctx, g->step[DIM_N], g->fmt))
+      split = DIM_N;
+    if (split >= 0) {
+      if (!tile_split_more(g->dim[split], g->align[split], &g->nr[split]))
+        return -1;
+      continue;
+    }
+
+    uint32_t size = tiling_lmem_size(ctx, g, g->nr);
+    if (size <= g->lmem_free && !alloc_buffers(ctx, g)) {
+      g->t.lmem_size = size;
+      return 0;
+    }
+
+    int best = -1, best_pref = 0;
+    uint32_t best_nr = 0;
+    uint64_t best_saved = 0, best_added = 1;
+    for (uint32_t i = 0; i < NR_DIMS; i++) {
+      uint32_t d = order[i];
+      uint32_t nr[NR_DIMS] = {g->nr[0], g->nr[1], g->nr[2]};
+      if (!tile_split_more(g->dim[d], g->align[d], &nr[d]))
+        continue;
+
+      uint32_t s = tiling_lmem_size(ctx, g, nr);
+      int pref = s < size &&
+                 (d != DIM_N ||
+                  tile_step(g->dim[d], g->align[d], nr[d]) >= min_step);
+      uint64_t saved = (s < size) ? size - s : 0;
+      uint64_t added = (uint64_t)g->t.nr_tiles / g->nr[d] * (nr[d] - g->nr[d]);
+      if (best < 0 || pref > best_pref ||
+          (pref == best_pref && saved * best_added > best_saved * added)) {
+        best = d;
+        best_pref = pref;
+        best_nr = nr[d];
+        best_saved = saved;
+        best_added = added;
+      }
+    }
+
+    if (best < 0)
+      return -1;
+    g->nr[best] = best_nr;
+  }
+}
+
+static void get_tile(const gemm_tiled_t *g, uint32_t i, gemm_tile_t *tile)
+{
+  tile->k_idx = i % g->nr[DIM_K];
+  tile->out_idx = i / g->nr[DIM_K];
+  tile->n_idx = tile->out_idx % g->nr[DIM_N];
+  tile->m_idx = tile->out_idx / g->nr[DIM_N];
+
+  tile->m = tile->m_idx * g->step[DIM_M];
+  tile->k = tile->k_idx * g->step[DIM_K];
+  tile->n = tile->n_idx * g->step[DIM_N];
+  tile->mn = min_u32(g->step[DIM_M], g->dim[DIM_M] - tile->m);
+  tile->kn = min_u32(g->step[DIM_K], g->dim[DIM_K] - tile->k);
+  tile->nn = min_u32(g->step[DIM_N], g->dim[DIM_N] - tile->n);
+}
+
+static uint32_t left_slot(const gemm_tiled_t *g, const gemm_tile_t *tile,
+                          uint32_t buf)
+{
+  return (g->nr[DIM_K] > 1) ? buf : tile->m_idx % 2;
+}
+
+static cvk_ml_t ml_view(
+    cvk_context_t *ctx, const cvk_ml_t *buf, uint32_t row, uint32_t col)
+{
+  cvk_ml_t m = *buf;
+  m.shape = ctx->ops->ml_default_shape(ctx, row, col, m.fmt);
+  m.stride = ctx->ops->ml_default_stride(ctx, m.shape, m.fmt, 1);
+  return m;
+}
+
+static cvk_mg_t mg_view(
+    const gemm_tiled_t *g, const cvk_mg_t *mg, uint32_t row, uint32_t col,
+    uint32_t rows, uint32_t cols)
+{
+  cvk_mg_t m = *mg;
+  m.start_address += (uint64_t)row * mg->stride.row +
+                     (uint64_t)col * g->fmt_size;
+  m.shape.row = rows;
+  m.shape.col = cols;
+  return m;
+}
+
+static void load(cvk_context_t *ctx, const gemm_tiled_t *g,
+                 const cvk_mg_t *src, const cvk_ml_t *dst)
+{
+  cvk_tdma_g2l_matrix_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = src;
+  param.dst = dst;
+  param.layer_id = g->p->layer_id;
+
+  if (g->fmt == CVK_FMT_BF16)
+    ctx->ops->tdma_g2l_bf16_matrix_copy(ctx, &param);
+  else
+    ctx->ops->tdma_g2l_matrix_copy(ctx, &param);
+}
+
+static void gemm_load(cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const gemm_tiled_t *g = arg;
+  const cvk_gemm_tiled_param_t *p = g->p;
+  gemm_tile_t tile;
+
+  get_tile(g, i, &tile);
+
+  if (g->nr[DIM_K] > 1 || tile.n_idx == 0) {
+    cvk_mg_t src = mg_view(g, p->left, tile.m, tile.k, tile.mn, tile.kn);
+    cvk_ml_t dst = ml_view(ctx, g->left[left_slot(g, &tile, buf)],
+                           tile.mn, tile.kn);
+    load(ctx, g, &src, &dst);
+  }
+
+  cvk_mg_t src = mg_view(g, p->right, tile.k, tile.n, tile.kn, tile.nn);
+  cvk_ml_t dst = ml_view(ctx, g->right[buf], tile.kn, tile.nn);
+  load(ctx, g, &src, &dst);
+
+  if (p->bias && tile.k_idx == 0) {
+    cvk_mg_t src = mg_view(g, p->bias, 0, tile.n, 2, tile.nn);
+    cvk_ml_t dst = ml_view(ctx, g->bias[tile.out_idx % 2], 2, tile.nn);
+    load(ctx, g, &src, &dst);
+  }
+}
+
+static void gemm_compute(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const gemm_tiled_t *g = arg;
+  const cvk_gemm_tiled_param_t *p = g->p;
+  uint32_t nr_k = g->nr[DIM_K];
+  gemm_tile_t tile;
+
+  get_tile(g, i, &tile);
+  int last = (tile.k_idx == nr_k - 1);
+
+  cvk_ml_t left = ml_view(ctx, g->left[left_slot(g, &tile, buf)],
+                          tile.mn, tile.kn);
+  cvk_ml_t right = ml_view(ctx, g->right[buf], tile.kn, tile.nn);
+  cvk_ml_t res = ml_view(ctx, g->res[tile.out_idx % 2], tile.mn, tile.nn);
+  cvk_ml_t bias;
+
+  cvk_tiu_matrix_multiplication_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.res = &res;
+  param.left = &left;
+  param.right = &right;
+  param.res_is_int8 = 1;
+  param.layer_id = p->layer_id;
+
+  if (nr_k == 1)
+    param.ps32_mode = 0;
+  else if (tile.k_idx == 0)
+    param.ps32_mode = 2;
+  else if (!last)
+    param.ps32_mode = 3;
+  else
+    param.ps32_mode = 1;
+
+  if (last) {
+    if (p->bias) {
+      bias = ml_view(ctx, g->bias[tile.out_idx % 2], 2, tile.nn);
+      param.bias = &bias;
+    }
+    param.rshift_bits = p->rshift_bits;
+    param.relu_enable = p->relu_enable;
+  }
+
+  ctx->ops->tiu_matrix_multiplication(ctx, &param);
+}
+
+static void gemm_store(
+    cvk_context_t *ctx, void *arg, uint32_t i, uint32_t buf)
+{
+  const gemm_tiled_t *g = arg;
+  const cvk_gemm_tiled_param_t *p = g->p;
+  gemm_tile_t tile;
+
+  (void)buf;
+  get_tile(g, i, &tile);
+  if (tile.k_idx != g->nr[DIM_K] - 1)
+    return;
+
+  cvk_ml_t src = ml_view(ctx, g->res[tile.out_idx % 2], tile.mn, tile.nn);
+  cvk_mg_t dst = mg_view(g, p->res, tile.m, tile.n, tile.mn, tile.nn);
+
+  cvk_tdma_l2g_matrix_copy_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.src = &src;
+  param.dst = &dst;
+  param.layer_id = p->layer_id;
+
+  if (g->fmt == CVK_FMT_BF16)
+    ctx->ops->tdma_l2g_bf16_matrix_copy(ctx, &param);
+  else
+    ctx->ops->tdma_l2g_matrix_copy(ctx, &param);
+}
+
+static int check_param(const cvk_gemm_tiled_param_t *p)
+{
+  if (!p || !p->left || !p->right || !p->res)
+    return -1;
+
+  int bf16 = (p->left->fmt == CVK_FMT_BF16);
+  if ((p->right->fmt == CVK_FMT_BF16) != bf16 ||
+      (p->res->fmt == CVK_FMT_BF16) != bf16 ||
+      (p->bias && (p->bias->fmt == CVK_FMT_BF16) != bf16))
+    return -1;
+  if (bf16 && p->rshift_bits)
+    return -1;
+
+  const cvk_mg_shape_t *l = &p->left->shape;
+  const cvk_mg_shape_t *r = &p->right->shape;
+  const cvk_mg_shape_t *o = &p->res->shape;
+
+  if (!l->row || !l->col || !r->col)
+    return -1;
+  if (r->row != l->col || o->row != l->row || o->col != r->col)
+    return -1;
+  if (p->bias && (p->bias->shape.row != 2 || p->bias->shape.col != r->col))
+    return -1;
+
+  return 0;
+}
+
+int cvk_gemm_tiled(
+    cvk_context_t *ctx,
+    const cvk_gemm_tiled_param_t *p,
+    cvk_gemm_tiling_t *tiling)
+{
+  gemm_tiled_t g;
+
+  if (tiling)
+    memset(tiling, 0, sizeof(*tiling));
+  if (check_param(p))
+    return -1;
+
+  memset(&g, 0, sizeof(g));
+  g.p = p;
+  g.fmt = p->left->fmt;
+  g.fmt_size = (g.fmt == CVK_FMT_BF16) ? 2 : 1;
+  g.dim[DIM_M] = p->left->shape.row;
+  g.dim[DIM_K] = p->left->shape.col;
+  g.dim[DIM_N] = p->right->shape.col;
+  g.align[DIM_M] = 1;
+  g.align[DIM_K] = ctx->info.eu_num;
+  g.align[DIM_N] = ctx->info.eu_num;
+
+  if (choose_tiling(ctx, &g))
+    return -1;
+
+  tile_cost_t cost = tiling_cost(ctx, &g);
+  g.t.cycles = tile_cost_cycles(&cost);
+
+  static const tile_pipeline_t pl = {
+      gemm_load, gemm_compute, gemm_store, 2};
+  int ret = tile_pipeline_run(ctx, &pl, &g, g.t.nr_tiles);
+
+  free_buffers(ctx, &g);
+
+  if (tiling)
+    *tiling = g.t;
+  return ret;
+}
@@ -0,0 +1,13 @@
+#ifndef CVIKERNEL_GEMM_TILED_H
+#define CVIKERNEL_GEMM_TILED_H
+
+#include <cvikernel/cvikernel.h>
+
+// Matrix multiplication of global memory matrices tiled over local memory,
+// shared by the chip backends, see gemm_tiled in cvk_misc_operations_t.
+int cvk_gemm_tiled(
+    cvk_context_t *ctx,
+    const cvk_gemm_tiled_param_t *p,
+    cvk_gemm_tiling_t *tiling);
+
+#endif /* CVIKERNEL_GEMM_TILED_H */
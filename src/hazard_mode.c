@@ -0,0 +1,139 @@
+#include "kernel_internal.h"
+
+void hazard_mode_init(hazard_mode_t *m, engine_state_t *es, ec_t *ec)
+{
+  // Descriptors recorded before hazard mode have no ranges, every one of
+  // them is a barrier for the other engines.
+  engine_state_copy(&m->engine_state, es);
+  m->ec = ec;
+
+  m->nr_entries = 0;
+  m->entries = xmalloc(HAZARD_MODE_MAX_ENTRIES * sizeof(m->entries[0]));
+
+  uint32_t nr_engines = es->nr_engines;
+  m->synced = xmalloc(nr_engines * nr_engines * sizeof(m->synced[0]));
+  for (uint32_t i = 0; i < nr_engines * nr_engines; i++)
+    m->synced[i] = 0;
+}
+
+static int is_hazard(const mem_range_t *a, const mem_range_t *b)
+{
+  if (a->mem != b->mem)
+    return 0;
+  if (!a->is_write && !b->is_write)
+    return 0;
+
+  return a->start < b->end && b->start < a->end;
+}
+
+static ec_desc_t *later_desc(ec_desc_t *a, ec_desc_t *b)
+{
+  if (!a)
+    return b;
+  if (!b)
+    return a;
+
+  return (a->seq_no > b->seq_no) ? a : b;
+}
+
+// A range can still cause a hazard only if some other engine has not
+// waited for its descriptor yet. The cpu engine records no descriptors
+// and never waits, it must not keep ranges alive.
+static int is_live(hazard_mode_t *m, const hazard_entry_t *e)
+{
+  uint32_t nr_engines = m->engine_state.nr_engines;
+  uint32_t ej = e->desc->engine_id;
+
+  for (uint32_t ei = 0; ei < nr_engines; ei++) {
+    if (ei == ej || ei == CVI_TPU_CPU)
+      continue;
+    if (m->synced[ei * nr_engines + ej] <= e->desc->seq_no)
+      return 1;
+  }
+
+  return 0;
+}
+
+static void drop_oldest_entry(hazard_mode_t *m)
+{
+  hazard_entry_t *e = &m->entries[0];
+  ec_desc_t **last = &m->engine_state.last_desc[e->desc->engine_id];
+
+  *last = later_desc(*last, e->desc);
+
+  m->nr_entries--;
+  memmove(&m->entries[0], &m->entries[1],
+          m->nr_entries * sizeof(m->entries[0]));
+}
+
+void hazard_mode_record_ranges(
+    hazard_mode_t *m,
+    ec_desc_t *d,
+    const mem_range_t *ranges,
+    uint32_t nr_ranges)
+{
+  uint32_t nr_engines = m->engine_state.nr_engines;
+  ec_desc_t *wait[nr_engines];
+
+  for (uint32_t ei = 0; ei < nr_engines; ei++)
+    wait[ei] = NULL;
+
+  // Find the latest conflicting descriptor of each other engine and
+  // compact away ranges that are no longer live.
+  uint32_t nr_live = 0;
+  for (uint32_t i = 0; i < m->nr_entries; i++) {
+    hazard_entry_t *e = &m->entries[i];
+    if (!is_live(m, e))
+      continue;
+
+    uint32_t ej = e->desc->engine_id;
+    if (ej != d->engine_id) {
+      for (uint32_t ri = 0; ri < nr_ranges; ri++) {
+        if (is_hazard(&e->range, &ranges[ri])) {
+          wait[ej] = later_desc(wait[ej], e->desc);
+          break;
+        }
+      }
+    }
+
+    m->entries[nr_live++] = *e;
+  }
+  m->nr_entries = nr_live;
+
+  for (uint32_t ej = 0; ej < nr_engines; ej++) {
+    if (ej == d->engine_id)
+      continue;
+
+    // Waiting for a later descriptor also covers the dropped ones.
+    ec_desc_t *before = wait[ej] ? wait[ej] : m->engine_state.last_desc[ej];
+    if (!before)
+      continue;
+
+    uint32_t *synced = &m->synced[d->engine_id * nr_engines + ej];
+    if (*synced > before->seq_no)
+      continue;
+
+    ec_add_dependency(m->ec, before, d);
+    *synced = before->seq_no + 1;
+  }
+
+  for (uint32_t ri = 0; ri < nr_ranges; ri++) {
+    if (m->nr_entries == HAZARD_MODE_MAX_ENTRIES)
+      drop_oldest_entry(m);
+
+    hazard_entry_t *e = &m->entries[m->nr_entries++];
+    e->desc = d;
+    e->range = ranges[ri];
+  }
+}
+
+void hazard_mode_destroy(hazard_mode_t *m)
+{
+  engine_state_destroy(&m->engine_state);
+
+  free(m->entries);
+  free(m->synced);
+  m->entries = NULL;
+  m->synced = NULL;
+  m->nr_entries = 0;
+}
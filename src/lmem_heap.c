@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lmem_heap.h"
+
+void lmem_heap_init(
+    lmem_heap_t *heap, uint32_t size, uint32_t nr_banks, uint32_t bank_size,
+    uint32_t align)
+{
+  heap->size = size;
+  heap->nr_banks = nr_banks ? nr_banks : 1;
+  heap->bank_size = bank_size ? bank_size : size;
+  heap->align = align ? align : 1;
+
+  heap->nr_blocks = 0;
+  heap->max_nr_blocks = 0;
+  heap->blocks = NULL;
+
+  heap->high_water = 0;
+}
+
+void lmem_heap_destroy(lmem_heap_t *heap)
+{
+  free(heap->blocks);
+  heap->blocks = NULL;
+  heap->nr_blocks = 0;
+  heap->max_nr_blocks = 0;
+  heap->high_water = 0;
+}
+
+static uint32_t align_start(const lmem_heap_t *heap, uint32_t addr)
+{
+  uint32_t align = heap->align;
+  return ((uint64_t)addr + align - 1) / align * align;
+}
+
+// Index of the first block starting at or after addr.
+static uint32_t lower_bound(const lmem_heap_t *heap, uint32_t addr)
+{
+  uint32_t lo = 0, hi = heap->nr_blocks;
+
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (heap->blocks[mid].start < addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static int reserve_block(lmem_heap_t *heap)
+{
+  if (heap->nr_blocks < heap->max_nr_blocks)
+    return 0;
+
+  uint32_t max_nr = heap->max_nr_blocks ? heap->max_nr_blocks * 2 : 32;
+  lmem_block_t *blocks = realloc(heap->blocks, max_nr * sizeof(*blocks));
+  if (!blocks)
+    return -1;
+
+  heap->blocks = blocks;
+  heap->max_nr_blocks = max_nr;
+  return 0;
+}
+
+uint32_t lmem_heap_alloc(lmem_heap_t *heap, int bank_id, uint32_t size)
+{
+  uint32_t lo = 0, hi = heap->size;
+
+  if (!size)
+    return LMEM_HEAP_INVALID;
+
+  if (bank_id != LMEM_HEAP_ANY_BANK) {
+    if (bank_id < 0 || (uint32_t)bank_id >= heap->nr_banks)
+      return LMEM_HEAP_INVALID;
+
+    lo = bank_id * heap->bank_size;
+    hi = lo + heap->bank_size;
+    if (hi > heap->size)
+      hi = heap->size;
+  }
+
+  if (reserve_block(heap))
+    return LMEM_HEAP_INVALID;
+
+  // Walk the holes overlapping [lo, hi), the one before each block and the
+  // one after the last block.
+  uint32_t best = LMEM_HEAP_INVALID, best_hole = 0, best_idx = 0;
+  uint32_t i = lower_bound(heap, lo);
+  uint32_t hole_start = lo;
+
+  if (i && heap->blocks[i - 1].start + heap->blocks[i - 1].size > lo)
+    hole_start = heap->blocks[i - 1].start + heap->blocks[i - 1].size;
+
+  for (;; i++) {
+    uint32_t hole_end = (i < heap->nr_blocks) ? heap->blocks[i].start : hi;
+    if (hole_end > hi)
+      hole_end = hi;
+
+    uint32_t start = align_start(heap, hole_start);
+    if (start < hole_end && hole_end - start >= size &&
+        (best == LMEM_HEAP_INVALID || hole_end - start < best_hole)) {
+      best = start;
+      best_hole = hole_end - start;
+      best_idx = i;
+    }
+
+    if (i >= heap->nr_blocks || heap->blocks[i].start >= hi)
+      break;
+
+    hole_start = heap->blocks[i].start + heap->blocks[i].size;
+  }
+
+  if (best == LMEM_HEAP_INVALID)
+    return LMEM_HEAP_INVALID;
+
+  memmove(&heap->blocks[best_idx + 1], &heap->blocks[best_idx],
+          (heap->nr_blocks - best_idx) * sizeof(heap->blocks[0]));
+  heap->blocks[best_idx].start = best;
+  heap->blocks[best_idx].size = size;
+  heap->nr_blocks++;
+
+  if (best + size > heap->high_water)
+    heap->high_water = best + size;
+
+  return best;
+}
+
+int lmem_heap_free(lmem_heap_t *heap, uint32_t addr)
+{
+  uint32_t i = lower_bound(heap, addr);
+
+  if (i == heap->nr_blocks || heap->blocks[i].start != addr)
+    return -1;
+
+  heap->nr_blocks--;
+  memmove(&heap->blocks[i], &heap->blocks[i + 1],
+          (heap->nr_blocks - i) * sizeof(heap->blocks[0]));
+  return 0;
+}
+
+uint32_t lmem_heap_largest_free(const lmem_heap_t *heap)
+{
+  uint32_t largest = 0, hole_start = 0;
+
+  for (uint32_t i = 0; i <= heap->nr_blocks; i++) {
+    uint32_t hole_end =
+        (i < heap->nr_blocks) ? heap->blocks[i].start : heap->size;
+    uint32_t start = align_start(heap, hole_start);
+    if (start < hole_end && hole_end - start > largest)
+      largest = hole_end - start;
+
+    if (i < heap->nr_blocks)
+      hole_start = heap->blocks[i].start + heap->blocks[i].size;
+  }
+
+  return largest;
+}
+
+uint32_t lmem_heap_high_water(const lmem_heap_t *heap)
+{
+  return heap->high_water;
+}
+
+void lmem_heap_reset_high_water(lmem_heap_t *heap)
+{
+  heap->high_water = 0;
+  if (heap->nr_blocks) {
+    const lmem_block_t *last = &heap->blocks[heap->nr_blocks - 1];
+    heap->high_water = last->start + last->size;
+  }
+}
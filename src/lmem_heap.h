@@ -0,0 +1,59 @@
+#ifndef CVIKERNEL_LMEM_HEAP_H
+#define CVIKERNEL_LMEM_HEAP_H
+
+#include <stdint.h>
+
+// Local memory allocator shared by the chip backends.
+//
+// Addresses are offsets within one NPU. Allocations are kept sorted by
+// address and the holes between them are the free list, so blocks can be
+// freed in any order. An allocation takes the smallest hole it fits in,
+// the lowest one on ties, which places a sequence of allocations freed in
+// LIFO order exactly as a bump pointer would.
+//
+// Each bank is lmem_size / nr_banks bytes. An allocation targeted at a bank
+// stays within it, an untargeted one may cross bank boundaries.
+#define LMEM_HEAP_ANY_BANK    (-1)
+#define LMEM_HEAP_INVALID     ((uint32_t)-1)
+
+typedef struct {
+  uint32_t start;
+  uint32_t size;
+} lmem_block_t;
+
+typedef struct {
+  uint32_t size;
+  uint32_t nr_banks;
+  uint32_t bank_size;
+  uint32_t align;             // of every start address
+
+  uint32_t nr_blocks;         // allocated, sorted by start
+  uint32_t max_nr_blocks;
+  lmem_block_t *blocks;
+
+  uint32_t high_water;        // highest end address allocated
+} lmem_heap_t;
+
+void lmem_heap_init(
+    lmem_heap_t *heap, uint32_t size, uint32_t nr_banks, uint32_t bank_size,
+    uint32_t align);
+void lmem_heap_destroy(lmem_heap_t *heap);
+
+// Return the start address, or LMEM_HEAP_INVALID if size is 0, bank_id is
+// out of range or no hole is large enough.
+uint32_t lmem_heap_alloc(lmem_heap_t *heap, int bank_id, uint32_t size);
+
+// Return 0, or -1 if no allocation starts at addr.
+int lmem_heap_free(lmem_heap_t *heap, uint32_t addr);
+
+// Size of the largest hole an untargeted allocation can take, from an
+// aligned start.
+uint32_t lmem_heap_largest_free(const lmem_heap_t *heap);
+
+// Highest end address allocated since init or the last reset.
+uint32_t lmem_heap_high_water(const lmem_heap_t *heap);
+
+// Restart the high water mark from the blocks still allocated.
+void lmem_heap_reset_high_water(lmem_heap_t *heap);
+
+#endif /* CVIKERNEL_LMEM_HEAP_H */
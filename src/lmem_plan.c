@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include "lmem_plan.h"
+
+//
+// Greedy by size interval placement.
+//
+// Tensors are placed one at a time, largest first. The tensors already
+// placed whose lifetimes overlap the current one are walked in address
+// order, the current one goes into the smallest hole between them that
+// fits, the space above the highest of them counting as a hole too.
+//
+typedef struct {
+  uint32_t idx;
+  uint32_t size;
+  uint32_t start;
+} plan_item_t;
+
+static int cmp_by_size(const void *pa, const void *pb)
+{
+  const plan_item_t *a = pa;
+  const plan_item_t *b = pb;
+
+  if (a->size != b->size)
+    return (a->size > b->size) ? -1 : 1;
+  return (a->idx < b->idx) ? -1 : 1;
+}
+
+static int overlaps(const cvk_lmem_plan_tensor_t *a,
+                    const cvk_lmem_plan_tensor_t *b)
+{
+  return a->first_use <= b->last_use && b->first_use <= a->last_use;
+}
+
+static uint32_t align_start(uint32_t addr, uint32_t align)
+{
+  return (addr + align - 1) / align * align;
+}
+
+int cvk_lmem_plan(
+    cvk_context_t *ctx,
+    cvk_lmem_plan_tensor_t *tensors,
+    uint32_t nr_tensors,
+    uint32_t *peak)
+{
+  uint32_t lmem_size = ctx->info.lmem_size;
+  uint32_t eu_num = ctx->info.eu_num;
+
+  if (peak)
+    *peak = 0;
+  if (!nr_tensors)
+    return 0;
+  if (!tensors)
+    return -1;
+
+  plan_item_t *items = malloc(nr_tensors * sizeof(*items));
+  plan_item_t **placed = malloc(nr_tensors * sizeof(*placed));
+  if (!items || !placed) {
+    free(items);
+    free(placed);
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < nr_tensors; i++) {
+    cvk_lmem_plan_tensor_t *t = &tensors[i];
+    if (t->first_use > t->last_use) {
+      free(items);
+      free(placed);
+      return -1;
+    }
+
+    t->start_address = CVK_LMEM_PLAN_NO_FIT;
+    items[i].idx = i;
+    items[i].size = ctx->ops->lmem_tensor_to_size(ctx, t->shape, t->fmt,
+                                                  t->eu_align);
+  }
+
+  qsort(items, nr_tensors, sizeof(*items), cmp_by_size);
+
+  // Placed items sorted by start address.
+  uint32_t nr_placed = 0, nr_no_fit = 0, high = 0;
+
+  for (uint32_t i = 0; i < nr_tensors; i++) {
+    plan_item_t *it = &items[i];
+    cvk_lmem_plan_tensor_t *t = &tensors[it->idx];
+
+    uint32_t best = CVK_LMEM_PLAN_NO_FIT, best_hole = 0, end = 0;
+    for (uint32_t j = 0; j <= nr_placed; j++) {
+      plan_item_t *p = (j < nr_placed) ? placed[j] : NULL;
+      if (p && !overlaps(t, &tensors[p->idx]))
+        continue;
+
+      uint32_t start = align_start(end, eu_num);
+      uint32_t hole_end = p ? p->start : lmem_size;
+      if (start < hole_end && hole_end - start >= it->size &&
+          (best == CVK_LMEM_PLAN_NO_FIT || hole_end - start < best_hole)) {
+        best = start;
+        best_hole = hole_end - start;
+      }
+
+      if (p && p->start + p->size > end)
+        end = p->start + p->size;
+    }
+
+    if (!it->size || best == CVK_LMEM_PLAN_NO_FIT) {
+      nr_no_fit++;
+      continue;
+    }
+
+    it->start = best;
+    t->start_address = best;
+    if (best + it->size > high)
+      high = best + it->size;
+
+    uint32_t pos = nr_placed;
+    while (pos && placed[pos - 1]->start > best) {
+      placed[pos] = placed[pos - 1];
+      pos--;
+    }
+    placed[pos] = it;
+    nr_placed++;
+  }
+
+  free(items);
+  free(placed);
+
+  if (peak)
+    *peak = high;
+  return nr_no_fit;
+}
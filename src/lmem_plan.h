@@ -0,0 +1,14 @@
+#ifndef CVIKERNEL_LMEM_PLAN_H
+#define CVIKERNEL_LMEM_PLAN_H
+
+#include <cvikernel/cvikernel.h>
+
+// Liveness based local memory planner shared by the chip backends, see
+// lmem_plan in cvk_misc_operations_t.
+int cvk_lmem_plan(
+    cvk_context_t *ctx,
+    cvk_lmem_plan_tensor_t *tensors,
+    uint32_t nr_tensors,
+    uint32_t *peak);
+
+#endif /* CVIKERNEL_LMEM_PLAN_H */
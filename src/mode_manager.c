@@ -18,6 +18,12 @@ static void enable_stream(mode_manager_t *mm, uint32_t nr_streams)
   mm->mode = BMK_STREAM_MODE;
 }
 
+static void enable_hazard(mode_manager_t *mm)
+{
+  hazard_mode_init(&mm->hazard_mode, &mm->engine_state, mm->ec);
+  mm->mode = BMK_HAZARD_MODE;
+}
+
 static void destroy_current_mode(mode_manager_t *mm)
 {
   switch (mm->mode) {
@@ -30,6 +36,9 @@ static void destroy_current_mode(mode_manager_t *mm)
     case BMK_STREAM_MODE:
       stream_mode_destroy(&mm->stream_mode);
       break;
+    case BMK_HAZARD_MODE:
+      hazard_mode_destroy(&mm->hazard_mode);
+      break;
     default:
       ASSERT(0);
   }
@@ -60,7 +69,8 @@ void mode_manager_reset(mode_manager_t *mm)
 
 void mode_manager_enable_parallel(mode_manager_t *mm)
 {
-  if (mm->mode == BMK_PARALLEL_MODE)
+  // Hazard mode already overlaps engines wherever it is safe.
+  if (mm->mode == BMK_PARALLEL_MODE || mm->mode == BMK_HAZARD_MODE)
     return;
 
   destroy_current_mode(mm);
@@ -69,6 +79,9 @@ void mode_manager_enable_parallel(mode_manager_t *mm)
 
 void mode_manager_disable_parallel(mode_manager_t *mm)
 {
+  if (mm->mode == BMK_HAZARD_MODE)
+    return;
+
   if (mm->mode != BMK_PARALLEL_MODE) {
     ASSERT(mm->mode == BMK_SERIAL_MODE);
     return;
@@ -118,6 +131,9 @@ void mode_manager_restart_sync_id(mode_manager_t *mm)
       stream_mode_init(&mm->stream_mode, &mm->engine_state, mm->ec,
                        mm->stream_mode.nr_streams);
       break;
+    case BMK_HAZARD_MODE:
+      hazard_mode_init(&mm->hazard_mode, &mm->engine_state, mm->ec);
+      break;
     default:
       ASSERT(0);
   }
@@ -136,7 +152,42 @@ void mode_manager_record_ec_desc(mode_manager_t *mm, ec_desc_t *d)
     case BMK_STREAM_MODE:
       stream_mode_record_desc(&mm->stream_mode, d);
       break;
+    case BMK_HAZARD_MODE:
+      // Dependencies are added once memory ranges are known.
+      break;
     default:
       ASSERT(0);
   }
 }
+
+void mode_manager_enable_hazard(mode_manager_t *mm)
+{
+  if (mm->mode == BMK_HAZARD_MODE)
+    return;
+
+  ASSERT(mm->mode == BMK_SERIAL_MODE || mm->mode == BMK_PARALLEL_MODE);
+
+  destroy_current_mode(mm);
+  enable_hazard(mm);
+}
+
+void mode_manager_disable_hazard(mode_manager_t *mm)
+{
+  if (mm->mode != BMK_HAZARD_MODE)
+    return;
+
+  destroy_current_mode(mm);
+  enable_serial(mm);
+}
+
+void mode_manager_record_mem_ranges(
+    mode_manager_t *mm,
+    ec_desc_t *d,
+    const mem_range_t *ranges,
+    uint32_t nr_ranges)
+{
+  if (mm->mode != BMK_HAZARD_MODE)
+    return;
+
+  hazard_mode_record_ranges(&mm->hazard_mode, d, ranges, nr_ranges);
+}
@@ -66,6 +66,56 @@ void stream_mode_record_desc(stream_mode_t *m, ec_desc_t *d);
 void stream_mode_set_stream(stream_mode_t *m, uint32_t i);
 void stream_mode_destroy(stream_mode_t *m);
 
+// Hazard mode derives dependencies from the memory each descriptor
+// accesses instead of the command order:
+//   1. mode_manager_record_ec_desc() only updates the engine state.
+//   2. Once the descriptor is filled, the backend reports its read/write
+//      ranges with mode_manager_record_mem_ranges().
+//   3. The descriptor waits for the latest descriptor of each other engine
+//      with an overlapping range where at least one side writes
+//      (RAW/WAR/WAW). Descriptors of the same engine run in order anyway.
+//
+// Ranges older than a descriptor another engine already waited for can
+// never cause a new hazard and are dropped. If too many ranges are still
+// live, the oldest ones are dropped and their descriptors become a plain
+// barrier for the other engines (see hazard_mode_t.engine_state).
+#define MEM_RANGE_LMEM 0
+#define MEM_RANGE_GMEM 1
+
+typedef struct {
+  uint32_t mem;       // MEM_RANGE_LMEM or MEM_RANGE_GMEM
+  uint32_t is_write;
+  uint64_t start;     // [start, end) in bytes, offset within NPU for LMEM
+  uint64_t end;
+} mem_range_t;
+
+typedef struct {
+  ec_desc_t *desc;
+  mem_range_t range;
+} hazard_entry_t;
+
+#define HAZARD_MODE_MAX_ENTRIES 1024
+
+typedef struct {
+  engine_state_t engine_state;  // latest descriptor of dropped ranges
+  ec_t *ec;
+
+  uint32_t nr_entries;
+  hazard_entry_t *entries;      // live ranges in record order
+
+  // synced[ei * nr_engines + ej]: 1 + seq_no of the latest descriptor of
+  // engine ej waited for by engine ei, 0 if none.
+  uint32_t *synced;
+} hazard_mode_t;
+
+void hazard_mode_init(hazard_mode_t *m, engine_state_t *es, ec_t *ec);
+void hazard_mode_record_ranges(
+    hazard_mode_t *m,
+    ec_desc_t *d,
+    const mem_range_t *ranges,
+    uint32_t nr_ranges);
+void hazard_mode_destroy(hazard_mode_t *m);
+
 typedef struct {
   engine_state_t engine_state;
   ec_t *ec;
@@ -73,11 +123,13 @@ typedef struct {
 #define BMK_SERIAL_MODE   0
 #define BMK_PARALLEL_MODE 1
 #define BMK_STREAM_MODE   2
+#define BMK_HAZARD_MODE   3
   uint32_t mode;
 
   serial_mode_t serial_mode;
   parallel_mode_t parallel_mode;
   stream_mode_t stream_mode;
+  hazard_mode_t hazard_mode;
 } mode_manager_t;
 
 void mode_manager_init(mode_manager_t *mm, ec_t *ec, uint32_t nr_engines);
@@ -90,5 +142,12 @@ void mode_manager_destroy_streams(mode_manager_t *mm);
 void mode_manager_set_stream(mode_manager_t *mm, uint32_t i);
 void mode_manager_restart_sync_id(mode_manager_t *mm);
 void mode_manager_record_ec_desc(mode_manager_t *mm, ec_desc_t *d);
+void mode_manager_enable_hazard(mode_manager_t *mm);
+void mode_manager_disable_hazard(mode_manager_t *mm);
+void mode_manager_record_mem_ranges(
+    mode_manager_t *mm,
+    ec_desc_t *d,
+    const mem_range_t *ranges,
+    uint32_t nr_ranges);
 
 #endif /* CVIKERNEL_MODE_MANAGER_H */
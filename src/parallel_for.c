@@ -0,0 +1,53 @@
+#include "parallel_for.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct {
+  bmk_task_fn_t task;
+  void *arg;
+  uint32_t nr_tasks;
+  uint32_t next_task;   // taken with atomic increments
+} parallel_for_t;
+
+static void *worker(void *data)
+{
+  parallel_for_t *pf = (parallel_for_t *)data;
+
+  for (;;) {
+    uint32_t i = __atomic_fetch_add(&pf->next_task, 1, __ATOMIC_RELAXED);
+    if (i >= pf->nr_tasks)
+      break;
+    pf->task(pf->arg, i);
+  }
+
+  return NULL;
+}
+
+void parallel_for(
+    uint32_t nr_threads,
+    bmk_task_fn_t task,
+    void *arg,
+    uint32_t nr_tasks)
+{
+  parallel_for_t pf = {task, arg, nr_tasks, 0};
+
+  if (nr_threads > nr_tasks)
+    nr_threads = nr_tasks;
+
+  pthread_t *threads = NULL;
+  uint32_t nr_started = 0;
+  if (nr_threads > 1) {
+    threads = malloc((nr_threads - 1) * sizeof(threads[0]));
+    for (; threads && nr_started < nr_threads - 1; nr_started++) {
+      if (pthread_create(&threads[nr_started], NULL, worker, &pf))
+        break;
+    }
+  }
+
+  worker(&pf);
+
+  for (uint32_t i = 0; i < nr_started; i++)
+    pthread_join(threads[i], NULL);
+
+  free(threads);
+}
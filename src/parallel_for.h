@@ -0,0 +1,15 @@
+#ifndef CVIKERNEL_PARALLEL_FOR_H
+#define CVIKERNEL_PARALLEL_FOR_H
+
+#include <bmkernel/bm_kernel.h>
+
+// Run task(arg, i) for every i in [0, nr_tasks) on up to nr_threads
+// threads, the calling thread included. Returns when all tasks are done.
+// Falls back to the calling thread alone if threads cannot be created.
+void parallel_for(
+    uint32_t nr_threads,
+    bmk_task_fn_t task,
+    void *arg,
+    uint32_t nr_tasks);
+
+#endif /* CVIKERNEL_PARALLEL_FOR_H */
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pmu_decode.h"
+
+void pmu_descs_add(
+    pmu_descs_t *d,
+    uint32_t eng_id,
+    uint16_t id,
+    uint16_t layer_id)
+{
+  if (d->nr[eng_id] == d->max_nr[eng_id]) {
+    uint32_t max_nr = d->max_nr[eng_id] ? d->max_nr[eng_id] * 2 : 256;
+    pmu_desc_t *descs = realloc(d->descs[eng_id], max_nr * sizeof(*descs));
+    if (!descs) {
+      d->failed = 1;
+      return;
+    }
+    d->descs[eng_id] = descs;
+    d->max_nr[eng_id] = max_nr;
+  }
+
+  pmu_desc_t *desc = &d->descs[eng_id][d->nr[eng_id]++];
+  desc->id = id;
+  desc->layer_id = layer_id;
+}
+
+void pmu_descs_free(pmu_descs_t *d)
+{
+  for (uint32_t i = 0; i < PMU_ENGINE_NUM; i++)
+    free(d->descs[i]);
+  memset(d, 0, sizeof(*d));
+}
+
+// Index of the next descriptor of eng_id with id from *cursor on,
+// wrapping around once.
+static uint32_t pmu_find_desc(const pmu_descs_t *d, uint32_t eng_id,
+                              uint16_t id, uint32_t *cursor)
+{
+  uint32_t nr = d->nr[eng_id];
+
+  for (uint32_t n = 0; n < nr; n++) {
+    uint32_t i = (*cursor + n) % nr;
+    if (d->descs[eng_id][i].id == id) {
+      *cursor = i + 1;
+      return i;
+    }
+  }
+
+  return CVK_PMU_NO_DESC;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+int pmu_decode_records(
+    const pmu_descs_t *d,
+    const uint8_t *pmu,
+    uint32_t pmu_size,
+    cvk_pmu_event_t *events,
+    uint32_t max_events,
+    uint32_t *nr_events)
+{
+  uint32_t cursor[PMU_ENGINE_NUM] = {0};
+  uint32_t nr = 0;
+
+  if (d->failed) {
+    printf("pmu: out of memory\n");
+    if (nr_events)
+      *nr_events = 0;
+    return -1;
+  }
+
+  for (uint32_t off = 0; off + CVK_PMU_RECORD_BYTES <= pmu_size;
+       off += CVK_PMU_RECORD_BYTES) {
+    const uint8_t *r = pmu + off;
+    uint64_t bits = get_le32(r) | ((uint64_t)get_le32(r + 4) << 32);
+    uint32_t type = bits & 0xf;
+
+    if (!type)
+      break;
+
+    cvk_pmu_event_t ev;
+    ev.type = type;
+    ev.engine_id = (type == CVK_PMU_TIU) ? PMU_TIU : PMU_TDMA;
+    ev.id = (bits >> 4) & 0xffff;
+    ev.event_cnt[0] = (bits >> 20) & 0x3fffff;
+    ev.event_cnt[1] = (bits >> 42) & 0x3fffff;
+    ev.end = get_le32(r + 8);
+    ev.start = get_le32(r + 12);
+    if (ev.end < ev.start)
+      ev.end += 1ull << 32;  // counter wrapped
+
+    ev.desc_index = pmu_find_desc(d, ev.engine_id, ev.id,
+                                  &cursor[ev.engine_id]);
+    ev.layer_id = 0;
+    if (ev.desc_index != CVK_PMU_NO_DESC)
+      ev.layer_id = d->descs[ev.engine_id][ev.desc_index].layer_id;
+
+    if (nr < max_events)
+      events[nr] = ev;
+    nr++;
+  }
+
+  if (nr_events)
+    *nr_events = nr;
+
+  return 0;
+}
+
+typedef struct {
+  uint32_t layer;           // index in the report
+  uint32_t engine_id;
+  uint64_t start;
+  uint64_t end;
+} pmu_interval_t;
+
+static int interval_cmp(const void *a, const void *b)
+{
+  const pmu_interval_t *x = (const pmu_interval_t *)a;
+  const pmu_interval_t *y = (const pmu_interval_t *)b;
+
+  if (x->layer != y->layer)
+    return (x->layer < y->layer) ? -1 : 1;
+  if (x->engine_id != y->engine_id)
+    return (x->engine_id < y->engine_id) ? -1 : 1;
+  if (x->start != y->start)
+    return (x->start < y->start) ? -1 : 1;
+  return 0;
+}
+
+// Merge sorted intervals into their union in place, return the count.
+static uint32_t merge_intervals(pmu_interval_t *v, uint32_t nr)
+{
+  uint32_t n = 0;
+
+  for (uint32_t i = 0; i < nr; i++) {
+    if (n && v[i].start <= v[n - 1].end) {
+      if (v[i].end > v[n - 1].end)
+        v[n - 1].end = v[i].end;
+    } else {
+      v[n++] = v[i];
+    }
+  }
+
+  return n;
+}
+
+static uint64_t busy_time(const pmu_interval_t *v, uint32_t nr)
+{
+  uint64_t t = 0;
+
+  for (uint32_t i = 0; i < nr; i++)
+    t += v[i].end - v[i].start;
+
+  return t;
+}
+
+static uint64_t overlap_time(
+    const pmu_interval_t *a, uint32_t nr_a,
+    const pmu_interval_t *b, uint32_t nr_b)
+{
+  uint64_t t = 0;
+  uint32_t i = 0, j = 0;
+
+  while (i < nr_a && j < nr_b) {
+    uint64_t start = (a[i].start > b[j].start) ? a[i].start : b[j].start;
+    uint64_t end = (a[i].end < b[j].end) ? a[i].end : b[j].end;
+    if (end > start)
+      t += end - start;
+
+    if (a[i].end < b[j].end)
+      i++;
+    else
+      j++;
+  }
+
+  return t;
+}
+
+static void report_layer(
+    cvk_pmu_layer_t *l,
+    pmu_interval_t *v,
+    uint32_t nr)
+{
+  uint32_t nr_tiu = 0;
+
+  while (nr_tiu < nr && v[nr_tiu].engine_id == PMU_TIU)
+    nr_tiu++;
+
+  pmu_interval_t *tiu = v, *tdma = v + nr_tiu;
+  uint32_t nr_tdma = nr - nr_tiu;
+
+  l->nr_tiu = nr_tiu;
+  l->nr_tdma = nr_tdma;
+
+  uint64_t first = v[0].start, last = v[0].end;
+  for (uint32_t i = 0; i < nr; i++) {
+    first = (v[i].start < first) ? v[i].start : first;
+    last = (v[i].end > last) ? v[i].end : last;
+  }
+  l->span = last - first;
+
+  nr_tiu = merge_intervals(tiu, nr_tiu);
+  nr_tdma = merge_intervals(tdma, nr_tdma);
+  l->tiu_busy = busy_time(tiu, nr_tiu);
+  l->tdma_busy = busy_time(tdma, nr_tdma);
+  l->overlap = overlap_time(tiu, nr_tiu, tdma, nr_tdma);
+
+  uint64_t shorter = (l->tiu_busy < l->tdma_busy) ? l->tiu_busy : l->tdma_busy;
+  l->overlap_ratio = shorter ? (float)l->overlap / shorter : 0.0f;
+}
+
+uint32_t pmu_layer_report(
+    const cvk_pmu_event_t *events,
+    uint32_t nr_events,
+    cvk_pmu_layer_t *layers,
+    uint32_t max_layers)
+{
+  pmu_interval_t *v = malloc((nr_events ? nr_events : 1) * sizeof(*v));
+  uint16_t *ids = malloc((nr_events ? nr_events : 1) * sizeof(*ids));
+  uint32_t nr = 0, nr_layers = 0, last = 0;
+
+  if (!v || !ids) {
+    printf("pmu report: out of memory\n");
+    free(v);
+    free(ids);
+    return 0;
+  }
+
+  // Layers in order of first event, events of a layer mostly in a row.
+  for (uint32_t i = 0; i < nr_events; i++) {
+    const cvk_pmu_event_t *ev = &events[i];
+    if (ev->desc_index == CVK_PMU_NO_DESC)
+      continue;
+
+    if (!(last < nr_layers && ids[last] == ev->layer_id)) {
+      for (last = 0; last < nr_layers; last++)
+        if (ids[last] == ev->layer_id)
+          break;
+      if (last == nr_layers)
+        ids[nr_layers++] = ev->layer_id;
+    }
+
+    v[nr].layer = last;
+    v[nr].engine_id = ev->engine_id;
+    v[nr].start = ev->start;
+    v[nr].end = ev->end;
+    nr++;
+  }
+
+  qsort(v, nr, sizeof(*v), interval_cmp);
+
+  for (uint32_t i = 0, first = 0; i < nr_layers && i < max_layers; i++) {
+    uint32_t end = first;
+    while (end < nr && v[end].layer == i)
+      end++;
+
+    cvk_pmu_layer_t *l = &layers[i];
+    memset(l, 0, sizeof(*l));
+    l->layer_id = ids[i];
+    report_layer(l, v + first, end - first);
+    first = end;
+  }
+
+  free(v);
+  free(ids);
+  return nr_layers;
+}
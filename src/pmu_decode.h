@@ -0,0 +1,55 @@
+#ifndef CVIKERNEL_PMU_DECODE_H
+#define CVIKERNEL_PMU_DECODE_H
+
+#include <cvikernel/cvikernel.h>
+
+// Decoding of the pmu records written for each descriptor of a dmabuf,
+// the same on every chip: only walking the dmabuf differs.
+//
+// Records carry the engine and the sync id only. Engines run their
+// descriptors in dmabuf order and ids restart every segment, so a record
+// is the next descriptor of its engine with that id.
+typedef struct {
+  uint16_t id;
+  uint16_t layer_id;
+} pmu_desc_t;
+
+// Engine ids as in cvk_desc_template_t, the same on every chip.
+#define PMU_TIU         0
+#define PMU_TDMA        2
+#define PMU_ENGINE_NUM  3
+
+// Descriptors of each engine in dmabuf order.
+typedef struct {
+  uint32_t nr[PMU_ENGINE_NUM];
+  uint32_t max_nr[PMU_ENGINE_NUM];
+  pmu_desc_t *descs[PMU_ENGINE_NUM];
+  int failed;               // out of memory
+} pmu_descs_t;
+
+void pmu_descs_add(
+    pmu_descs_t *d,
+    uint32_t eng_id,
+    uint16_t id,
+    uint16_t layer_id);
+
+void pmu_descs_free(pmu_descs_t *d);
+
+// Match the records of pmu to d as pmu_decode does.
+// Returns 0, -1 if adding to d ran out of memory.
+int pmu_decode_records(
+    const pmu_descs_t *d,
+    const uint8_t *pmu,
+    uint32_t pmu_size,
+    cvk_pmu_event_t *events,
+    uint32_t max_events,
+    uint32_t *nr_events);
+
+// As pmu_layer_report.
+uint32_t pmu_layer_report(
+    const cvk_pmu_event_t *events,
+    uint32_t nr_events,
+    cvk_pmu_layer_t *layers,
+    uint32_t max_layers);
+
+#endif /* CVIKERNEL_PMU_DECODE_H */
@@ -0,0 +1,14 @@
+#ifndef CVIKERNEL_POOL_TILED_H
+#define CVIKERNEL_POOL_TILED_H
+
+#include <cvikernel/cvikernel.h>
+
+// Pooling or depthwise convolution of global memory tensors tiled over
+// local memory, shared by the chip backends, see pool_tiled in
+// cvk_misc_operations_t.
+int cvk_pool_tiled(
+    cvk_context_t *ctx,
+    const cvk_pool_tiled_param_t *p,
+    cvk_pool_tiling_t *tiling);
+
+#endif /* CVIKERNEL_POOL_TILED_H */
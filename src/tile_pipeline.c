@@ -0,0 +1,94 @@
+#include "tile_pipeline.h"
+
+// Commands dropped by the backend so far, 0 if it asserts instead.
+static uint32_t nr_dropped_cmds(cvk_context_t *ctx)
+{
+  if (!ctx->misc_ops->nr_dropped_cmds)
+    return 0;
+
+  return ctx->misc_ops->nr_dropped_cmds(ctx);
+}
+
+int tile_pipeline_run(
+    cvk_context_t *ctx,
+    const tile_pipeline_t *pl,
+    void *arg,
+    uint32_t nr_tiles)
+{
+  uint32_t nr_dropped = nr_dropped_cmds(ctx);
+
+  for (uint32_t s = 0; s < nr_tiles + 2; s++) {
+    ctx->ops->parallel_enable(ctx);
+
+    if (s < nr_tiles)
+      pl->load(ctx, arg, s, s % pl->nr_bufs);
+    if (s >= 1 && s - 1 < nr_tiles)
+      pl->compute(ctx, arg, s - 1, (s - 1) % pl->nr_bufs);
+    if (s >= 2)
+      pl->store(ctx, arg, s - 2, (s - 2) % pl->nr_bufs);
+
+    ctx->ops->parallel_disable(ctx);
+
+    // No use going on once the cmdbuf is out of descriptors.
+    if (nr_dropped_cmds(ctx) != nr_dropped)
+      return -1;
+  }
+
+  return 0;
+}
+
+uint32_t tile_lmem_free(cvk_context_t *ctx)
+{
+  if (!ctx->misc_ops->lmem_largest_free)
+    return ctx->info.lmem_size;
+
+  return ctx->misc_ops->lmem_largest_free(ctx);
+}
+
+static uint32_t ceil_div(uint32_t a, uint32_t b)
+{
+  return (a + b - 1) / b;
+}
+
+uint32_t tile_step(uint32_t dim, uint32_t align, uint32_t nr)
+{
+  uint32_t step = ceil_div(ceil_div(dim, nr), align) * align;
+  return (step < dim) ? step : dim;
+}
+
+int tile_split_more(uint32_t dim, uint32_t align, uint32_t *nr)
+{
+  uint32_t step = tile_step(dim, align, *nr);
+  if (step <= align)
+    return 0;
+
+  while (tile_step(dim, align, ++(*nr)) == step)
+    ;
+  return 1;
+}
+
+void tile_input_range(
+    uint32_t o, uint32_t on, uint32_t stride, uint32_t k_ext, uint32_t pad,
+    uint32_t in, uint32_t *start, uint32_t *len, uint8_t *pad_lo,
+    uint8_t *pad_hi)
+{
+  int64_t lo = (int64_t)o * stride - pad;
+  int64_t hi = (int64_t)(o + on - 1) * stride + k_ext - pad;
+
+  *pad_lo = (lo < 0) ? -lo : 0;
+  *pad_hi = (hi > in) ? hi - in : 0;
+  if (lo < 0)
+    lo = 0;
+  if (hi > in)
+    hi = in;
+
+  *start = lo;
+  *len = hi - lo;
+}
+
+uint32_t tile_input_max(
+    uint32_t step, uint32_t stride, uint32_t k_ext, uint32_t in)
+{
+  uint64_t n = (uint64_t)(step - 1) * stride + k_ext;
+  return (n < in) ? n : in;
+}
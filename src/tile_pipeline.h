@@ -0,0 +1,52 @@
+#ifndef CVIKERNEL_TILE_PIPELINE_H
+#define CVIKERNEL_TILE_PIPELINE_H
+
+#include <cvikernel/cvikernel.h>
+
+// Ping-pong pipeline over the tiles of a tiled operation.
+//
+// Stage s loads tile s, computes tile s - 1 and stores tile s - 2 between
+// parallel_enable and parallel_disable, so the TDMA transfers of one stage
+// overlap its TIU command and each stage waits for the one before. Tile i
+// uses buffer set i % nr_bufs of a ring. Two sets keep the other tiles of
+// a stage off the loaded and computed buffers when loads and stores use
+// separate buffers, three are needed when a tile is computed in place and
+// stored from the buffer it was loaded into.
+typedef struct {
+  void (*load)(cvk_context_t *ctx, void *arg, uint32_t tile, uint32_t buf);
+  void (*compute)(cvk_context_t *ctx, void *arg, uint32_t tile, uint32_t buf);
+  void (*store)(cvk_context_t *ctx, void *arg, uint32_t tile, uint32_t buf);
+  uint32_t nr_bufs;
+} tile_pipeline_t;
+
+// Return 0, -1 if the backend dropped a command, e.g. when the cmdbuf
+// ran out of descriptors, the stages after it are not emitted.
+int tile_pipeline_run(
+    cvk_context_t *ctx,
+    const tile_pipeline_t *pl,
+    void *arg,
+    uint32_t nr_tiles);
+
+// Local memory the buffers of a split may take, see lmem_largest_free.
+uint32_t tile_lmem_free(cvk_context_t *ctx);
+
+// Step of dim split into nr tiles, a multiple of align unless it is dim.
+uint32_t tile_step(uint32_t dim, uint32_t align, uint32_t nr);
+
+// Raise *nr until the step drops, 0 if it cannot drop any more.
+int tile_split_more(uint32_t dim, uint32_t align, uint32_t *nr);
+
+// Input range [*start, *start + *len) of a sliding window op read by
+// outputs [o, o + on) along one dimension of in inputs, and the padding
+// left before and after it. Only tiles at the real edges get padding,
+// inner tiles read the halo inputs they share with their neighbours.
+void tile_input_range(
+    uint32_t o, uint32_t on, uint32_t stride, uint32_t k_ext, uint32_t pad,
+    uint32_t in, uint32_t *start, uint32_t *len, uint8_t *pad_lo,
+    uint8_t *pad_hi);
+
+// Most inputs read by step outputs along one dimension.
+uint32_t tile_input_max(
+    uint32_t step, uint32_t stride, uint32_t k_ext, uint32_t in);
+
+#endif /* CVIKERNEL_TILE_PIPELINE_H */
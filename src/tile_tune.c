@@ -0,0 +1,196 @@
+#include <string.h>
+#include "tile_tune.h"
+#include "tile_pipeline.h"
+#include "cost_model.h"
+
+// Pipeline stage overhead, on top of the commands of cost_model.h.
+#define STAGE_CYCLES            16
+
+static uint64_t max_u64(uint64_t a, uint64_t b)
+{
+  return (a > b) ? a : b;
+}
+
+uint64_t tile_tiu_cycles(
+    const cvk_chip_info_t *info, uint32_t n, uint32_t c, uint32_t hw,
+    uint64_t macs)
+{
+  return cost_tiu_passes(info->npu_num, info->eu_num, n, c, hw) * macs;
+}
+
+uint64_t tile_cost_cycles(const tile_cost_t *c)
+{
+  uint64_t nr = c->nr_tiles;
+
+  if (!nr)
+    return 0;
+
+  uint64_t load = cost_tdma_cycles(c->nr_loads, c->load_bytes) / nr;
+  uint64_t store = cost_tdma_cycles(c->nr_stores, c->store_bytes) / nr;
+  uint64_t tiu = cost_tiu_cycles(c->nr_tius, c->tiu_cycles) / nr;
+
+  // Stage s loads tile s, computes tile s - 1 and stores tile s - 2, the
+  // first two and last two stages run part of the pipe only.
+  uint64_t cycles = (nr + 2) * STAGE_CYCLES;
+  if (nr == 1)
+    return cycles + load + tiu + store;
+
+  cycles += load + max_u64(load, tiu);
+  cycles += (nr - 2) * max_u64(load + store, tiu);
+  cycles += max_u64(tiu, store) + store;
+  return cycles;
+}
+
+// Plans kept by the search, the first one allocating is taken.
+#define NR_BEST   8
+
+typedef struct {
+  uint32_t nr[TILE_TUNE_NR_DIMS];
+  uint64_t cycles;
+} plan_t;
+
+typedef struct {
+  uint32_t nr_plans;            // cheapest first
+  plan_t plans[NR_BEST];
+} ranking_t;
+
+static void ranking_add(ranking_t *r, const uint32_t *nr, uint64_t cycles)
+{
+  uint32_t i = r->nr_plans;
+
+  if (i == NR_BEST) {
+    if (cycles >= r->plans[i - 1].cycles)
+      return;
+    i--;
+  } else {
+    r->nr_plans++;
+  }
+
+  // Insert before the costlier plans, after the equal ones.
+  for (; i && r->plans[i - 1].cycles > cycles; i--)
+    r->plans[i] = r->plans[i - 1];
+
+  memcpy(r->plans[i].nr, nr, sizeof(r->plans[i].nr));
+  r->plans[i].cycles = cycles;
+}
+
+// Fewest tiles of the last dimension whose buffers fit with the others
+// split as in nr, 0 if even the smallest step does not.
+static uint32_t fewest_last(
+    cvk_context_t *ctx, const tile_tuner_t *tu, void *arg, uint32_t *nr)
+{
+  const uint32_t last = TILE_TUNE_NR_DIMS - 1;
+  uint32_t dim = tu->dim[last], align = tu->align[last];
+  uint32_t lo = 1, hi = (dim + align - 1) / align;
+
+  // The buffers only shrink as the step does.
+  nr[last] = hi;
+  if (!tu->fits(ctx, arg, nr))
+    return 0;
+
+  while (lo < hi) {
+    nr[last] = lo + (hi - lo) / 2;
+    if (tu->fits(ctx, arg, nr))
+      hi = nr[last];
+    else
+      lo = nr[last] + 1;
+  }
+
+  return lo;
+}
+
+static void rank(
+    cvk_context_t *ctx, const tile_tuner_t *tu, void *arg, uint32_t d,
+    uint32_t *nr, ranking_t *r)
+{
+  if (d == TILE_TUNE_NR_DIMS - 1) {
+    nr[d] = fewest_last(ctx, tu, arg, nr);
+    if (nr[d])
+      ranking_add(r, nr, tu->cycles(ctx, arg, nr));
+    return;
+  }
+
+  nr[d] = 1;
+  do {
+    rank(ctx, tu, arg, d + 1, nr, r);
+  } while (tile_split_more(tu->dim[d], tu->align[d], &nr[d]));
+}
+
+static const uint32_t *cache_find(cvk_tile_cache_t *cache, uint64_t key)
+{
+  for (uint32_t i = 0; i < cache->nr_entries; i++) {
+    if (cache->entries[i].key == key) {
+      cache->nr_hits++;
+      return cache->entries[i].nr;
+    }
+  }
+
+  cache->nr_misses++;
+  return NULL;
+}
+
+static void cache_insert(
+    cvk_tile_cache_t *cache, uint64_t key, const uint32_t *nr)
+{
+  cvk_tile_cache_entry_t *e = NULL;
+
+  for (uint32_t i = 0; i < cache->nr_entries; i++) {
+    if (cache->entries[i].key == key) {
+      e = &cache->entries[i];
+      break;
+    }
+  }
+
+  if (!e) {
+    if (cache->nr_entries < CVK_TILE_CACHE_SIZE) {
+      e = &cache->entries[cache->nr_entries++];
+    } else {
+      e = &cache->entries[cache->next];
+      cache->next = (cache->next + 1) % CVK_TILE_CACHE_SIZE;
+    }
+  }
+
+  e->key = key;
+  memcpy(e->nr, nr, sizeof(e->nr));
+}
+
+int tile_tune(
+    cvk_context_t *ctx, const tile_tuner_t *tu, void *arg,
+    cvk_tile_cache_t *cache, uint64_t key)
+{
+  uint32_t nr[TILE_TUNE_NR_DIMS];
+  ranking_t r;
+
+  // The cached split may not fit next to what is allocated now.
+  const uint32_t *cached = cache ? cache_find(cache, key) : NULL;
+  if (cached && tu->fits(ctx, arg, cached) && !tu->alloc(ctx, arg, cached))
+    return 0;
+
+  memset(&r, 0, sizeof(r));
+  rank(ctx, tu, arg, 0, nr, &r);
+
+  for (uint32_t i = 0; i < r.nr_plans; i++) {
+    if (!tu->alloc(ctx, arg, r.plans[i].nr)) {
+      if (cache)
+        cache_insert(cache, key, r.plans[i].nr);
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+uint64_t tile_cache_key(const uint32_t *words, uint32_t nr_words)
+{
+  // FNV-1a over the bytes of the words.
+  uint64_t key = 0xcbf29ce484222325ULL;
+
+  for (uint32_t i = 0; i < nr_words; i++) {
+    for (uint32_t b = 0; b < 4; b++) {
+      key ^= (words[i] >> (b * 8)) & 0xff;
+      key *= 0x100000001b3ULL;
+    }
+  }
+
+  return key;
+}
@@ -0,0 +1,58 @@
+#ifndef CVIKERNEL_TILE_TUNE_H
+#define CVIKERNEL_TILE_TUNE_H
+
+#include <cvikernel/cvikernel.h>
+
+// Split search of the tiled ops, shared by conv_tiled, gemm_tiled and
+// pool_tiled.
+//
+// A split is the number of tiles along each of up to four dimensions.
+// Candidates are ranked by the cycles an analytic model gives their tile
+// pipeline on the chip in cvk_chip_info_t: TIU time from the lane and EU
+// counts, TDMA time from the bytes moved at a nominal bandwidth plus a
+// fixed cost per descriptor and burst, as in cost_model.h, and a fixed
+// cost per pipeline stage.
+#define TILE_TUNE_NR_DIMS   4
+
+typedef struct {
+  uint32_t nr_tiles;
+  uint64_t load_bytes;          // all tiles
+  uint64_t store_bytes;
+  uint32_t nr_loads;            // all tiles
+  uint32_t nr_stores;
+  uint64_t tiu_cycles;          // all tiles
+  uint32_t nr_tius;
+} tile_cost_t;
+
+// Estimated cycles of the pipeline, every tile taken as the average one.
+uint64_t tile_cost_cycles(const tile_cost_t *c);
+
+// Cycles of one TIU command over n * c * hw outputs of macs each.
+uint64_t tile_tiu_cycles(
+    const cvk_chip_info_t *info, uint32_t n, uint32_t c, uint32_t hw,
+    uint64_t macs);
+
+typedef struct {
+  uint32_t dim[TILE_TUNE_NR_DIMS];
+  uint32_t align[TILE_TUNE_NR_DIMS];  // of the steps, as in tile_step
+
+  // Whether the buffers of a split fit in the local memory left free.
+  int (*fits)(cvk_context_t *ctx, void *arg, const uint32_t *nr);
+  uint64_t (*cycles)(cvk_context_t *ctx, void *arg, const uint32_t *nr);
+  // Allocate the buffers of a split, 0 on success.
+  int (*alloc)(cvk_context_t *ctx, void *arg, const uint32_t *nr);
+} tile_tuner_t;
+
+// Allocate the split cached for key if any fits, else the cheapest of the
+// splits ranked that does and cache it. Only the fewest tiles of the last
+// dimension that fit are ranked for each split of the others, the first
+// dimensions lead.
+// Return 0, -1 if none could be allocated.
+int tile_tune(
+    cvk_context_t *ctx, const tile_tuner_t *tu, void *arg,
+    cvk_tile_cache_t *cache, uint64_t key);
+
+// Key of a layer from the words identifying its op and shapes.
+uint64_t tile_cache_key(const uint32_t *words, uint32_t nr_words);
+
+#endif /* CVIKERNEL_TILE_TUNE_H */
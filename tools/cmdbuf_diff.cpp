@@ -0,0 +1,539 @@
+//
+// cmdbuf_diff, per layer comparison of two cmdbufs or dmabufs.
+//
+// Both files are walked with the register parsers of their chips and
+// summed by layer_id: descriptor counts, double conv use, barriers and
+// tdma bytes, and the cycles of the cost model on cv181x/cv180x. A
+// cv181x/cv180x cmdbuf is also replayed with cmdbuf_timeline for the span
+// of each layer, which unlike the summed cycles shows time lost waiting
+// on the other engine. Layers that changed are reported as text, JSON or
+// CSV.
+//
+// Exits with 0 when nothing changed, 1 when something did, 2 on errors.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "cmdbuf_reader.h"
+
+typedef enum {
+  FMT_TEXT = 0,
+  FMT_JSON,
+  FMT_CSV,
+} out_fmt_t;
+
+typedef struct {
+  uint32_t layer_id;
+  uint64_t nr_tiu;
+  uint64_t nr_tdma;
+  uint64_t nr_conv;
+  uint64_t nr_double_conv;
+  uint64_t nr_barriers;     // new waits on the other engine, see new_wait
+  uint64_t tdma_bytes;
+  uint64_t tiu_cycles;
+  uint64_t tdma_cycles;
+  uint64_t span;            // from the first start to the last end
+} layer_stats_t;
+
+typedef enum {
+  SRC_WALK = 0,
+  SRC_COST,                 // the cost model
+  SRC_TIMELINE,             // the replay of a cmdbuf
+} metric_src_t;
+
+typedef struct {
+  const char *name;
+  uint64_t layer_stats_t::*value;
+  metric_src_t src;
+} metric_t;
+
+static const metric_t metrics[] = {
+  { "nr_tiu", &layer_stats_t::nr_tiu, SRC_WALK },
+  { "nr_tdma", &layer_stats_t::nr_tdma, SRC_WALK },
+  { "nr_conv", &layer_stats_t::nr_conv, SRC_WALK },
+  { "nr_double_conv", &layer_stats_t::nr_double_conv, SRC_WALK },
+  { "nr_barriers", &layer_stats_t::nr_barriers, SRC_WALK },
+  { "tdma_bytes", &layer_stats_t::tdma_bytes, SRC_WALK },
+  { "tiu_cycles", &layer_stats_t::tiu_cycles, SRC_COST },
+  { "tdma_cycles", &layer_stats_t::tdma_cycles, SRC_COST },
+  { "span", &layer_stats_t::span, SRC_TIMELINE },
+};
+
+#define NR_METRICS (sizeof(metrics) / sizeof(metrics[0]))
+
+typedef struct {
+  const char *path;
+  chip_t chip;
+  int dmabuf;
+  int has_cost;
+  int has_span;
+  uint64_t size;
+  uint32_t nr_segments;
+  layer_stats_t total;
+  std::vector<layer_stats_t> layers;          // in order of appearance
+  std::vector<int32_t> index;                 // by layer_id
+} profile_t;
+
+//
+// Span of each layer in a replay of the cmdbuf, the total is the end of
+// the last descriptor.
+//
+static int replay_spans(cvk_context_t *ctx, const mapped_file_t &f,
+                        profile_t *p)
+{
+  std::vector<cvk_timeline_event_t> events(p->total.nr_tiu +
+                                           p->total.nr_tdma);
+  cvk_timeline_param_t param;
+  cvk_timeline_t summary;
+
+  memset(&param, 0, sizeof(param));
+  param.cmdbuf = f.data;
+  param.size = (uint32_t)f.size;
+  if (f.size > UINT32_MAX ||
+      ctx->misc_ops->cmdbuf_timeline(ctx, &param, events.data(),
+                                     events.size(), &summary))
+    return -1;
+
+  // Events of the two engines interleave, a later one may start first.
+  std::vector<uint64_t> first(p->layers.size(), UINT64_MAX);
+  std::vector<uint64_t> last(p->layers.size(), 0);
+  uint32_t nr = (summary.nr_events < events.size()) ?
+                summary.nr_events : events.size();
+  for (uint32_t i = 0; i < nr; i++) {
+    const cvk_timeline_event_t &e = events[i];
+    int32_t l = p->index[e.layer_id];
+    if (l < 0)
+      continue;
+    if (e.start < first[l])
+      first[l] = e.start;
+    if (e.end > last[l])
+      last[l] = e.end;
+  }
+
+  for (size_t l = 0; l < p->layers.size(); l++)
+    if (first[l] != UINT64_MAX)
+      p->layers[l].span = last[l] - first[l];
+
+  p->total.span = summary.cycles;
+  return 0;
+}
+
+static int load_profile(const char *path, profile_t *p)
+{
+  mapped_file_t f;
+
+  if (map_file(path, &f))
+    return -1;
+
+  p->path = path;
+  p->chip = chip_of_buf(f.data, f.size);
+  p->dmabuf = is_dmabuf(f.data, f.size);
+  p->size = f.size;
+  p->index.assign(1 << 16, -1);
+  memset(&p->total, 0, sizeof(p->total));
+  p->has_span = 0;
+
+  cvk_context_t *ctx = chip_context(p->chip);
+  if (ctx && !ctx->misc_ops->desc_cost) {
+    free_chip_context(ctx);
+    ctx = NULL;
+  }
+  p->has_cost = (ctx != NULL);
+
+  int nr_segments = desc_walk(f.data, f.size, &p->chip,
+                              [&](const cmdbuf_desc_t &d) {
+    uint32_t layer_id = d.layer_id & 0xffff;
+    if (p->index[layer_id] < 0) {
+      p->index[layer_id] = p->layers.size();
+      layer_stats_t l;
+      memset(&l, 0, sizeof(l));
+      l.layer_id = layer_id;
+      p->layers.push_back(l);
+    }
+    layer_stats_t &l = p->layers[p->index[layer_id]];
+
+    cvk_desc_cost_t cost;
+    memset(&cost, 0, sizeof(cost));
+    if (ctx) {
+      cvk_desc_template_t t;
+      t.engine_id = d.engine_id;
+      memcpy(t.regs, d.regs, sizeof(t.regs));
+      ctx->misc_ops->desc_cost(ctx, &t, &cost);
+    }
+
+    if (d.engine_id == CVI_TPU_TIU) {
+      l.nr_tiu++;
+      l.nr_conv += (d.op == OP_CONV);
+      l.nr_double_conv += (d.op == OP_CONV && d.double_conv);
+      l.tiu_cycles += cost.cycles;
+    } else {
+      l.nr_tdma++;
+      l.tdma_bytes += d.tdma_bytes;
+      l.tdma_cycles += cost.cycles;
+    }
+    l.nr_barriers += d.new_wait;
+  });
+
+  if (nr_segments < 0) {
+    fprintf(stderr, "cannot read %s\n", path);
+    free_chip_context(ctx);
+    unmap_file(&f);
+    return -1;
+  }
+  p->nr_segments = nr_segments;
+
+  for (const layer_stats_t &l : p->layers)
+    for (uint32_t i = 0; i < NR_METRICS; i++)
+      p->total.*metrics[i].value += l.*metrics[i].value;
+
+  // Only cmdbufs replay, a dmabuf keeps the engines apart.
+  if (ctx && !p->dmabuf && ctx->misc_ops->cmdbuf_timeline) {
+    p->has_span = !replay_spans(ctx, f, p);
+    if (!p->has_span)
+      fprintf(stderr, "cannot replay %s\n", path);
+  }
+
+  free_chip_context(ctx);
+  unmap_file(&f);
+  return 0;
+}
+
+//
+// Layers of either profile, matched by layer_id.
+//
+typedef enum {
+  LAYER_SAME = 0,
+  LAYER_CHANGED,
+  LAYER_ADDED,
+  LAYER_REMOVED,
+} layer_status_t;
+
+typedef struct {
+  uint32_t layer_id;
+  layer_status_t status;
+  layer_stats_t old_stats;
+  layer_stats_t new_stats;
+} layer_diff_t;
+
+static const char *status_name(layer_status_t status)
+{
+  static const char *names[] = { "same", "changed", "added", "removed" };
+  return names[status];
+}
+
+static int metric_known(const metric_t &m, const profile_t &p)
+{
+  switch (m.src) {
+    case SRC_COST:
+      return p.has_cost;
+    case SRC_TIMELINE:
+      return p.has_span;
+    default:
+      return 1;
+  }
+}
+
+static int metric_used(const metric_t &m, const profile_t &a,
+                       const profile_t &b)
+{
+  return metric_known(m, a) && metric_known(m, b);
+}
+
+static int stats_differ(const layer_stats_t &x, const layer_stats_t &y,
+                        const profile_t &a, const profile_t &b)
+{
+  for (uint32_t i = 0; i < NR_METRICS; i++)
+    if (metric_used(metrics[i], a, b) &&
+        x.*metrics[i].value != y.*metrics[i].value)
+      return 1;
+
+  return 0;
+}
+
+static std::vector<layer_diff_t> diff_profiles(const profile_t &a,
+                                               const profile_t &b)
+{
+  std::vector<layer_diff_t> diffs;
+  layer_stats_t none;
+
+  memset(&none, 0, sizeof(none));
+
+  for (const layer_stats_t &l : a.layers) {
+    layer_diff_t d;
+    d.layer_id = l.layer_id;
+    d.old_stats = l;
+    if (b.index[l.layer_id] < 0) {
+      d.new_stats = none;
+      d.new_stats.layer_id = l.layer_id;
+      d.status = LAYER_REMOVED;
+    } else {
+      d.new_stats = b.layers[b.index[l.layer_id]];
+      d.status = stats_differ(d.old_stats, d.new_stats, a, b) ?
+                 LAYER_CHANGED : LAYER_SAME;
+    }
+    diffs.push_back(d);
+  }
+
+  for (const layer_stats_t &l : b.layers) {
+    if (a.index[l.layer_id] >= 0)
+      continue;
+
+    layer_diff_t d;
+    d.layer_id = l.layer_id;
+    d.old_stats = none;
+    d.old_stats.layer_id = l.layer_id;
+    d.new_stats = l;
+    d.status = LAYER_ADDED;
+    diffs.push_back(d);
+  }
+
+  return diffs;
+}
+
+// Growth of a layer, its span with a replay of both, cycles with a cost
+// model and tdma bytes otherwise.
+static int64_t layer_growth(const layer_diff_t &d, int has_span, int has_cost)
+{
+  if (has_span)
+    return (int64_t)d.new_stats.span - (int64_t)d.old_stats.span;
+  if (has_cost)
+    return (int64_t)(d.new_stats.tiu_cycles + d.new_stats.tdma_cycles) -
+           (int64_t)(d.old_stats.tiu_cycles + d.old_stats.tdma_cycles);
+
+  return (int64_t)d.new_stats.tdma_bytes - (int64_t)d.old_stats.tdma_bytes;
+}
+
+//
+// Output.
+//
+static void text_profile(FILE *fp, const char *tag, const profile_t &p)
+{
+  fprintf(fp, "%s: %s, %s %s, %llu bytes, %u segments, %zu layers%s\n",
+          tag, p.path, chip_name(p.chip), p.dmabuf ? "dmabuf" : "cmdbuf",
+          (unsigned long long)p.size, p.nr_segments, p.layers.size(),
+          !p.has_cost ? ", no cost model" :
+          !p.has_span ? ", no replay" : "");
+}
+
+static void text_change(FILE *fp, const char *name, uint64_t x, uint64_t y)
+{
+  fprintf(fp, "  %-15s %12llu -> %-12llu %+lld", name,
+          (unsigned long long)x, (unsigned long long)y,
+          (long long)y - (long long)x);
+  if (x)
+    fprintf(fp, " (%+.1f%%)", ((double)y - (double)x) * 100.0 / x);
+  fprintf(fp, "\n");
+}
+
+static void text_stats(FILE *fp, const layer_stats_t &x,
+                       const layer_stats_t &y, const profile_t &a,
+                       const profile_t &b, int all)
+{
+  for (uint32_t i = 0; i < NR_METRICS; i++) {
+    const metric_t &m = metrics[i];
+    if (metric_used(m, a, b) && (all || x.*m.value != y.*m.value))
+      text_change(fp, m.name, x.*m.value, y.*m.value);
+  }
+}
+
+static void report_text(FILE *fp, const profile_t &a, const profile_t &b,
+                        const std::vector<layer_diff_t> &diffs, int all)
+{
+  text_profile(fp, "old", a);
+  text_profile(fp, "new", b);
+
+  if (a.nr_segments != b.nr_segments)
+    fprintf(fp, "segments: %u -> %u\n", a.nr_segments, b.nr_segments);
+
+  fprintf(fp, "\ntotal\n");
+  text_stats(fp, a.total, b.total, a, b, 1);
+
+  for (const layer_diff_t &d : diffs) {
+    if (d.status == LAYER_SAME && !all)
+      continue;
+
+    fprintf(fp, "\nlayer %u %s\n", d.layer_id, status_name(d.status));
+    text_stats(fp, d.old_stats, d.new_stats, a, b, all);
+  }
+}
+
+static void json_stats(FILE *fp, const layer_stats_t &l, const profile_t &p)
+{
+  fprintf(fp, "{");
+  for (uint32_t i = 0; i < NR_METRICS; i++) {
+    const metric_t &m = metrics[i];
+    fprintf(fp, "%s\"%s\": ", i ? ", " : "", m.name);
+    if (!metric_known(m, p))
+      fprintf(fp, "null");
+    else
+      fprintf(fp, "%llu", (unsigned long long)(l.*m.value));
+  }
+  fprintf(fp, "}");
+}
+
+static void json_profile(FILE *fp, const profile_t &p)
+{
+  fprintf(fp, "{\"path\": \"");
+  for (const char *s = p.path; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      fputc('\\', fp);
+    fputc(*s, fp);
+  }
+  fprintf(fp, "\", \"chip\": \"%s\", \"dmabuf\": %s, \"size\": %llu, "
+              "\"nr_segments\": %u, \"nr_layers\": %zu, \"total\": ",
+          chip_name(p.chip), p.dmabuf ? "true" : "false",
+          (unsigned long long)p.size, p.nr_segments, p.layers.size());
+  json_stats(fp, p.total, p);
+  fprintf(fp, "}");
+}
+
+static void report_json(FILE *fp, const profile_t &a, const profile_t &b,
+                        const std::vector<layer_diff_t> &diffs, int all)
+{
+  fprintf(fp, "{\"old\": ");
+  json_profile(fp, a);
+  fprintf(fp, ",\n\"new\": ");
+  json_profile(fp, b);
+  fprintf(fp, ",\n\"layers\": [");
+
+  int first = 1;
+  for (const layer_diff_t &d : diffs) {
+    if (d.status == LAYER_SAME && !all)
+      continue;
+
+    fprintf(fp, "%s\n{\"layer_id\": %u, \"status\": \"%s\", \"old\": ",
+            first ? "" : ",", d.layer_id, status_name(d.status));
+    json_stats(fp, d.old_stats, a);
+    fprintf(fp, ", \"new\": ");
+    json_stats(fp, d.new_stats, b);
+    fprintf(fp, "}");
+    first = 0;
+  }
+
+  fprintf(fp, "\n]}\n");
+}
+
+static void csv_value(FILE *fp, const metric_t &m, const layer_stats_t &l,
+                      const profile_t &p)
+{
+  if (!metric_known(m, p))
+    fprintf(fp, ",");
+  else
+    fprintf(fp, ",%llu", (unsigned long long)(l.*m.value));
+}
+
+static void report_csv(FILE *fp, const profile_t &a, const profile_t &b,
+                       const std::vector<layer_diff_t> &diffs, int all)
+{
+  fprintf(fp, "layer_id,status");
+  for (uint32_t i = 0; i < NR_METRICS; i++)
+    fprintf(fp, ",old_%s,new_%s", metrics[i].name, metrics[i].name);
+  fprintf(fp, "\n");
+
+  for (const layer_diff_t &d : diffs) {
+    if (d.status == LAYER_SAME && !all)
+      continue;
+
+    fprintf(fp, "%u,%s", d.layer_id, status_name(d.status));
+    for (uint32_t i = 0; i < NR_METRICS; i++) {
+      csv_value(fp, metrics[i], d.old_stats, a);
+      csv_value(fp, metrics[i], d.new_stats, b);
+    }
+    fprintf(fp, "\n");
+  }
+}
+
+static void usage(const char *prog)
+{
+  printf("Usage: %s [-f text|json|csv] [-a] [-s] [-o out] old.bin new.bin\n",
+         prog);
+  printf("  -f  output format, text by default\n");
+  printf("  -a  report every layer, not only the changed ones\n");
+  printf("  -s  sort layers by growth, span with a replay, cycles with a "
+         "cost model and tdma bytes otherwise\n");
+  printf("  -o  output file, stdout by default\n");
+}
+
+int main(int argc, char *argv[])
+{
+  out_fmt_t fmt = FMT_TEXT;
+  int all = 0, sort = 0;
+  const char *out_path = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:aso:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        if (!strcmp(optarg, "text")) {
+          fmt = FMT_TEXT;
+        } else if (!strcmp(optarg, "json")) {
+          fmt = FMT_JSON;
+        } else if (!strcmp(optarg, "csv")) {
+          fmt = FMT_CSV;
+        } else {
+          usage(argv[0]);
+          return 2;
+        }
+        break;
+      case 'a':
+        all = 1;
+        break;
+      case 's':
+        sort = 1;
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+
+  if (optind != argc - 2) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  profile_t a, b;
+  if (load_profile(argv[optind], &a) || load_profile(argv[optind + 1], &b))
+    return 2;
+
+  std::vector<layer_diff_t> diffs = diff_profiles(a, b);
+  int has_span = a.has_span && b.has_span;
+  int has_cost = a.has_cost && b.has_cost;
+  if (sort)
+    std::stable_sort(diffs.begin(), diffs.end(),
+                     [&](const layer_diff_t &x, const layer_diff_t &y) {
+      return layer_growth(x, has_span, has_cost) >
+             layer_growth(y, has_span, has_cost);
+    });
+
+  FILE *fp = out_path ? fopen(out_path, "w") : stdout;
+  if (!fp) {
+    fprintf(stderr, "cannot open %s\n", out_path);
+    return 2;
+  }
+
+  if (fmt == FMT_JSON)
+    report_json(fp, a, b, diffs, all);
+  else if (fmt == FMT_CSV)
+    report_csv(fp, a, b, diffs, all);
+  else
+    report_text(fp, a, b, diffs, all);
+
+  if (ferror(fp) || (out_path && fclose(fp))) {
+    fprintf(stderr, "cannot write %s\n", out_path ? out_path : "stdout");
+    return 2;
+  }
+
+  int changed = (a.nr_segments != b.nr_segments);
+  for (const layer_diff_t &d : diffs)
+    changed |= (d.status != LAYER_SAME);
+
+  return changed ? 1 : 0;
+}
@@ -0,0 +1,682 @@
+#ifndef READCMDBUF_CMDBUF_READER_H
+#define READCMDBUF_CMDBUF_READER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <bmkernel/bm_kernel.h>
+#include <bmkernel/bm_kernel_legacy.h>
+#include <bmkernel/bm_regcpu.h>
+#include <bmkernel/reg_bdcast.h>
+#include <bmkernel/reg_tdma.h>
+#include "reg_fields.h"
+
+//
+// Register headers of every chip, each in its own namespace since they
+// all define tiu_reg_t/tdma_reg_t.
+//
+namespace cv181x {
+#include <cvikernel/cv181x/cv181x_tiu_reg.h>
+#include <cvikernel/cv181x/cv181x_tdma_reg.h>
+}
+
+namespace bm1822 {
+#include <bmkernel/bm1822/bm1822_tiu_reg.h>
+#include <bmkernel/bm1822/bm1822_tdma_reg.h>
+}
+
+namespace bm1880v2 {
+#include <bmkernel/bm1880v2/bm1880v2_tiu_reg.h>
+#include <bmkernel/bm1880v2/bm1880v2_tdma_reg.h>
+}
+
+typedef enum {
+  CHIP_UNKNOWN = 0,
+  CHIP_BM1880V2,
+  CHIP_BM1822,
+  CHIP_CV181X,
+  CHIP_CV180X,
+} chip_t;
+
+static inline chip_t chip_of_magic(uint8_t magic)
+{
+  switch (magic) {
+    case CMDBUF_HDR_MAGIC_1880v2:
+      return CHIP_BM1880V2;
+    case CMDBUF_HDR_MAGIC_1822:
+      return CHIP_BM1822;
+    case CMDBUF_HDR_MAGIC_181X:
+      return CHIP_CV181X;
+    case CMDBUF_HDR_MAGIC_180X:
+      return CHIP_CV180X;
+    default:
+      return CHIP_UNKNOWN;
+  }
+}
+
+static inline const char *chip_name(chip_t chip)
+{
+  switch (chip) {
+    case CHIP_BM1880V2:
+      return "bm1880v2";
+    case CHIP_BM1822:
+      return "bm1822";
+    case CHIP_CV181X:
+      return "cv181x";
+    case CHIP_CV180X:
+      return "cv180x";
+    default:
+      return "unknown";
+  }
+}
+
+//
+// Operation classes of the descriptors.
+//
+typedef enum {
+  TDMA_TENSOR = 0,
+  TDMA_MATRIX,
+  TDMA_GENERAL,       // linear byte copy
+  TDMA_FILL,          // constant fill
+  TDMA_TRANSPOSE,
+  TDMA_COMPRESSED,
+  NR_TDMA_KINDS,
+} tdma_kind_t;
+
+typedef enum {
+  OP_CONV = 0,
+  OP_DW_CONV,
+  OP_MAX_POOL,
+  OP_AVG_POOL,
+  OP_MIN_POOL,
+  OP_MATMUL,
+  OP_MUL,
+  OP_MAC,
+  OP_ADD,
+  OP_SUB,
+  OP_MAX,
+  OP_MIN,
+  OP_SHIFT,
+  OP_AND,
+  OP_OR,
+  OP_XOR,
+  OP_COPY,
+  OP_GE,
+  OP_LUT,
+  OP_TIU_OTHER,
+
+  // tdma, a direction times a kind
+  OP_TDMA,
+  NR_OPS = OP_TDMA + 4 * NR_TDMA_KINDS,
+} op_t;
+
+static inline const char *op_name(uint32_t op)
+{
+  static const char *tiu_names[] = {
+    "conv", "dw_conv", "max_pool", "avg_pool", "min_pool", "matmul",
+    "mul", "mac", "add", "sub", "max", "min", "shift", "and", "or", "xor",
+    "copy", "ge", "lut", "tiu_other",
+  };
+  static const char *tdma_names[4][NR_TDMA_KINDS] = {
+    { "g2l", "g2l_matrix", "g2l_general", "g2l_fill", "g2l_transpose",
+      "g2l_compressed" },
+    { "l2g", "l2g_matrix", "l2g_general", "l2g_fill", "l2g_transpose",
+      "l2g_compressed" },
+    { "g2g", "g2g_matrix", "g2g_general", "g2g_fill", "g2g_transpose",
+      "g2g_compressed" },
+    { "l2l", "l2l_matrix", "l2l_general", "l2l_fill", "l2l_transpose",
+      "l2l_compressed" },
+  };
+
+  if (op < OP_TDMA)
+    return tiu_names[op];
+  if (op < NR_OPS)
+    return tdma_names[(op - OP_TDMA) / NR_TDMA_KINDS]
+                     [(op - OP_TDMA) % NR_TDMA_KINDS];
+  return "unknown";
+}
+
+static inline const char *tdma_dir_name(uint32_t dir)
+{
+  static const char *names[4] = { "g2l", "l2g", "g2g", "l2l" };
+  return (dir < 4) ? names[dir] : "unknown";
+}
+
+#define NO_DESC 0xffffffff
+
+//
+// Summary of a tiu/tdma descriptor. regs is the aligned register copy,
+// valid only during the walk callback.
+//
+typedef struct {
+  uint32_t index;           // among the tiu/tdma descriptors
+  uint32_t offset;          // of the cmd_hdr_t, of the registers in a dmabuf
+  uint32_t segment;
+  uint32_t engine_id;
+  uint32_t layer_id;
+  uint32_t id;              // own sync id
+  uint32_t wait_id;         // of the other engine, 0 for none
+  uint32_t wait_desc;       // index of the waited descriptor or NO_DESC
+  uint32_t new_wait;        // wait_id past the last one of its engine in
+                            // the segment; the others repeat a wait
+                            // already met, the conductor carries it along
+  uint32_t op;
+  uint32_t double_conv;
+  uint32_t tdma_dir;
+  uint64_t tdma_bytes;
+  const uint32_t *regs;
+} cmdbuf_desc_t;
+
+template <typename TiuReg>
+static inline void decode_tiu(const TiuReg &r, cmdbuf_desc_t *d)
+{
+  d->layer_id = r.layer_info;
+  d->id = r.cmd_id_tpu;
+  d->wait_id = r.cmd_id_gdma;
+  d->double_conv = r.double_conv;
+
+  switch (r.tsk_typ) {
+    case DCR_TYPE_CONV_FIX8B:
+      d->op = OP_CONV;
+      break;
+    case DCR_TYPE_DEPTHWISE_POOL_FIX8B: {
+      static const uint32_t ops[] = {
+        OP_MAX_POOL, OP_AVG_POOL, OP_DW_CONV, OP_MIN_POOL
+      };
+      d->op = (r.tsk_eu_typ < 4) ? ops[r.tsk_eu_typ] : (uint32_t)OP_TIU_OTHER;
+      break;
+    }
+    case DCR_TYPE_FC_FIX8B:
+      d->op = OP_MATMUL;
+      break;
+    case DCR_TYPE_TENSOR_ARITH_FIX8B:
+      // TENSOR_MUL_FIX8B .. TENSOR_GE_FIX8B, then 12 for lookup tables.
+      d->op = (r.tsk_eu_typ <= 12) ? OP_MUL + r.tsk_eu_typ
+                                   : (uint32_t)OP_TIU_OTHER;
+      break;
+    default:
+      d->op = OP_TIU_OTHER;
+      break;
+  }
+}
+
+// Bytes moved, counted as the cv181x cost model does.
+template <typename TdmaReg>
+static inline void decode_tdma(const TdmaReg &r, cmdbuf_desc_t *d)
+{
+  uint64_t esize = (r.src_fmt == 2) ? 2 : 1;
+  int src_gmem = (r.trans_dir == 0 || r.trans_dir == 2);
+  uint32_t kind;
+
+  d->layer_id = r.layer_ID;
+  d->id = r.cmd_id;
+  d->wait_id = r.wait_id_tpu;
+  d->tdma_dir = r.trans_dir & 3;
+
+  if (r.trans_fmt) {
+    kind = TDMA_GENERAL;
+    d->tdma_bytes = r.src_n_stride;
+  } else if (r.spec_func == 4) {
+    kind = TDMA_FILL;
+    d->tdma_bytes = (uint64_t)r.src_n * r.dst_c * r.dst_h * r.dst_w * esize;
+  } else if (r.sys_dtype) {
+    kind = TDMA_MATRIX;
+    d->tdma_bytes = src_gmem ? (uint64_t)r.src_n * r.src_w * esize
+                             : (uint64_t)r.dst_c * r.dst_w * esize;
+  } else {
+    kind = (r.spec_func == 1 && r.transpose_md) ? TDMA_TRANSPOSE : TDMA_TENSOR;
+    d->tdma_bytes = (uint64_t)r.src_n * r.src_c * r.src_h * r.src_w * esize;
+  }
+
+  if (r.compress_en)
+    kind = TDMA_COMPRESSED;
+
+  d->op = OP_TDMA + d->tdma_dir * NR_TDMA_KINDS + kind;
+}
+
+// cv180x descriptors are laid out as the cv181x ones.
+static inline void decode_desc(chip_t chip, cmdbuf_desc_t *d)
+{
+  if (d->engine_id == CVI_TPU_TIU) {
+    if (chip == CHIP_BM1880V2) {
+      bm1880v2::tiu_reg_t r;
+      bm1880v2::parse_tiu_reg(&r, d->regs);
+      decode_tiu(r, d);
+    } else if (chip == CHIP_BM1822) {
+      bm1822::tiu_reg_t r;
+      bm1822::parse_tiu_reg(&r, d->regs);
+      decode_tiu(r, d);
+    } else {
+      cv181x::tiu_reg_t r;
+      cv181x::parse_tiu_reg(&r, d->regs);
+      decode_tiu(r, d);
+    }
+  } else {
+    if (chip == CHIP_BM1880V2) {
+      bm1880v2::tdma_reg_t r;
+      bm1880v2::parse_tdma_reg(&r, d->regs);
+      decode_tdma(r, d);
+    } else if (chip == CHIP_BM1822) {
+      bm1822::tdma_reg_t r;
+      bm1822::parse_tdma_reg(&r, d->regs);
+      decode_tdma(r, d);
+    } else {
+      cv181x::tdma_reg_t r;
+      cv181x::parse_tdma_reg(&r, d->regs);
+      decode_tdma(r, d);
+    }
+  }
+}
+
+//
+// Calls fn(name, value) for every register field of a descriptor.
+//
+template <typename Fn>
+static inline void for_each_field(chip_t chip, const cmdbuf_desc_t &d, Fn fn)
+{
+#define FIELD(name) fn(#name, (uint64_t)r.name);
+  if (d.engine_id == CVI_TPU_TIU) {
+    if (chip == CHIP_BM1880V2) {
+      bm1880v2::tiu_reg_t r;
+      bm1880v2::parse_tiu_reg(&r, d.regs);
+      BM1880V2_TIU_FIELDS(FIELD)
+    } else if (chip == CHIP_BM1822) {
+      bm1822::tiu_reg_t r;
+      bm1822::parse_tiu_reg(&r, d.regs);
+      CV181X_TIU_FIELDS(FIELD)
+    } else {
+      cv181x::tiu_reg_t r;
+      cv181x::parse_tiu_reg(&r, d.regs);
+      CV181X_TIU_FIELDS(FIELD)
+    }
+  } else {
+    if (chip == CHIP_BM1880V2) {
+      bm1880v2::tdma_reg_t r;
+      bm1880v2::parse_tdma_reg(&r, d.regs);
+      BM1880V2_TDMA_FIELDS(FIELD)
+    } else if (chip == CHIP_BM1822) {
+      bm1822::tdma_reg_t r;
+      bm1822::parse_tdma_reg(&r, d.regs);
+      CV181X_TDMA_FIELDS(FIELD)
+    } else {
+      cv181x::tdma_reg_t r;
+      cv181x::parse_tdma_reg(&r, d.regs);
+      CV181X_TDMA_FIELDS(FIELD)
+    }
+  }
+#undef FIELD
+}
+
+//
+// Sync ids seen in the current segment, to find the waited descriptors
+// and the waits that are new.
+//
+typedef struct {
+  std::vector<uint32_t> by_id[CVI_TPU_ENGINE_NUM];
+  uint32_t last_wait[CVI_TPU_ENGINE_NUM] = {0};
+
+  void reset() {
+    for (uint32_t i = 0; i < CVI_TPU_ENGINE_NUM; i++) {
+      by_id[i].clear();
+      last_wait[i] = 0;
+    }
+  }
+
+  void add(cmdbuf_desc_t *d) {
+    uint32_t other = (d->engine_id == CVI_TPU_TIU) ? CVI_TPU_TDMA : CVI_TPU_TIU;
+    d->wait_desc = NO_DESC;
+    if (d->wait_id && d->wait_id < by_id[other].size())
+      d->wait_desc = by_id[other][d->wait_id];
+
+    d->new_wait = (d->wait_id > last_wait[d->engine_id]);
+    if (d->new_wait)
+      last_wait[d->engine_id] = d->wait_id;
+
+    std::vector<uint32_t> &own = by_id[d->engine_id];
+    if (own.size() <= d->id)
+      own.resize(d->id + 1, NO_DESC);
+    own[d->id] = d->index;
+  }
+} desc_ids_t;
+
+//
+// Walks the tiu/tdma descriptors of a cmdbuf, calling fn(const
+// cmdbuf_desc_t &). Sync ids restart after a cpu descriptor or an own id
+// of 0xffff, where the segment ends. Returns the number of segments or
+// -1 for a malformed cmdbuf.
+//
+template <typename Fn>
+static int cmdbuf_walk(const uint8_t *buf, size_t size, chip_t *chip, Fn fn)
+{
+  // Room for the largest descriptor, zero past a short one.
+  uint32_t regs[TIU_ENGINE_DESCRIPTOR_NUM];
+  desc_ids_t ids;
+  uint32_t nr = 0, segment = 0, cpu_only = 1;
+  size_t off = 0;
+
+  *chip = (size >= sizeof(cmd_hdr_t)) ? chip_of_magic(buf[0]) : CHIP_UNKNOWN;
+  if (*chip == CHIP_UNKNOWN) {
+    fprintf(stderr, "unknown cmdbuf magic\n");
+    return -1;
+  }
+
+  while (off < size) {
+    const cmd_hdr_t *hdr = (const cmd_hdr_t *)(buf + off);
+    uint32_t len = 0;
+
+    if (size - off >= sizeof(*hdr))
+      len = hdr->len ? hdr->len : hdr->mask;
+
+    if (!len || chip_of_magic(hdr->magic) != *chip ||
+        len > size - off - sizeof(*hdr)) {
+      fprintf(stderr, "malformed cmdbuf at offset %zu\n", off);
+      return -1;
+    }
+
+    if (hdr->engine_id != CVI_TPU_TIU && hdr->engine_id != CVI_TPU_TDMA) {
+      ids.reset();
+      segment += !cpu_only;
+      cpu_only = 1;
+      off += sizeof(*hdr) + len;
+      continue;
+    }
+
+    uint32_t n = (len < sizeof(regs)) ? len : sizeof(regs);
+    memcpy(regs, hdr->cmd, n);
+    memset((uint8_t *)regs + n, 0, sizeof(regs) - n);
+
+    cmdbuf_desc_t d;
+    memset(&d, 0, sizeof(d));
+    d.index = nr++;
+    d.offset = (uint32_t)off;
+    d.segment = segment;
+    d.engine_id = hdr->engine_id;
+    d.regs = regs;
+    decode_desc(*chip, &d);
+    ids.add(&d);
+
+    fn(d);
+
+    if (d.id == 0xffff) {
+      ids.reset();
+      segment++;
+      cpu_only = 1;
+    } else {
+      cpu_only = 0;
+    }
+
+    off += sizeof(*hdr) + len;
+  }
+
+  return segment + !cpu_only;
+}
+
+//
+// dmabuf, as written by dmabuf_convert:
+//
+//   dma_hdr_t | cpu sync descs | tiu descs + eod padding | tdma descs
+//
+// Each cpu sync desc holds the tiu/tdma regions of one segment. Relocation
+// turns them into device addresses, keeps the offsets in reserved[] and
+// sets pmubuf_offset.
+//
+#define DMABUF_MAGIC_M            0xB5B5
+#define DMABUF_TDMA_DESC_SIZE     (1 << TDMA_DESCRIPTOR_ALIGNED_BIT)
+
+static inline chip_t chip_of_dmabuf_magic(uint16_t magic_s)
+{
+  switch (magic_s) {
+    case 0x1835:
+      return CHIP_BM1880V2;
+    case 0x1822:
+      return CHIP_BM1822;
+    case 0x1810:
+      return CHIP_CV181X;
+    case 0x1800:
+      return CHIP_CV180X;
+    default:
+      return CHIP_UNKNOWN;
+  }
+}
+
+// Undoes the tiu register reorder of dmabuf_convert, which swaps the
+// first and last 128-bit words and tags each with its index in the top
+// nibble. From bm1822 on reset_tiu_reg() puts the same index there, on
+// bm1880v2 those bits are reserved and zero.
+static inline void read_dmabuf_tiu(chip_t chip, const uint8_t *p,
+                                   uint32_t *regs)
+{
+  uint8_t *desc = (uint8_t *)regs;
+  const int nr_words = BD_REG_BYTES / 16;
+
+  memcpy(desc, p + (nr_words - 1) * 16, 16);
+  memcpy(desc + 16, p + 16, (nr_words - 2) * 16);
+  memcpy(desc + (nr_words - 1) * 16, p, 16);
+
+  if (chip == CHIP_BM1880V2)
+    for (int i = 0; i < nr_words; i++)
+      desc[i * 16 + 15] &= 0x0f;
+}
+
+//
+// Walks the tiu/tdma descriptors of a dmabuf like cmdbuf_walk. The engines
+// are kept apart in a dmabuf, so descriptors of a segment are visited in
+// an order their waits allow: tiu first while its wait is met, tdma next.
+//
+template <typename Fn>
+static int dmabuf_walk(const uint8_t *buf, size_t size, chip_t *chip, Fn fn)
+{
+  const dma_hdr_t *hdr = (const dma_hdr_t *)buf;
+  uint32_t regs[CVI_TPU_ENGINE_NUM][TIU_ENGINE_DESCRIPTOR_NUM];
+  desc_ids_t ids;
+  uint32_t nr = 0;
+
+  *chip = CHIP_UNKNOWN;
+  if (size >= sizeof(*hdr) && hdr->dmabuf_magic_m == DMABUF_MAGIC_M)
+    *chip = chip_of_dmabuf_magic(hdr->dmabuf_magic_s);
+
+  if (*chip == CHIP_UNKNOWN ||
+      (uint64_t)hdr->cpu_desc_count * CPU_ENGINE_BYTES >
+          size - sizeof(*hdr)) {
+    fprintf(stderr, "malformed dmabuf header\n");
+    return -1;
+  }
+
+  const bmk_cpu_sync_desc_t *segments =
+      (const bmk_cpu_sync_desc_t *)(buf + sizeof(*hdr));
+  int relocated = (hdr->pmubuf_offset != 0);
+
+  for (uint32_t i = 0; i < hdr->cpu_desc_count; i++) {
+    const bmk_cpu_sync_desc_t *seg = &segments[i];
+    uint32_t num[CVI_TPU_ENGINE_NUM] = {0};
+    uint32_t next[CVI_TPU_ENGINE_NUM] = {0};
+    uint32_t base[CVI_TPU_ENGINE_NUM] = {0};
+    cmdbuf_desc_t d[CVI_TPU_ENGINE_NUM];
+
+    num[CVI_TPU_TIU] = seg->num_bd & 0xffff;
+    num[CVI_TPU_TDMA] = seg->num_gdma & 0xffff;
+    if (num[CVI_TPU_TIU])
+      base[CVI_TPU_TIU] = relocated ? seg->reserved[0] : seg->offset_bd;
+    if (num[CVI_TPU_TDMA])
+      base[CVI_TPU_TDMA] = relocated ? seg->reserved[1] : seg->offset_gdma;
+
+    if ((uint64_t)base[CVI_TPU_TIU] + (uint64_t)num[CVI_TPU_TIU] *
+            BD_REG_BYTES > size ||
+        (uint64_t)base[CVI_TPU_TDMA] + (uint64_t)num[CVI_TPU_TDMA] *
+            DMABUF_TDMA_DESC_SIZE > size) {
+      fprintf(stderr, "dmabuf segment %u out of range\n", i);
+      return -1;
+    }
+
+    // Decoded head of each engine.
+    for (uint32_t e = 0; e < CVI_TPU_ENGINE_NUM; e++) {
+      if (e == CVI_TPU_CPU || !num[e])
+        continue;
+
+      memset(&d[e], 0, sizeof(d[e]));
+      d[e].engine_id = e;
+      d[e].segment = i;
+      d[e].regs = regs[e];
+      d[e].offset = base[e];
+      if (e == CVI_TPU_TIU)
+        read_dmabuf_tiu(*chip, buf + d[e].offset, regs[e]);
+      else
+        memcpy(regs[e], buf + d[e].offset, TDMA_DESC_REG_BYTES);
+      decode_desc(*chip, &d[e]);
+    }
+
+    ids.reset();
+    while (next[CVI_TPU_TIU] < num[CVI_TPU_TIU] ||
+           next[CVI_TPU_TDMA] < num[CVI_TPU_TDMA]) {
+      uint32_t e = CVI_TPU_TDMA;
+      if (next[CVI_TPU_TIU] < num[CVI_TPU_TIU] &&
+          (next[CVI_TPU_TDMA] == num[CVI_TPU_TDMA] ||
+           d[CVI_TPU_TIU].wait_id <= next[CVI_TPU_TDMA]))
+        e = CVI_TPU_TIU;
+
+      d[e].index = nr++;
+      ids.add(&d[e]);
+      fn(d[e]);
+
+      if (++next[e] == num[e])
+        continue;
+
+      cmdbuf_desc_t &n = d[e];
+      uint32_t offset = n.offset;
+      memset(&n, 0, sizeof(n));
+      n.engine_id = e;
+      n.segment = i;
+      n.regs = regs[e];
+      if (e == CVI_TPU_TIU) {
+        n.offset = offset + BD_REG_BYTES;
+        read_dmabuf_tiu(*chip, buf + n.offset, regs[e]);
+      } else {
+        n.offset = offset + DMABUF_TDMA_DESC_SIZE;
+        memcpy(regs[e], buf + n.offset, TDMA_DESC_REG_BYTES);
+      }
+      decode_desc(*chip, &n);
+    }
+  }
+
+  return hdr->cpu_desc_count;
+}
+
+static inline int is_dmabuf(const uint8_t *buf, size_t size)
+{
+  return size >= sizeof(dma_hdr_t) &&
+         ((const dma_hdr_t *)buf)->dmabuf_magic_m == DMABUF_MAGIC_M;
+}
+
+// Chip of a cmdbuf or dmabuf from its magic.
+static inline chip_t chip_of_buf(const uint8_t *buf, size_t size)
+{
+  if (is_dmabuf(buf, size))
+    return chip_of_dmabuf_magic(((const dma_hdr_t *)buf)->dmabuf_magic_s);
+  if (size >= sizeof(cmd_hdr_t))
+    return chip_of_magic(buf[0]);
+  return CHIP_UNKNOWN;
+}
+
+// Walks a cmdbuf or a dmabuf, told apart by their magic.
+template <typename Fn>
+static int desc_walk(const uint8_t *buf, size_t size, chip_t *chip, Fn fn)
+{
+  if (is_dmabuf(buf, size))
+    return dmabuf_walk(buf, size, chip, fn);
+
+  return cmdbuf_walk(buf, size, chip, fn);
+}
+
+//
+// Context of the chip for the misc ops that read its descriptors, such as
+// desc_cost or pmu_decode, NULL on a chip without a backend providing
+// them. cv181x/cv180x contexts grow their own cmdbuf on demand, bm1822
+// ones get a small cmdbuf nothing is emitted into.
+//
+static inline cvk_context_t *chip_context(chip_t chip)
+{
+  static uint8_t cmdbuf_1822[0x1000];
+  cvk_reg_info_t info;
+  const char *version;
+
+  memset(&info, 0, sizeof(info));
+  switch (chip) {
+    case CHIP_CV181X:
+    case CHIP_CV180X:
+      version = chip_name(chip);
+      break;
+    case CHIP_BM1822:
+      version = CVI_TPU_VERSION_182X;
+      info.cmdbuf = cmdbuf_1822;
+      info.cmdbuf_size = sizeof(cmdbuf_1822);
+      break;
+    default:
+      return NULL;
+  }
+  strncpy(info.chip_ver_str, version, sizeof(info.chip_ver_str) - 1);
+
+  return cvikernel_register(&info);
+}
+
+static inline void free_chip_context(cvk_context_t *ctx)
+{
+  if (ctx) {
+    ctx->ops->cleanup(ctx);
+    free(ctx);
+  }
+}
+
+//
+// Read only mapping of a whole file.
+//
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+} mapped_file_t;
+
+static inline int map_file(const char *path, mapped_file_t *f)
+{
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+
+  f->data = NULL;
+  f->size = 0;
+
+  if (fd < 0 || fstat(fd, &st)) {
+    fprintf(stderr, "cannot open %s\n", path);
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+
+  if (st.st_size) {
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      fprintf(stderr, "cannot map %s\n", path);
+      close(fd);
+      return -1;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    f->data = (const uint8_t *)p;
+    f->size = st.st_size;
+  }
+
+  close(fd);
+  return 0;
+}
+
+static inline void unmap_file(mapped_file_t *f)
+{
+  if (f->data)
+    munmap((void *)f->data, f->size);
+  f->data = NULL;
+  f->size = 0;
+}
+
+#endif /* READCMDBUF_CMDBUF_READER_H */
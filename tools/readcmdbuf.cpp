@@ -1,361 +1,655 @@
+//
+// readcmdbuf, per layer summary of a bm1880v2/bm1822/cv181x/cv180x cmdbuf
+// or dmabuf.
+//
+// The file is mapped and walked once, descriptors are decoded with the
+// register parsers of the chip. Reports the op mix, descriptor counts,
+// tdma bytes and the sync waits of every layer as text, JSON or CSV, and
+// with -d every register field of every descriptor. With -p the pmu
+// buffer dumped after a run of a cv181x/cv180x dmabuf adds the busy time
+// of each engine per layer, see pmu_decode.
+//
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdint.h>
 #include <string.h>
-#include <fstream>
-#include <glog/logging.h>
-#ifdef BM1880v2
-#include <map>
-#include <iostream>
+#include <unistd.h>
 #include <string>
-#include "../src/bm1880v2/kernel_1880v2.h"
-//#include "../../include/builder/Builder.hpp"
-#include <fcntl.h>
-#include <fstream>  // NOLINT(readability/streams)
-#include <google/protobuf/io/coded_stream.h>
-#include <google/protobuf/io/zero_copy_stream_impl.h>
-#include <google/protobuf/text_format.h>
-using namespace std;
+#include <vector>
+#include <unordered_map>
+#include "cmdbuf_reader.h"
+
+typedef enum {
+  FMT_TEXT = 0,
+  FMT_JSON,
+  FMT_CSV,
+} out_fmt_t;
+
+//
+// Buffered output, the descriptor dumps are too large for stdio formatting.
+//
+class out_t {
+ public:
+  explicit out_t(FILE *fp) : fp_(fp) { buf_.reserve(kFlushSize * 2); }
+  ~out_t() { flush(); }
+
+  out_t &str(const char *s) {
+    buf_.append(s);
+    return may_flush();
+  }
+
+  out_t &str(const std::string &s) {
+    buf_.append(s);
+    return may_flush();
+  }
+
+  out_t &chr(char c) {
+    buf_.push_back(c);
+    return may_flush();
+  }
+
+  out_t &u64(uint64_t v) {
+    char tmp[24];
+    int n = 0;
+    do {
+      tmp[n++] = '0' + v % 10;
+      v /= 10;
+    } while (v);
+    while (n)
+      buf_.push_back(tmp[--n]);
+    return may_flush();
+  }
+
+  // Right aligned in width columns, for the text tables.
+  out_t &u64(uint64_t v, int width) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)v);
+    for (; n < width; n++)
+      buf_.push_back(' ');
+    return str(tmp);
+  }
 
-using google::protobuf::io::FileInputStream;
+  // Three decimals, right aligned in width columns if given.
+  out_t &fixed(double v, int width = 0) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "%*.3f", width, v);
+    return str(tmp);
+  }
+
+  out_t &json_str(const std::string &s) {
+    buf_.push_back('"');
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        buf_.push_back('\\');
+        buf_.push_back(c);
+      } else if ((unsigned char)c < 0x20) {
+        char tmp[8];
+        snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+        buf_.append(tmp);
+      } else {
+        buf_.push_back(c);
+      }
+    }
+    buf_.push_back('"');
+    return may_flush();
+  }
 
-#else /* ! if defined(CHIP) && CHIP == BM1880v2*/
+  void flush() {
+    if (!buf_.empty())
+      fwrite(buf_.data(), 1, buf_.size(), fp_);
+    buf_.clear();
+  }
 
-#include <bmkernel/bm_kernel_legacy.h>
-#endif /* if defined(CHIP) && CHIP == BM1880v2*/
+ private:
+  static const size_t kFlushSize = 1 << 20;
 
-int get_file_length(std::fstream& f)
+  out_t &may_flush() {
+    if (buf_.size() >= kFlushSize)
+      flush();
+    return *this;
+  }
+
+  FILE *fp_;
+  std::string buf_;
+};
+
+typedef struct {
+  uint32_t layer_id;
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  uint32_t nr_double_conv;
+  uint32_t nr_waits;        // new waits on the other engine, see new_wait
+  uint32_t wait_chain;      // longest run of waits within the layer
+  uint64_t tdma_bytes[4];   // by direction
+  uint32_t ops[NR_OPS];
+
+  // With -p, cycles as in cvk_pmu_layer_t.
+  uint32_t nr_pmu_events;
+  uint64_t tiu_busy;
+  uint64_t tdma_busy;
+  uint64_t overlap;
+  uint64_t span;
+  float overlap_ratio;
+} layer_stats_t;
+
+typedef struct {
+  chip_t chip;
+  int dmabuf;
+  uint64_t size;
+  uint32_t nr_segments;
+  uint32_t nr_tiu;
+  uint32_t nr_tdma;
+  int has_pmu;
+  uint32_t nr_pmu_events;
+  uint32_t nr_pmu_unmatched;                  // matching no descriptor
+  std::vector<layer_stats_t> layers;          // in order of appearance
+  std::unordered_map<uint32_t, std::string> names;
+} report_t;
+
+static void usage(const char *prog)
 {
-  f.seekg (0, f.end);
-  int length = f.tellg();
-  f.seekg (0, f.beg);
-  return length;
+  printf("Usage: %s [-f text|json|csv] [-d] [-m layer_map.csv] "
+         "[-p pmu.bin] [-o out] cmdbuf.bin|dmabuf.bin\n", prog);
+  printf("  -f  output format, text by default\n");
+  printf("  -d  dump every register field of every descriptor\n");
+  printf("  -m  \"layer_id,name\" lines naming the layers\n");
+  printf("  -p  pmu buffer dumped after a run of the dmabuf\n");
+  printf("  -o  output file, stdout by default\n");
 }
 
-#if defined(CHIP) && CHIP == BM1880v2
-static int bm1880v2_get_engine_desc_length(uint32_t engine_id)
+static int read_layer_map(
+    const char *path,
+    std::unordered_map<uint32_t, std::string> &names)
 {
-  switch (engine_id) {
-    case BMK1880v2_TIU:
-      return TIU_ENGINE_DESCRIPTOR_NUM * sizeof(uint32_t);
-    case BMK1880v2_TDMA:
-      return TDMA_ENGINE_DESCRIPTOR_NUM * sizeof(uint32_t);
-    case BMK1880v2_CPU:
-      return CPU_ENGINE_DESCRIPTOR_NUM * sizeof(uint32_t);
-    default:
-      ASSERT(0);
-  }
-}
-static void parseCmdBuf(char* cmdbuf_path, map<int, string> & map_layer_id_name,
-    char* output_file_path) {
-
-  std::fstream f_cmdbuf(cmdbuf_path, std::ios::in | std::ios::binary);
-
-  size_t i = 0;
-  size_t cmdbuf_size = get_file_length(f_cmdbuf);
-  //printf("cmdbuf size %zu\n", cmdbuf_size);
-  uint8_t *cmdbuf = new uint8_t[cmdbuf_size];
-  uint32_t *buf = (uint32_t *)cmdbuf;
-
-  std::ofstream output_file_path_fp;
-  output_file_path_fp.open(output_file_path);
-  f_cmdbuf.read((char *)cmdbuf, cmdbuf_size);
-
-  while(i < cmdbuf_size / 4) {
-    cmd_hdr_t *hdr;
-    hdr = (cmd_hdr_t *)(&buf[i]);
-    i += sizeof(cmd_hdr_t) / 4;
-    const uint32_t *cmd = (uint32_t*)&buf[i];
-    ASSERT(hdr->magic == BM_CMB_HDR_MAGIC);
-    uint32_t eng_id = hdr->engine_id;
-    //uint32_t cmd_len = cmd_hdr_len(hdr) / 4;
-    uint32_t cmd_len = bm1880v2_get_engine_desc_length(eng_id) / 4;
-    i += cmd_len;
-
-    switch (eng_id) {
-      case BMK1880v2_TIU:
-        {
-          tiu_reg_t tiuTempReg;
-          int layer_id;
-          string mappined = "";
-          map<int, string>::iterator iter;
-
-          parse_tiu_reg(&tiuTempReg, cmd);
-          layer_id = tiuTempReg.rsvd3;
-
-          if (output_file_path) {
-            iter = map_layer_id_name.find(layer_id);
-
-            if (iter != map_layer_id_name.end()) {
-              mappined = iter->second;
-              output_file_path_fp << tiuTempReg.cmd_id_tpu << "," << mappined << "\n";
-            }
-          }
-          LOG(INFO) << "CMD [BD  ], <" <<
-            tiuTempReg.cmd_id_tpu
-            << ">, len " << cmd_len;
-        }
-        break;
-    case BMK1880v2_TDMA:
-        {
-          tdma_reg_t tdma_reg;
-          parse_tdma_reg(&tdma_reg, cmd);
-          LOG(INFO) << "[GDMA ], <" << tdma_reg.cmd_id
-            << ">, len " << cmd_len;
-        }
-        break;
-    case BMK1880v2_CPU:
-        LOG(INFO) << "[CPU], ";
-        break;
-    default:
-        CHECK(0) << "impossible eng_id " << eng_id << " not found";
-    }
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return -1;
   }
 
-  if (output_file_path) {
-    output_file_path_fp.close();
+  char line[1024];
+  while (fgets(line, sizeof(line), fp)) {
+    char *end;
+    unsigned long id = strtoul(line, &end, 10);
+    if (end == line || *end != ',')
+      continue;
+
+    std::string name(end + 1);
+    while (!name.empty() && (name.back() == '\n' || name.back() == '\r'))
+      name.pop_back();
+    names[id] = name;
   }
+
+  fclose(fp);
+  return 0;
 }
 
-static void read_bm1880v2_cmd(char* cmdbuf_path, char* layer_id_name_mapping_file_path,
-  char* output_file_path) {
-  string line;
-  map<int, string> map_layer_id_name;
-  map<int, string>::iterator iter;
+// Busy time of the engines per layer from the pmu records of a run of the
+// dmabuf, layers only seen there are appended.
+static int read_pmu(const char *path, const mapped_file_t &dmabuf,
+                    std::vector<int32_t> &layer_index, report_t &r)
+{
+  if (!r.dmabuf) {
+    fprintf(stderr, "-p needs a dmabuf\n");
+    return -1;
+  }
 
-  if (layer_id_name_mapping_file_path) {
-    std::ifstream file(layer_id_name_mapping_file_path);
+  cvk_context_t *ctx = chip_context(r.chip);
+  if (!ctx || !ctx->misc_ops->pmu_decode) {
+    fprintf(stderr, "no pmu records on %s\n", chip_name(r.chip));
+    free_chip_context(ctx);
+    return -1;
+  }
 
-    if (file.fail()) {
-      CHECK(0) << "File not found: " << cmdbuf_path;
-    }
+  mapped_file_t pmu;
+  if (map_file(path, &pmu)) {
+    free_chip_context(ctx);
+    return -1;
+  }
 
-    while (getline(file, line)) {
-      istringstream templine(line);
-      string data;
-      int group_id;
-      while (getline(templine, data,',')) {
-        group_id = atof(data.c_str());
-        break;
-      }
-      map_layer_id_name[group_id] = line;
+  int ret = -1;
+  std::vector<cvk_pmu_event_t> events(pmu.size / CVK_PMU_RECORD_BYTES);
+  std::vector<cvk_pmu_layer_t> layers;
+  uint32_t nr_events = 0, nr_layers = 0;
+
+  if (dmabuf.size > UINT32_MAX || pmu.size > UINT32_MAX) {
+    fprintf(stderr, "%s too large\n", (pmu.size > UINT32_MAX) ? path : "dmabuf");
+  } else if (ctx->misc_ops->pmu_decode(ctx, dmabuf.data, dmabuf.size,
+                                       pmu.data, pmu.size, events.data(),
+                                       events.size(), &nr_events)) {
+    fprintf(stderr, "cannot decode %s\n", path);
+  } else {
+    layers.resize(1 << 16);
+    nr_layers = ctx->misc_ops->pmu_layer_report(
+        ctx, events.data(), nr_events, layers.data(), layers.size());
+    ret = 0;
+  }
+
+  for (uint32_t i = 0; i < nr_events; i++)
+    r.nr_pmu_unmatched += (events[i].desc_index == CVK_PMU_NO_DESC);
+  r.nr_pmu_events = nr_events;
+  r.has_pmu = (ret == 0);
+
+  for (uint32_t i = 0; i < nr_layers; i++) {
+    const cvk_pmu_layer_t &pl = layers[i];
+    if (layer_index[pl.layer_id] < 0) {
+      layer_index[pl.layer_id] = r.layers.size();
+      layer_stats_t l;
+      memset(&l, 0, sizeof(l));
+      l.layer_id = pl.layer_id;
+      r.layers.push_back(l);
     }
 
-  //for(iter = map_layer_id_name.begin(); iter != map_layer_id_name.end(); iter++) {
-  //  cout<<iter->first<<" "<<iter->second<<endl;
-  //}
+    layer_stats_t &l = r.layers[layer_index[pl.layer_id]];
+    l.nr_pmu_events = pl.nr_tiu + pl.nr_tdma;
+    l.tiu_busy = pl.tiu_busy;
+    l.tdma_busy = pl.tdma_busy;
+    l.overlap = pl.overlap;
+    l.span = pl.span;
+    l.overlap_ratio = pl.overlap_ratio;
   }
 
-  parseCmdBuf(cmdbuf_path, map_layer_id_name, output_file_path);
+  unmap_file(&pmu);
+  free_chip_context(ctx);
+  return ret;
+}
 
+static std::string layer_name(const report_t &r, uint32_t layer_id)
+{
+  auto it = r.names.find(layer_id);
+  return (it != r.names.end()) ? it->second : std::string();
 }
-#else /* ! if defined(CHIP) && CHIP == BM1880v2*/
 
-#define DETAILED_CMD
-#undef DETAILED_CMD
-static inline int desc_get_bd_dcr_type(void *desc)
+//
+// Descriptor dumps, written while walking.
+//
+static void dump_desc_text(out_t &out, chip_t chip, const cmdbuf_desc_t &d)
 {
-  uint32_t *r = (uint32_t *)desc;
-  return (r[BD_CMD_REGI1] >> 8) & 0xff;
+  out.str((d.engine_id == CVI_TPU_TIU) ? "[tiu ] #" : "[tdma] #").u64(d.index)
+     .str(" layer ").u64(d.layer_id).str(" ").str(op_name(d.op))
+     .str(" id ").u64(d.id).str(" wait ").u64(d.wait_id).chr('\n');
+
+  for_each_field(chip, d, [&](const char *name, uint64_t v) {
+    out.str("  ").str(name).str(" = ").u64(v).chr('\n');
+  });
 }
 
-static const char* desc_get_md_scale_op(void *desc)
+static void dump_desc_json(out_t &out, chip_t chip, const cmdbuf_desc_t &d)
 {
-  uint32_t *r = (uint32_t *)desc;
-  int op = (r[BD_CMD_REGI2] >> 19) & 0x3;
-  switch(op) {
-    case 0: return "ADD";
-    case 1: return "SUB";
-    case 2: return "MUL";
-    case 3: return "DIV";
-    default: return "UNKOWN";
-  }
+  if (d.index)
+    out.str(",\n");
+
+  out.str("{\"index\": ").u64(d.index)
+     .str(", \"offset\": ").u64(d.offset)
+     .str(", \"engine\": \"").str((d.engine_id == CVI_TPU_TIU) ? "tiu" : "tdma")
+     .str("\", \"layer_id\": ").u64(d.layer_id)
+     .str(", \"op\": \"").str(op_name(d.op))
+     .str("\", \"id\": ").u64(d.id)
+     .str(", \"wait_id\": ").u64(d.wait_id)
+     .str(", \"regs\": {");
+
+  bool first = true;
+  for_each_field(chip, d, [&](const char *name, uint64_t v) {
+    out.str(first ? "\"" : ", \"").str(name).str("\": ").u64(v);
+    first = false;
+  });
+
+  out.str("}}");
 }
 
-static inline void desc_get_cmd_id(
-    void *desc, int engine_id, uint32_t cmd_len,
-    uint32_t& bd_cmd_id, uint32_t& gdma_cmd_id)
+// Rows hold the tiu fields then the tdma fields, empty for the other
+// engine.
+static uint32_t nr_fields(chip_t chip, uint32_t engine_id)
 {
-  uint32_t *r = (uint32_t *)desc;
-  if(ENGINE_BD == engine_id) {
-    if (cmd_len == 28) { // bd len = 28 in bm1880
-      uint64_t data = ((uint64_t*)desc)[0];
-      bd_cmd_id = ( data >> 3) & 0x0ffff;
-      gdma_cmd_id = (data >> 19) & 0x0ffff;
-    } else {
-      bd_cmd_id = (r[BD_CMD_REGI1] >> 16) & 0x0ffff;
-      gdma_cmd_id = (r[BD_CMD_REGI23] >> 16) & 0x0ffff;
-    }
-  } else if(ENGINE_GDMA == engine_id) {
-    bd_cmd_id = (r[GDMA_CMD_ACCPI1] >> 16) & 0x0ffff;
-    gdma_cmd_id = (r[GDMA_CMD_ACCPI0] >> 16) & 0x0ffff;
-  }
+  uint32_t regs[TIU_ENGINE_DESCRIPTOR_NUM] = {0};
+  cmdbuf_desc_t d;
+  uint32_t n = 0;
+
+  memset(&d, 0, sizeof(d));
+  d.engine_id = engine_id;
+  d.regs = regs;
+  for_each_field(chip, d, [&](const char *, uint64_t) { n++; });
+
+  return n;
 }
 
-static void parse_gdma_operand_addr(void *desc, uint64_t& src, uint64_t& dst) {
-  uint32_t *r = (uint32_t *)desc;
-  src = 0;
-  dst = 0;
-  int direction = (int)((r[GDMA_CMD_ACCPI0] >> GDMA_ACCPI0_DIRECTION_BIT) & 0x3);
-  switch (direction){
-    case GDMA_DIR_S2L:
-      src = r[GDMA_CMD_ACCPI12] + (((uint64_t)(r[GDMA_CMD_ACCPI13] & 0xff000000)) << 8);
-      dst = r[GDMA_CMD_ACCPI11];
-      break;
-    case GDMA_DIR_L2S:
-      src = r[GDMA_CMD_ACCPI12];
-      dst = r[GDMA_CMD_ACCPI11] + (((uint64_t)(r[GDMA_CMD_ACCPI13] & 0x00ff0000)) << 16);
-      break;
-    case GDMA_DIR_S2S:
-      src = r[GDMA_CMD_ACCPI12] + (((uint64_t)(r[GDMA_CMD_ACCPI13] & 0xff000000)) << 8);
-      dst = r[GDMA_CMD_ACCPI11] + (((uint64_t)(r[GDMA_CMD_ACCPI13] & 0x00ff0000)) << 16);
-      break;
-    case GDMA_DIR_L2L:
-      src = r[GDMA_CMD_ACCPI12];
-      dst = r[GDMA_CMD_ACCPI11];
-      break;
-    default:
-      break;
+static void dump_desc_csv_header(out_t &out, chip_t chip)
+{
+  uint32_t regs[TIU_ENGINE_DESCRIPTOR_NUM] = {0};
+  cmdbuf_desc_t d;
+
+  memset(&d, 0, sizeof(d));
+  d.regs = regs;
+  out.str("index,offset,engine,layer_id,op,id,wait_id");
+
+  d.engine_id = CVI_TPU_TIU;
+  for_each_field(chip, d, [&](const char *name, uint64_t) {
+    out.str(",tiu.").str(name);
+  });
+  d.engine_id = CVI_TPU_TDMA;
+  for_each_field(chip, d, [&](const char *name, uint64_t) {
+    out.str(",tdma.").str(name);
+  });
+
+  out.chr('\n');
+}
+
+static void dump_desc_csv(out_t &out, chip_t chip, const cmdbuf_desc_t &d,
+                          uint32_t nr_tiu_fields, uint32_t nr_tdma_fields)
+{
+  out.u64(d.index).chr(',').u64(d.offset).chr(',')
+     .str((d.engine_id == CVI_TPU_TIU) ? "tiu" : "tdma").chr(',')
+     .u64(d.layer_id).chr(',').str(op_name(d.op)).chr(',')
+     .u64(d.id).chr(',').u64(d.wait_id);
+
+  if (d.engine_id == CVI_TPU_TDMA)
+    for (uint32_t i = 0; i < nr_tiu_fields; i++)
+      out.chr(',');
+
+  for_each_field(chip, d, [&](const char *, uint64_t v) {
+    out.chr(',').u64(v);
+  });
+
+  if (d.engine_id == CVI_TPU_TIU)
+    for (uint32_t i = 0; i < nr_tdma_fields; i++)
+      out.chr(',');
+
+  out.chr('\n');
+}
+
+//
+// Layer summaries.
+//
+static void ops_text(out_t &out, const layer_stats_t &l, char sep)
+{
+  bool first = true;
+
+  for (uint32_t op = 0; op < NR_OPS; op++) {
+    if (!l.ops[op])
+      continue;
+    if (!first)
+      out.chr(sep);
+    out.str(op_name(op)).chr(':').u64(l.ops[op]);
+    first = false;
   }
 }
 
-static std::string bd_type(void *desc)
+static void report_text(out_t &out, const report_t &r)
 {
-  int dcr_type = desc_get_bd_dcr_type(desc);
-  CHECK_LT(dcr_type, NR_DCR_TYPES);
-
-  switch (dcr_type) {
-    case DCR_TYPE_CONV:
-      return std::string("CONV");
-    case DCR_TYPE_MD_SUM:
-      return std::string("MD_SUM");
-    case DCR_TYPE_MD_LINEAR:
-      return std::string("MD_LINEAR");
-    case DCR_TYPE_MD_SCALAR:
-      return std::string("MD_SCALAR ") + std::string(desc_get_md_scale_op(desc));
-    case DCR_TYPE_MD_SFU:
-      return std::string("MD_SFU");
-    case DCR_TYPE_MD_CMP:
-      return std::string("MD_CMP");
-    case DCR_TYPE_POOLING_FWD:
-      return std::string("MD_POOLING_FWD");
-    case DCR_TYPE_POOLING_BWD:
-      return std::string("MD_POOLING_BWD");
-    case DCR_TYPE_MATRIX_MULTIPLY:
-      return std::string("MATMUL");
-    case DCR_TYPE_IMAGE_SUM:
-      return std::string("IMG_SUM");
-    case DCR_TYPE_CONV_COEFF:
-      return std::string("CONV_COEFF");
-    case DCR_TYPE_CONV_COEFF_MAC:
-      return std::string("CONV_COEFF_MAC");
-    case DCR_TYPE_LMEM_ARRANGE:
-      return std::string("LMEM_ARRANGE");
-    case DCR_TYPE_TENSOR_ARITHMETIC:
-      return std::string("LMEM_ARITHMETIC");
-
-    default:
-      LOG(FATAL) << "Unknown BD dcr_type " << dcr_type;
+  out.str(r.dmabuf ? "dmabuf " : "cmdbuf ").str(chip_name(r.chip))
+     .str(", ").u64(r.size)
+     .str(" bytes, ").u64(r.nr_tiu).str(" tiu, ").u64(r.nr_tdma)
+     .str(" tdma, ").u64(r.nr_segments).str(" segments, ")
+     .u64(r.layers.size()).str(" layers");
+  if (r.has_pmu)
+    out.str(", ").u64(r.nr_pmu_events).str(" pmu records, ")
+       .u64(r.nr_pmu_unmatched).str(" unmatched");
+  out.str("\n\n");
+
+  out.str("   layer     tiu    tdma   dconv   waits   chain"
+          "         g2l         l2g         g2g         l2l");
+  if (r.has_pmu)
+    out.str("    tiu_busy   tdma_busy     overlap   ratio        span");
+  out.str("  ops\n");
+
+  for (const layer_stats_t &l : r.layers) {
+    out.u64(l.layer_id, 8).u64(l.nr_tiu, 8).u64(l.nr_tdma, 8)
+       .u64(l.nr_double_conv, 8).u64(l.nr_waits, 8).u64(l.wait_chain, 8);
+    for (uint32_t i = 0; i < 4; i++)
+      out.u64(l.tdma_bytes[i], 12);
+    if (r.has_pmu)
+      out.u64(l.tiu_busy, 12).u64(l.tdma_busy, 12).u64(l.overlap, 12)
+         .fixed(l.overlap_ratio, 8).u64(l.span, 12);
+    out.str("  ");
+    ops_text(out, l, ' ');
+
+    std::string name = layer_name(r, l.layer_id);
+    if (!name.empty())
+      out.str("  # ").str(name);
+    out.chr('\n');
   }
 }
 
-static void parse_cmdbuf(uint8_t *cmdbuf, size_t cmdbuf_size)
+static void report_json(out_t &out, const report_t &r, bool descs)
 {
-  uint32_t *buf = (uint32_t *)cmdbuf;
-  size_t i = 0;
-
-  while(i < cmdbuf_size / 4) {
-    cmd_hdr_t *hdr;
-    void *cmd;
-    hdr = (cmd_hdr_t *)(&buf[i]);
-#ifdef DETAILED_CMD
-     printf("magic:%d len: %d engine_id: %d node_id: %d"
-            "flags: %d mask: %d cmd[0]:%d\n", (int)hdr->magic, (int)cmd_hdr_len(hdr),
-            (int)hdr->engine_id, (int)hdr->__deprecated, (int)hdr->flags, (int)hdr->mask,
-            (int)hdr->cmd[0]);
-#endif
-    i += sizeof(cmd_hdr_t) / 4;
-    cmd = (void *)&buf[i];
-    uint32_t cmd_len = cmd_hdr_len(hdr) / 4;
-    uint64_t src, dst;
-    uint32_t bd_cmd_id = 0, gdma_cmd_id = 0;
-    desc_get_cmd_id(cmd, hdr->engine_id, cmd_len, bd_cmd_id, gdma_cmd_id);
-
-#ifdef DETAILED_CMD
-     uint32_t * c = (uint32_t *)cmd;
-#endif
-
-    switch (hdr->engine_id) {
-    case ENGINE_BD:
-      LOG(INFO) << "CMD [BD  ], <"
-                << bd_cmd_id << "," << gdma_cmd_id
-                << ">, len " << cmd_len << ", "
-                << bd_type(cmd);
-#ifdef DETAILED_CMD
-     for(size_t k = 0; k < cmd_len; k++)
-        LOG(INFO) << "[BD " << k << "]:" << std::hex << c[k];
-#endif
-      break;
-    case ENGINE_GDMA:
-      parse_gdma_operand_addr(cmd, src, dst);
-      LOG(INFO) << "CMD [GDMA], <"
-                << bd_cmd_id << "," << gdma_cmd_id
-                << ">, 0x" << std::hex << src
-                << " => 0x" << std::hex << dst
-                << ", len " << cmd_len;
-#ifdef DETAILED_CMD
-      for(size_t k = 0; k < cmd_len; k++)
-        LOG(INFO) << "[GDMA " << k << "]:" << std::hex << c[k];
-#endif
-      break;
-    case ENGINE_CPU:
-      LOG(INFO) << "CMD [ARM ], len " << cmd_len;
-#ifdef DETAILED_CMD
-      for(size_t k = 0; k < cmd_len; k++)
-        LOG(INFO) << "[CPU " << k << "]:" << std::hex << c[k];
-#endif
-      break;
-    default:
-      LOG(FATAL) << "UNKNOWN CMD, len " << cmd_len
-          << " ,engine_id " << (int)hdr->engine_id;
+  out.str(descs ? "],\n" : "{")
+     .str("\"chip\": \"").str(chip_name(r.chip))
+     .str("\", \"dmabuf\": ").str(r.dmabuf ? "true" : "false")
+     .str(", \"size\": ").u64(r.size)
+     .str(", \"nr_segments\": ").u64(r.nr_segments)
+     .str(", \"nr_tiu\": ").u64(r.nr_tiu)
+     .str(", \"nr_tdma\": ").u64(r.nr_tdma);
+  if (r.has_pmu)
+    out.str(", \"nr_pmu_events\": ").u64(r.nr_pmu_events)
+       .str(", \"nr_pmu_unmatched\": ").u64(r.nr_pmu_unmatched);
+  out.str(",\n\"layers\": [");
+
+  for (size_t i = 0; i < r.layers.size(); i++) {
+    const layer_stats_t &l = r.layers[i];
+
+    out.str(i ? ",\n" : "\n")
+       .str("{\"layer_id\": ").u64(l.layer_id)
+       .str(", \"name\": ").json_str(layer_name(r, l.layer_id))
+       .str(", \"nr_tiu\": ").u64(l.nr_tiu)
+       .str(", \"nr_tdma\": ").u64(l.nr_tdma)
+       .str(", \"nr_double_conv\": ").u64(l.nr_double_conv)
+       .str(", \"nr_waits\": ").u64(l.nr_waits)
+       .str(", \"wait_chain\": ").u64(l.wait_chain)
+       .str(", \"tdma_bytes\": {");
+    for (uint32_t dir = 0; dir < 4; dir++)
+      out.str(dir ? ", \"" : "\"").str(tdma_dir_name(dir)).str("\": ")
+         .u64(l.tdma_bytes[dir]);
+
+    out.str("}, \"ops\": {");
+    bool first = true;
+    for (uint32_t op = 0; op < NR_OPS; op++) {
+      if (!l.ops[op])
+        continue;
+      out.str(first ? "\"" : ", \"").str(op_name(op)).str("\": ")
+         .u64(l.ops[op]);
+      first = false;
     }
-    i += cmd_len;
+    out.chr('}');
+    if (r.has_pmu)
+      out.str(", \"pmu\": {\"nr_events\": ").u64(l.nr_pmu_events)
+         .str(", \"tiu_busy\": ").u64(l.tiu_busy)
+         .str(", \"tdma_busy\": ").u64(l.tdma_busy)
+         .str(", \"overlap\": ").u64(l.overlap)
+         .str(", \"overlap_ratio\": ").fixed(l.overlap_ratio)
+         .str(", \"span\": ").u64(l.span).chr('}');
+    out.chr('}');
+  }
+
+  out.str("\n]}\n");
+}
+
+static void report_csv(out_t &out, const report_t &r)
+{
+  out.str("layer_id,name,nr_tiu,nr_tdma,nr_double_conv,nr_waits,"
+          "wait_chain,g2l_bytes,l2g_bytes,g2g_bytes,l2l_bytes");
+  if (r.has_pmu)
+    out.str(",nr_pmu_events,tiu_busy,tdma_busy,overlap,overlap_ratio,span");
+  out.str(",ops\n");
+
+  for (const layer_stats_t &l : r.layers) {
+    out.u64(l.layer_id).chr(',').json_str(layer_name(r, l.layer_id))
+       .chr(',').u64(l.nr_tiu).chr(',').u64(l.nr_tdma)
+       .chr(',').u64(l.nr_double_conv).chr(',').u64(l.nr_waits)
+       .chr(',').u64(l.wait_chain);
+    for (uint32_t i = 0; i < 4; i++)
+      out.chr(',').u64(l.tdma_bytes[i]);
+    if (r.has_pmu)
+      out.chr(',').u64(l.nr_pmu_events).chr(',').u64(l.tiu_busy)
+         .chr(',').u64(l.tdma_busy).chr(',').u64(l.overlap)
+         .chr(',').fixed(l.overlap_ratio).chr(',').u64(l.span);
+    out.chr(',');
+    ops_text(out, l, ';');
+    out.chr('\n');
   }
 }
-#endif /* if defined(CHIP) && CHIP == BM1880v2*/
 
-int main (int argc, char *argv[])
+int main(int argc, char *argv[])
 {
-#if defined(CHIP) && CHIP == BM1880v2
-  char* layer_id_name_mapping_file_path = NULL;
-  char* output_file_path = NULL;
-  if (argc != 4 && argc != 2) {
-    printf("Usage: %s cmdbuf.bin <layer_id_name_mapping_file_path output_file_path>\n", argv[0]);
-    exit(1);
+  out_fmt_t fmt = FMT_TEXT;
+  bool descs = false;
+  const char *map_path = NULL, *pmu_path = NULL, *out_path = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:dm:p:o:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        if (!strcmp(optarg, "text")) {
+          fmt = FMT_TEXT;
+        } else if (!strcmp(optarg, "json")) {
+          fmt = FMT_JSON;
+        } else if (!strcmp(optarg, "csv")) {
+          fmt = FMT_CSV;
+        } else {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 'd':
+        descs = true;
+        break;
+      case 'm':
+        map_path = optarg;
+        break;
+      case 'p':
+        pmu_path = optarg;
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : 1;
+    }
   }
 
-  if (argc == 4) {
-    layer_id_name_mapping_file_path = argv[2];
-    output_file_path = argv[3];
+  if (optind != argc - 1) {
+    usage(argv[0]);
+    return 1;
   }
 
-  read_bm1880v2_cmd(argv[1], layer_id_name_mapping_file_path, output_file_path);
-#else
-  if (argc != 2) {
-    printf("Usage: %s cmdbuf.bin\n", argv[0]);
-    exit(1);
+  report_t r;
+  if (map_path && read_layer_map(map_path, r.names))
+    return 1;
+
+  mapped_file_t f;
+  if (map_file(argv[optind], &f))
+    return 1;
+
+  FILE *fp = out_path ? fopen(out_path, "w") : stdout;
+  if (!fp) {
+    fprintf(stderr, "cannot open %s\n", out_path);
+    unmap_file(&f);
+    return 1;
   }
 
-  std::fstream f_cmdbuf(argv[1], std::ios::in | std::ios::binary);
+  out_t out(fp);
+
+  // Layer of every descriptor and its longest wait run in that layer.
+  std::vector<int32_t> layer_index(1 << 16, -1);
+  std::vector<uint16_t> desc_layer;
+  std::vector<uint32_t> desc_chain;
+  uint32_t last[CVI_TPU_ENGINE_NUM] = {NO_DESC, NO_DESC, NO_DESC};
+  uint32_t nr_tiu_fields = 0, nr_tdma_fields = 0;
+
+  if (descs) {
+    chip_t chip = chip_of_buf(f.data, f.size);
+    if (chip != CHIP_UNKNOWN) {
+      nr_tiu_fields = nr_fields(chip, CVI_TPU_TIU);
+      nr_tdma_fields = nr_fields(chip, CVI_TPU_TDMA);
+      if (fmt == FMT_JSON)
+        out.str("{\"descs\": [\n");
+      else if (fmt == FMT_CSV)
+        dump_desc_csv_header(out, chip);
+    }
+  }
 
-  size_t cmdbuf_size = get_file_length(f_cmdbuf);
-  printf("cmdbuf size %zu\n", cmdbuf_size);
-  uint8_t *cmdbuf = new uint8_t[cmdbuf_size];
-  f_cmdbuf.read((char *)cmdbuf, cmdbuf_size);
-  //dump_hex("cmdbuf", cmdbuf, 16);
+  desc_layer.reserve(f.size / (sizeof(cmd_hdr_t) + TDMA_DESC_REG_BYTES));
+  desc_chain.reserve(desc_layer.capacity());
+
+  int nr_segments = desc_walk(f.data, f.size, &r.chip,
+                              [&](const cmdbuf_desc_t &d) {
+    uint32_t layer_id = d.layer_id & 0xffff;
+    if (layer_index[layer_id] < 0) {
+      layer_index[layer_id] = r.layers.size();
+      layer_stats_t l;
+      memset(&l, 0, sizeof(l));
+      l.layer_id = layer_id;
+      r.layers.push_back(l);
+    }
+    layer_stats_t &l = r.layers[layer_index[layer_id]];
 
-  parse_cmdbuf(cmdbuf, cmdbuf_size);
-#endif /* if CHIP == "BM1880v2"*/
+    if (d.engine_id == CVI_TPU_TIU) {
+      r.nr_tiu++;
+      l.nr_tiu++;
+      l.nr_double_conv += (d.op == OP_CONV && d.double_conv);
+    } else {
+      r.nr_tdma++;
+      l.nr_tdma++;
+      l.tdma_bytes[d.tdma_dir] += d.tdma_bytes;
+    }
+    l.ops[d.op]++;
+
+    // Waits chained through either engine, counted from the layer start.
+    uint32_t chain = 0, prev = last[d.engine_id];
+    if (prev != NO_DESC && desc_layer[prev] == layer_id)
+      chain = desc_chain[prev];
+    if (d.new_wait) {
+      uint32_t w = d.wait_desc;
+      uint32_t c = (w != NO_DESC && desc_layer[w] == layer_id) ?
+                   desc_chain[w] + 1 : 1;
+      chain = (c > chain) ? c : chain;
+      l.nr_waits++;
+    }
+    if (chain > l.wait_chain)
+      l.wait_chain = chain;
+
+    desc_layer.push_back(layer_id);
+    desc_chain.push_back(chain);
+    last[d.engine_id] = d.index;
+
+    if (descs) {
+      if (fmt == FMT_JSON)
+        dump_desc_json(out, r.chip, d);
+      else if (fmt == FMT_CSV)
+        dump_desc_csv(out, r.chip, d, nr_tiu_fields, nr_tdma_fields);
+      else
+        dump_desc_text(out, r.chip, d);
+    }
+  });
+
+  int ret = 0;
+  if (nr_segments < 0) {
+    ret = 1;
+  } else {
+    r.dmabuf = is_dmabuf(f.data, f.size);
+    r.size = f.size;
+    r.nr_segments = nr_segments;
+  }
 
-  return 0;
+  if (!ret && pmu_path && read_pmu(pmu_path, f, layer_index, r))
+    ret = 1;
+
+  if (!ret) {
+    // With -d, csv holds the descriptors only.
+    if (fmt == FMT_JSON)
+      report_json(out, r, descs);
+    else if (fmt == FMT_CSV && !descs)
+      report_csv(out, r);
+    else if (fmt == FMT_TEXT)
+      report_text(out, r);
+  }
+
+  out.flush();
+  if (ferror(fp) || (out_path && fclose(fp))) {
+    fprintf(stderr, "cannot write %s\n", out_path ? out_path : "stdout");
+    ret = 1;
+  }
+
+  unmap_file(&f);
+  return ret;
 }
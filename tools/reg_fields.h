@@ -0,0 +1,89 @@
+#ifndef READCMDBUF_REG_FIELDS_H
+#define READCMDBUF_REG_FIELDS_H
+
+/*
+ * Register fields of the tiu/tdma descriptors, in the order of the
+ * trace_tiu_reg()/trace_tdma_reg() dumps of the register headers.
+ * cv181x, cv180x and bm1822 share one layout.
+ */
+
+#define CV181X_TIU_FIELDS(X) \
+  X(cmd_en) X(cmd_end) X(cmd_id_en) X(cmd_keep) X(cmd_intr_en) X(tsk_typ) \
+  X(tsk_eu_typ) X(tsk_opd_num) X(opt_res_shift) X(opt_left_shift) \
+  X(opt_shift_typ) X(opt_rshift_typ) X(dummy1) X(opd_typ) X(opt_chl_quan) \
+  X(cmd_id_tpu) X(cmd_id_gdma) X(quan_m) X(opt_res0_sign) X(opt_opd0_sign) \
+  X(opt_opd1_sign) X(opt_opd2_sign) X(opt_res0_seg) X(opt_opd0_seg) \
+  X(opt_opd1_seg) X(opt_opd2_seg) X(ps32_md) X(double_conv) \
+  X(opt_left_tran) X(fp_round_typ) X(opt_relu_typ) X(opt_relu_value) \
+  X(cmd_pre_exe_typ) X(opt_res_add) X(rsvd0) X(conv_opd0_x_ins0) \
+  X(conv_opd0_y_ins0) X(conv_opd0_x_ins0_last) X(conv_opd0_y_ins0_last) \
+  X(conv_opd1_x_ins0) X(conv_opd1_y_ins0) X(dummy0) X(opd0_ins_val) \
+  X(conv_opd0_up_pad) X(conv_opd0_dn_pad) X(conv_opd0_lf_pad) \
+  X(conv_opd0_rt_pad) X(res0_n) X(res0_c) X(res0_h) X(res0_w) \
+  X(conv_op_x_str) X(conv_op_y_str) X(cmd_pre_exe) X(rsvd1) X(res0_addr) \
+  X(opd0_addr) X(opd1_addr) X(opd2_addr) X(opt_opd0_const) \
+  X(opt_opd1_const) X(opt_opd2_const) X(short_nchwstr_same) \
+  X(short_res0_str) X(short_opd0_str) X(short_opd1_str) X(short_opd2_str) \
+  X(dummy2) X(opd0_n) X(opd0_c) X(dummy3) X(rsvd2) X(opd0_h) X(opd0_w) \
+  X(opd1_n) X(opd1_c) X(opd1_h) X(opd1_w) X(opd2_n) X(opd2_c) X(opd2_h) \
+  X(opd2_w) X(dummy4) X(rsvd3) X(layer_info) X(res0_n_str) X(res0_c_str) \
+  X(res0_h_str) X(res0_w_str) X(res0_b_str) X(opd0_n_str) X(dummy5) \
+  X(rsvd4) X(opd0_c_str) X(opd0_h_str) X(opd0_w_str) X(opd0_b_str) \
+  X(opd1_n_str) X(opd1_c_str) X(opd1_h_str) X(dummy6) X(rsvd5) \
+  X(opd1_w_str) X(opd1_b_str) X(opd2_n_str) X(opd2_c_str) X(opd2_h_str) \
+  X(opd2_w_str) X(opd2_b_str) X(dummy7) X(rsvd6)
+
+#define CV181X_TDMA_FIELDS(X) \
+  X(vld) X(compress_en) X(eod) X(intp_en) X(bar_en) X(check_bf16_value) \
+  X(trans_dir) X(rsv00) X(trans_fmt) X(transpose_md) X(rsv01) \
+  X(intra_cmd_paral) X(outstanding_en) X(cmd_id) X(spec_func) X(dst_fmt) \
+  X(src_fmt) X(cmprs_fmt) X(sys_dtype) X(rsv2_1) X(int8_sign) \
+  X(compress_zero_guard) X(int8_rnd_mode) X(wait_id_tpu) \
+  X(wait_id_other_tdma) X(wait_id_sdma) X(const_val) X(src_base_reg_sel) \
+  X(mv_lut_idx) X(dst_base_reg_sel) X(mv_lut_base) X(rsv4_5) \
+  X(dst_h_stride) X(dst_c_stride_low) X(dst_n_stride) X(src_h_stride) \
+  X(src_c_stride_low) X(src_n_stride) X(dst_c) X(src_c) X(dst_w) X(dst_h) \
+  X(src_w) X(src_h) X(dst_base_addr_low) X(src_base_addr_low) X(src_n) \
+  X(dst_base_addr_high) X(src_base_addr_high) X(src_c_stride_high) \
+  X(dst_c_stride_high) X(compress_bias0) X(compress_bias1) X(layer_ID)
+
+#define BM1880V2_TIU_FIELDS(X) \
+  X(cmd_en) X(cmd_end) X(cmd_id_en) X(cmd_id_tpu) X(cmd_id_gdma) \
+  X(cmd_keep) X(cmd_intr_en) X(tsk_typ) X(tsk_eu_typ) X(tsk_opd_num) \
+  X(opt_right_shift) X(opt_left_shift) X(opt_shift_typ) X(opt_rshift_typ) \
+  X(opt_res_add) X(opt_relu) X(opt_left_tran) X(opt_chl_quan) X(tens_mdsum) \
+  X(tens_lookup) X(opt_res0_sign) X(opt_opd0_sign) X(opt_opd1_sign) \
+  X(opt_opd2_sign) X(opt_res0_int8) X(opt_opd0_int8) X(opt_opd1_int8) \
+  X(opt_opd2_int8) X(opt_opd0_const) X(opt_opd1_const) X(opt_opd2_const) \
+  X(short_nchwstr_same) X(short_res0_str) X(short_opd0_str) \
+  X(short_opd1_str) X(short_opd2_str) X(conv_opd0_x_ins0) \
+  X(conv_opd0_y_ins0) X(conv_opd0_x_ins0_last) X(conv_opd0_y_ins0_last) \
+  X(conv_opd1_x_ins0) X(conv_opd1_y_ins0) X(opd0_ins_val) X(ps32_md) \
+  X(double_conv) X(rsvd0) X(res0_n) X(res0_c) X(res0_h) X(res0_w) \
+  X(res0_addr) X(opd0_addr) X(opd1_addr) X(rsvd1) X(opd2_addr) X(opd0_c) \
+  X(opd0_h) X(opd0_w) X(opd1_h) X(opd1_w) X(conv_opd0_up_pad) \
+  X(conv_opd0_dn_pad) X(conv_opd0_lf_pad) X(conv_opd0_rt_pad) \
+  X(conv_op_x_str) X(conv_op_y_str) X(opd0_ins_fp) X(rsvd2) X(opd0_n) \
+  X(opd1_n) X(opd1_c) X(opd2_n) X(opd2_c) X(opd2_h) X(opd2_w) X(quan_m) \
+  X(opd_typ) X(fp_round_typ) X(rsvd7) X(rsvd3) X(res0_n_str) X(res0_c_str) \
+  X(res0_h_str) X(res0_w_str) X(res0_b_str) X(opd0_n_str) X(opd0_c_str) \
+  X(rsvd4) X(opd0_h_str) X(opd0_w_str) X(opd0_b_str) X(opd1_n_str) \
+  X(opd1_c_str) X(opd1_h_str) X(opd1_w_str) X(rsvd5) X(opd1_b_str) \
+  X(opd2_n_str) X(opd2_c_str) X(opd2_h_str) X(opd2_w_str) X(opd2_b_str) \
+  X(layer_info) X(rsvd6)
+
+#define BM1880V2_TDMA_FIELDS(X) \
+  X(vld) X(compress_en) X(eod) X(intp_en) X(bar_en) X(check_bf16_value) \
+  X(trans_dir) X(rsv00) X(trans_fmt) X(transpose_md) X(rsv01) \
+  X(outstanding_en) X(cmd_id) X(spec_func) X(dst_fmt) X(src_fmt) \
+  X(cmprs_fmt) X(sys_dtype) X(rsv2_1) X(int8_sign) X(compress_zero_guard) \
+  X(int8_rnd_mode) X(wait_id_tpu) X(wait_id_other_tdma) X(wait_id_sdma) \
+  X(const_val) X(src_base_reg_sel) X(mv_lut_idx) X(dst_base_reg_sel) \
+  X(mv_lut_base) X(rsv4_5) X(dst_h_stride) X(dst_c_stride_low) \
+  X(dst_n_stride) X(src_h_stride) X(src_c_stride_low) X(src_n_stride) \
+  X(dst_c) X(src_c) X(dst_w) X(dst_h) X(src_w) X(src_h) \
+  X(dst_base_addr_low) X(src_base_addr_low) X(src_n) X(dst_base_addr_high) \
+  X(src_base_addr_high) X(src_c_stride_high) X(dst_c_stride_high) \
+  X(compress_bias0) X(compress_bias1) X(layer_ID)
+
+#endif /* READCMDBUF_REG_FIELDS_H */
@@ -0,0 +1,14 @@
+# Run readcmdbuf with ARGS and compare its output with EXPECTED.
+separate_arguments(ARGS)
+execute_process(
+  COMMAND ${READCMDBUF} ${ARGS}
+  OUTPUT_VARIABLE out
+  RESULT_VARIABLE ret)
+if (NOT ret EQUAL 0)
+  message(FATAL_ERROR "readcmdbuf failed: ${ret}")
+endif()
+
+file(READ ${EXPECTED} expected)
+if (NOT out STREQUAL expected)
+  message(FATAL_ERROR "report differs from ${EXPECTED}:\n${out}")
+endif()